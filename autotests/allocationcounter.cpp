@@ -0,0 +1,119 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+/*
+ * Preloaded into plasma-keyboard by keyallocationtest.
+ *
+ * Counts the heap allocations made while a thread is inside an
+ * AllocationScope and publishes the count through a file shared with the
+ * test, named by PLASMA_KEYBOARD_ALLOCATION_COUNTER.
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+}
+
+namespace
+{
+
+std::atomic<uint64_t> *s_counter = nullptr;
+
+// initial-exec keeps TLS access itself from allocating.
+__attribute__((tls_model("initial-exec"))) thread_local int t_depth = 0;
+
+void count()
+{
+    if (t_depth > 0 && s_counter) {
+        s_counter->fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+__attribute__((constructor)) void mapCounter()
+{
+    const char *path = getenv("PLASMA_KEYBOARD_ALLOCATION_COUNTER");
+    if (!path) {
+        return;
+    }
+    const int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    void *memory = mmap(nullptr, sizeof(std::atomic<uint64_t>), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory != MAP_FAILED) {
+        s_counter = static_cast<std::atomic<uint64_t> *>(memory);
+    }
+}
+
+} // namespace
+
+extern "C" {
+
+__attribute__((visibility("default"))) void plasma_keyboard_allocation_scope_enter()
+{
+    ++t_depth;
+}
+
+__attribute__((visibility("default"))) void plasma_keyboard_allocation_scope_leave()
+{
+    --t_depth;
+}
+
+__attribute__((visibility("default"))) void *malloc(size_t size) noexcept
+{
+    count();
+    return __libc_malloc(size);
+}
+
+__attribute__((visibility("default"))) void *calloc(size_t count_, size_t size) noexcept
+{
+    count();
+    return __libc_calloc(count_, size);
+}
+
+__attribute__((visibility("default"))) void *realloc(void *ptr, size_t size) noexcept
+{
+    count();
+    return __libc_realloc(ptr, size);
+}
+
+__attribute__((visibility("default"))) void *memalign(size_t alignment, size_t size) noexcept
+{
+    count();
+    return __libc_memalign(alignment, size);
+}
+
+__attribute__((visibility("default"))) void *aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    count();
+    return __libc_memalign(alignment, size);
+}
+
+__attribute__((visibility("default"))) int posix_memalign(void **result, size_t alignment, size_t size) noexcept
+{
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    count();
+    void *ptr = __libc_memalign(alignment, size);
+    if (!ptr && size) {
+        return ENOMEM;
+    }
+    *result = ptr;
+    return 0;
+}
+
+} // extern "C"
@@ -0,0 +1,133 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "candidateusagestore.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QStandardPaths>
+#include <QTest>
+
+using namespace Qt::StringLiterals;
+
+/**
+ * Checks the candidate counters of CandidateUsageStore and the order they give.
+ */
+class CandidateUsageStoreTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);
+    }
+
+    void init()
+    {
+        KSharedConfig::Ptr config = KSharedConfig::openStateConfig(u"plasmakeyboardstaterc"_s);
+        config->deleteGroup(u"test"_s);
+        config->sync();
+    }
+
+    void testCount()
+    {
+        CandidateUsageStore store(u"test"_s);
+        QVERIFY(!store.hasCounts(u"e"_s));
+        QCOMPARE(store.count(u"e"_s, u"é"), 0u);
+
+        store.record(u"e"_s, u"é"_s);
+        store.record(u"e"_s, u"é"_s);
+        store.record(u"e"_s, u"è"_s);
+        QVERIFY(store.hasCounts(u"e"_s));
+        QCOMPARE(store.count(u"e"_s, u"é"), 2u);
+        QCOMPARE(store.count(u"e"_s, u"è"), 1u);
+        QCOMPARE(store.count(u"e"_s, u"ê"), 0u);
+        QVERIFY(!store.hasCounts(u"a"_s));
+    }
+
+    void testOrder()
+    {
+        const QStringList candidates = {u"é"_s, u"è"_s, u"ê"_s, u"ë"_s};
+
+        CandidateUsageStore store(u"test"_s);
+        QVERIFY(store.order(u"e"_s, candidates).isEmpty());
+
+        store.record(u"e"_s, u"ê"_s);
+        for (int i = 0; i < 3; ++i) {
+            store.record(u"e"_s, u"è"_s);
+        }
+        store.record(u"e"_s, u"ë"_s);
+
+        // Most picked first; the tie between ê and ë and the unpicked é keep
+        // their order.
+        const QVarLengthArray<quint16, 16> expected = {1, 2, 3, 0};
+        QCOMPARE(store.order(u"e"_s, candidates), expected);
+
+        // Candidates picked for another key do not count.
+        QVERIFY(store.order(u"a"_s, candidates).isEmpty());
+    }
+
+    void testDecay()
+    {
+        CandidateUsageStore store(u"test"_s);
+        store.record(u"e"_s, u"è"_s);
+        for (int i = 0; i < 10; ++i) {
+            store.record(u"e"_s, u"ê"_s);
+        }
+        for (int i = 0; i < 999; ++i) {
+            store.record(u"e"_s, u"é"_s);
+        }
+        QCOMPARE(store.count(u"e"_s, u"é"), 999u);
+
+        // Reaching 1000 halves every counter of the key, keeping their order.
+        store.record(u"e"_s, u"é"_s);
+        QCOMPARE(store.count(u"e"_s, u"é"), 500u);
+        QCOMPARE(store.count(u"e"_s, u"ê"), 5u);
+        QCOMPARE(store.count(u"e"_s, u"è"), 0u);
+
+        const QVarLengthArray<quint16, 16> expected = {1, 2, 0};
+        QCOMPARE(store.order(u"e"_s, QStringList{u"è"_s, u"é"_s, u"ê"_s}), expected);
+    }
+
+    void testPersistence()
+    {
+        {
+            CandidateUsageStore store(u"test"_s);
+            store.record(u"e"_s, u"é"_s);
+            store.record(u"a"_s, u"à"_s);
+            store.flush();
+
+            // Written when the store goes away.
+            store.record(u"e"_s, u"é"_s);
+        }
+
+        CandidateUsageStore store(u"test"_s);
+        QCOMPARE(store.count(u"e"_s, u"é"), 2u);
+        QCOMPARE(store.count(u"a"_s, u"à"), 1u);
+
+        // Other groups, e.g. of another trigger, are separate.
+        CandidateUsageStore other(u"other"_s);
+        QVERIFY(!other.hasCounts(u"e"_s));
+    }
+
+    void testDecayedCountersAreDropped()
+    {
+        {
+            CandidateUsageStore store(u"test"_s);
+            store.record(u"e"_s, u"è"_s);
+            for (int i = 0; i < 1000; ++i) {
+                store.record(u"e"_s, u"é"_s);
+            }
+            QCOMPARE(store.count(u"e"_s, u"è"), 0u);
+        }
+
+        const KConfigGroup group = KSharedConfig::openStateConfig(u"plasmakeyboardstaterc"_s)->group(u"test"_s).group(u"e"_s);
+        QCOMPARE(group.keyList(), QStringList{u"é"_s});
+    }
+};
+
+QTEST_GUILESS_MAIN(CandidateUsageStoreTest)
+
+#include "candidateusagestoretest.moc"
@@ -0,0 +1,116 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "cursortextwindow.h"
+
+#include <QTest>
+
+using namespace Qt::StringLiterals;
+
+/**
+ * Checks how CursorTextWindow classifies surrounding-text updates.
+ */
+class CursorTextWindowTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testFirstUpdateReplaces()
+    {
+        CursorTextWindow window;
+        QCOMPARE(window.update(u"Hello"_s, 5, 5), CursorTextWindow::Change::Replaced);
+        QCOMPARE(window.beforeCursor(), u"Hello"_s);
+    }
+
+    void testRepeatedUpdateIsUnchanged()
+    {
+        CursorTextWindow window;
+        window.update(u"Hello world"_s, 5, 5);
+        QCOMPARE(window.update(u"Hello world"_s, 5, 5), CursorTextWindow::Change::None);
+        QCOMPARE(window.beforeCursor(), u"Hello"_s);
+    }
+
+    void testTypingInserts()
+    {
+        CursorTextWindow window;
+        window.update(u"Moo :co"_s, 7, 7);
+        QCOMPARE(window.update(u"Moo :cow"_s, 8, 8), CursorTextWindow::Change::Inserted);
+        QCOMPARE(window.beforeCursor(), u"Moo :cow"_s);
+
+        // Several characters at once, e.g. a forwarded key typing a cluster.
+        QCOMPARE(window.update(u"Moo :cow🐮"_s, 10, 10), CursorTextWindow::Change::Inserted);
+        QCOMPARE(window.beforeCursor(), u"Moo :cow🐮"_s);
+    }
+
+    void testDeletingRepeatedCharacterReplaces()
+    {
+        CursorTextWindow window;
+        window.update(u"aaaaaaaaaa"_s, 10, 10);
+        QCOMPARE(window.update(u"aaaaaaaaa"_s, 9, 9), CursorTextWindow::Change::Replaced);
+        QCOMPARE(window.beforeCursor(), u"aaaaaaaaa"_s);
+    }
+
+    void testDeletingRepeatedCharacterBeyondWindowReplaces()
+    {
+        // Both are cut to the same window of the text before the cursor.
+        CursorTextWindow window;
+        window.update(QString(100, u'a'), 100, 100);
+        QCOMPARE(window.update(QString(99, u'a'), 99, 99), CursorTextWindow::Change::Replaced);
+    }
+
+    void testTypingRepeatedCharacterInserts()
+    {
+        CursorTextWindow window;
+        window.update(QString(100, u'a'), 100, 100);
+        QCOMPARE(window.update(QString(101, u'a'), 101, 101), CursorTextWindow::Change::Inserted);
+    }
+
+    void testShiftedWindowInserts()
+    {
+        // Some clients only report a window of the text that moves along
+        // with the cursor, which then stays at the same position.
+        CursorTextWindow window;
+        window.update(u"the quick brown fox"_s, 19, 19);
+        QCOMPARE(window.update(u"he quick brown foxe"_s, 19, 19), CursorTextWindow::Change::Inserted);
+        QCOMPARE(window.beforeCursor(), u"the quick brown foxe"_s);
+    }
+
+    void testCursorMoveReplaces()
+    {
+        CursorTextWindow window;
+        window.update(u"Hello world"_s, 11, 11);
+        QCOMPARE(window.update(u"Hello world"_s, 5, 5), CursorTextWindow::Change::Replaced);
+        QCOMPARE(window.beforeCursor(), u"Hello"_s);
+    }
+
+    void testSelectionUsesTextBeforeIt()
+    {
+        CursorTextWindow window;
+        QCOMPARE(window.update(u"Hello world"_s, 11, 6), CursorTextWindow::Change::Replaced);
+        QCOMPARE(window.beforeCursor(), u"Hello "_s);
+    }
+
+    void testEditsAreKnown()
+    {
+        CursorTextWindow window;
+        window.update(u"Moo :cow"_s, 8, 8);
+        window.edit(4, u"🐮");
+        QCOMPARE(window.beforeCursor(), u"Moo 🐮"_s);
+
+        // The client reporting the result of the edit changes nothing.
+        QCOMPARE(window.update(u"Moo 🐮"_s, 6, 6), CursorTextWindow::Change::None);
+    }
+
+    void testReset()
+    {
+        CursorTextWindow window;
+        window.update(u"Hello"_s, 5, 5);
+        window.reset();
+        QVERIFY(window.beforeCursor().isEmpty());
+        QCOMPARE(window.update(u"Hello"_s, 5, 5), CursorTextWindow::Change::Replaced);
+    }
+};
+
+QTEST_GUILESS_MAIN(CursorTextWindowTest)
+
+#include "cursortextwindowtest.moc"
@@ -0,0 +1,252 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "diacriticsindex.h"
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <cstring>
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+
+constexpr quint64 FINGERPRINT = 0x1234'5678'9abc'def0;
+
+// Byte offsets into the on-disk layout, see diacriticsindex.cpp.
+constexpr qsizetype HEADER_SIZE = 32;
+constexpr qsizetype KEY_ENTRY_SIZE = 12;
+
+QHash<QString, QStringList> testMap()
+{
+    return {
+        {u"e"_s, {u"é"_s, u"è"_s, u"ê"_s, u"ë"_s}},
+        {u"a"_s, {u"à"_s, u"á"_s}},
+        // A combining sequence and a supplementary-plane base.
+        {u"ñ"_s, {u"ñ"_s}},
+        {u"👍"_s, {u"👍🏻"_s, u"👍🏿"_s}},
+    };
+}
+
+void verifyLookups(const DiacriticsIndex &index)
+{
+    QVERIFY(index.isValid());
+    QCOMPARE(index.fingerprint(), FINGERPRINT);
+
+    QVERIFY(index.contains(u"e"));
+    QCOMPARE(index.candidates(u"e"), QStringList({u"é"_s, u"è"_s, u"ê"_s, u"ë"_s}));
+    QCOMPARE(index.candidates(u"a"), QStringList({u"à"_s, u"á"_s}));
+    QCOMPARE(index.candidates(u"ñ"), QStringList({u"ñ"_s}));
+    QCOMPARE(index.candidates(u"👍"), QStringList({u"👍🏻"_s, u"👍🏿"_s}));
+
+    QVERIFY(!index.contains(u"x"));
+    QVERIFY(!index.contains(u"n"));
+    QVERIFY(!index.contains(QStringView()));
+    QVERIFY(index.candidates(u"x").isEmpty());
+
+    const DiacriticsIndex::CandidateList list = index.candidateList(u"a");
+    QCOMPARE(list.size(), 2);
+    QCOMPARE(list.at(1), u"á");
+}
+
+bool writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+template<typename T>
+void patch(QByteArray &data, qsizetype offset, T value)
+{
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+} // namespace
+
+/**
+ * Checks building DiacriticsIndex, writing it to a file and mapping it back.
+ */
+class DiacriticsIndexTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testBuild()
+    {
+        verifyLookups(DiacriticsIndex::build(testMap(), FINGERPRINT));
+    }
+
+    void testEmpty()
+    {
+        const DiacriticsIndex index = DiacriticsIndex::build({}, FINGERPRINT);
+        QVERIFY(index.isValid());
+        QVERIFY(!index.contains(u"e"));
+
+        QVERIFY(!DiacriticsIndex().isValid());
+        QCOMPARE(DiacriticsIndex().fingerprint(), quint64(0));
+    }
+
+    void testOversized_data()
+    {
+        QTest::addColumn<QString>("key");
+        QTest::addColumn<QStringList>("candidates");
+
+        QTest::newRow("long key") << QString(0x10000, u'x') << QStringList({u"y"_s});
+        QStringList manyCandidates;
+        for (int i = 0; i < 0x10000; ++i) {
+            manyCandidates.append(u"y"_s);
+        }
+        QTest::newRow("many candidates") << u"x"_s << manyCandidates;
+    }
+
+    void testOversized()
+    {
+        QFETCH(QString, key);
+        QFETCH(QStringList, candidates);
+
+        QHash<QString, QStringList> map = testMap();
+        map.insert(key, candidates);
+
+        // Skipped with a warning instead of being stored with truncated lengths.
+        QTest::ignoreMessage(QtWarningMsg, QRegularExpression(u"DiacriticsIndex: Skipping oversized entry"_s));
+        const DiacriticsIndex index = DiacriticsIndex::build(map, FINGERPRINT);
+        verifyLookups(index);
+        QVERIFY(!index.contains(key));
+    }
+
+    void testRoundTrip()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath(u"index"_s);
+        QVERIFY(writeFile(path, DiacriticsIndex::build(testMap(), FINGERPRINT).data()));
+
+        const DiacriticsIndex index = DiacriticsIndex::open(path);
+        verifyLookups(index);
+    }
+
+    void testOpenMissingFile()
+    {
+        QTemporaryDir dir;
+        QVERIFY(!DiacriticsIndex::open(dir.filePath(u"missing"_s)).isValid());
+    }
+
+    void testTruncated_data()
+    {
+        QTest::addColumn<qsizetype>("size");
+
+        const qsizetype fullSize = DiacriticsIndex::build(testMap(), FINGERPRINT).data().size();
+        QTest::newRow("empty") << qsizetype(0);
+        QTest::newRow("magic only") << qsizetype(4);
+        QTest::newRow("partial header") << HEADER_SIZE - 4;
+        QTest::newRow("header only") << HEADER_SIZE;
+        QTest::newRow("partial pool") << fullSize - 2;
+    }
+
+    void testTruncated()
+    {
+        QFETCH(qsizetype, size);
+
+        QTemporaryDir dir;
+        const QString path = dir.filePath(u"index"_s);
+        QVERIFY(writeFile(path, DiacriticsIndex::build(testMap(), FINGERPRINT).data().left(size)));
+
+        QVERIFY(!DiacriticsIndex::open(path).isValid());
+    }
+
+    void testCorrupt_data()
+    {
+        QTest::addColumn<qsizetype>("offset");
+        QTest::addColumn<quint32>("value");
+        QTest::addColumn<int>("width");
+
+        // Four keys, so the candidate entries start after four key entries.
+        const qsizetype firstCandidate = HEADER_SIZE + 4 * KEY_ENTRY_SIZE;
+        QTest::newRow("magic") << qsizetype(0) << quint32(0x12345678) << 4;
+        QTest::newRow("version") << qsizetype(4) << quint32(1) << 4;
+        QTest::newRow("key count") << qsizetype(16) << quint32(5) << 4;
+        QTest::newRow("pool size") << qsizetype(24) << quint32(0xffff) << 4;
+        QTest::newRow("key offset") << HEADER_SIZE << quint32(0xffff) << 4;
+        QTest::newRow("empty key") << HEADER_SIZE + 4 << quint32(0) << 2;
+        QTest::newRow("candidate range") << HEADER_SIZE + 6 << quint32(0xff) << 2;
+        QTest::newRow("first candidate") << HEADER_SIZE + 8 << quint32(100) << 4;
+        QTest::newRow("candidate offset") << firstCandidate << quint32(0xffff) << 4;
+        QTest::newRow("candidate length") << firstCandidate + 4 << quint32(0xffff) << 4;
+    }
+
+    void testCorrupt()
+    {
+        QFETCH(qsizetype, offset);
+        QFETCH(quint32, value);
+        QFETCH(int, width);
+
+        QByteArray data = DiacriticsIndex::build(testMap(), FINGERPRINT).data();
+        if (width == 2) {
+            patch(data, offset, quint16(value));
+        } else {
+            patch(data, offset, value);
+        }
+
+        QTemporaryDir dir;
+        const QString path = dir.filePath(u"index"_s);
+        QVERIFY(writeFile(path, data));
+
+        QVERIFY(!DiacriticsIndex::open(path).isValid());
+    }
+
+    void testUnsortedKeys()
+    {
+        // Swap the first two key entries, which breaks the binary search.
+        QByteArray data = DiacriticsIndex::build(testMap(), FINGERPRINT).data();
+        const QByteArray first = data.mid(HEADER_SIZE, KEY_ENTRY_SIZE);
+        data.replace(HEADER_SIZE, KEY_ENTRY_SIZE, data.mid(HEADER_SIZE + KEY_ENTRY_SIZE, KEY_ENTRY_SIZE));
+        data.replace(HEADER_SIZE + KEY_ENTRY_SIZE, KEY_ENTRY_SIZE, first);
+
+        QTemporaryDir dir;
+        const QString path = dir.filePath(u"index"_s);
+        QVERIFY(writeFile(path, data));
+
+        QVERIFY(!DiacriticsIndex::open(path).isValid());
+    }
+
+    void testCached()
+    {
+        QTemporaryDir dir;
+        const QString path = dir.filePath(u"cache/diacritics/index"_s);
+
+        int builds = 0;
+        const auto build = [&builds](quint64 fingerprint) {
+            return [&builds, fingerprint] {
+                ++builds;
+                return DiacriticsIndex::build(testMap(), fingerprint);
+            };
+        };
+
+        // Built and written on first use.
+        verifyLookups(DiacriticsIndex::cached(path, FINGERPRINT, build(FINGERPRINT)));
+        QCOMPARE(builds, 1);
+        QVERIFY(QFile::exists(path));
+
+        // Mapped from the cache afterwards.
+        verifyLookups(DiacriticsIndex::cached(path, FINGERPRINT, build(FINGERPRINT)));
+        QCOMPARE(builds, 1);
+
+        // Rebuilt once the data files change.
+        QCOMPARE(DiacriticsIndex::cached(path, FINGERPRINT + 1, build(FINGERPRINT + 1)).fingerprint(), FINGERPRINT + 1);
+        QCOMPARE(builds, 2);
+
+        // Rebuilt if the cache file is damaged.
+        QVERIFY(writeFile(path, QByteArray(100, 'x')));
+        verifyLookups(DiacriticsIndex::cached(path, FINGERPRINT, build(FINGERPRINT)));
+        QCOMPARE(builds, 3);
+        QCOMPARE(DiacriticsIndex::open(path).fingerprint(), FINGERPRINT);
+    }
+};
+
+QTEST_GUILESS_MAIN(DiacriticsIndexTest)
+
+#include "diacriticsindextest.moc"
@@ -0,0 +1,120 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "mockcompositor.h"
+
+#include <QTemporaryFile>
+
+#include <array>
+#include <atomic>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace
+{
+
+// Letters without long-press alternates, so that no hold timer is started,
+// plus keys that type nothing.
+constexpr std::array<int, 11> KEYS = {KEY_B, KEY_F, KEY_J, KEY_Q, KEY_V, KEY_W, KEY_SPACE, KEY_LEFT, KEY_RIGHT, KEY_UP, KEY_DOWN};
+
+constexpr int ROUNDS = 20;
+
+} // namespace
+
+/**
+ * Checks that typing on the physical keyboard does not allocate.
+ *
+ * plasma-keyboard is started with allocationcounter preloaded, which counts
+ * the heap allocations made inside an AllocationScope, i.e. while a key is
+ * looked up and handled. Sending keys to the client is not part of it, as
+ * libwayland allocates a closure for every request.
+ */
+class KeyAllocationTest : public MockCompositorTestBase
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        setUpHome();
+
+        {
+            KConfig cfg(QStringLiteral("plasmakeyboardrc"));
+            KConfigGroup grp(&cfg, QStringLiteral("General"));
+            // Keep diacritics enabled so that the keyboard is grabbed and every
+            // key goes through the overlay controller.
+            grp.writeEntry(QStringLiteral("diacriticsHoldThresholdMs"), 1500);
+        }
+
+        QVERIFY(m_counterFile.open());
+        QVERIFY(m_counterFile.resize(sizeof(std::atomic<uint64_t>)));
+        const int fd = ::open(QFile::encodeName(m_counterFile.fileName()).constData(), O_RDONLY | O_CLOEXEC);
+        QVERIFY(fd >= 0);
+        void *memory = mmap(nullptr, sizeof(std::atomic<uint64_t>), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        QVERIFY(memory != MAP_FAILED);
+        m_counter = static_cast<const std::atomic<uint64_t> *>(memory);
+
+        m_childEnvironment.insert(u"LD_PRELOAD"_s, QStringLiteral(ALLOCATION_COUNTER_PATH));
+        m_childEnvironment.insert(u"PLASMA_KEYBOARD_ALLOCATION_COUNTER"_s, m_counterFile.fileName());
+
+        startCompositor();
+    }
+
+    void cleanupTestCase()
+    {
+        stopCompositor();
+        if (m_counter) {
+            munmap(const_cast<std::atomic<uint64_t> *>(m_counter), sizeof(std::atomic<uint64_t>));
+        }
+    }
+
+    void testKeysDoNotAllocate()
+    {
+        // Lazily initialised state, e.g. the keymap cache, may allocate once.
+        typeKeys(1);
+        const uint64_t before = m_counter->load();
+
+        typeKeys(ROUNDS);
+
+        const uint64_t allocations = m_counter->load() - before;
+        qInfo() << "allocations for" << ROUNDS * KEYS.size() * 2 << "key events:" << allocations;
+        QCOMPARE(allocations, uint64_t(0));
+    }
+
+private:
+    /**
+     * Type every key of KEYS @p rounds times and wait until the client
+     * received all of them.
+     */
+    void typeKeys(int rounds)
+    {
+        auto *context = m_inputMethod->context();
+        QVERIFY(context);
+        auto *keyboard = context->keyboard();
+        QVERIFY(keyboard);
+
+        QSignalSpy keySpy(context, &InputMethodContext::keyReceived);
+        int expected = 0;
+        for (int round = 0; round < rounds; ++round) {
+            for (const int key : KEYS) {
+                keyboard->sendKey(key, WL_KEYBOARD_KEY_STATE_PRESSED);
+                keyboard->sendKey(key, WL_KEYBOARD_KEY_STATE_RELEASED);
+                expected += 2;
+            }
+            wl_display_flush_clients(m_compositor->display());
+            QTest::qWait(1);
+        }
+
+        QTRY_COMPARE_WITH_TIMEOUT(keySpy.count(), expected, RUNNING_IN_CI ? 10000 : 5000);
+    }
+
+    QTemporaryFile m_counterFile;
+    const std::atomic<uint64_t> *m_counter = nullptr;
+};
+
+QTEST_MAIN(KeyAllocationTest)
+
+#include "keyallocationtest.moc"
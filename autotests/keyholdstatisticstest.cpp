@@ -0,0 +1,110 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "keyholdstatistics.h"
+
+#include <QTest>
+
+/**
+ * Checks the hold duration distribution kept by KeyHoldStatistics.
+ */
+class KeyHoldStatisticsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testTooFewSamples()
+    {
+        KeyHoldStatistics statistics;
+        for (int i = 0; i < KeyHoldStatistics::kMinSampleCount - 1; ++i) {
+            statistics.recordHold(80);
+        }
+        QCOMPARE(statistics.percentile(50), -1);
+
+        statistics.recordHold(80);
+        QCOMPARE(statistics.percentile(50), 80);
+    }
+
+    void testPercentile()
+    {
+        // Recorded out of order.
+        KeyHoldStatistics statistics;
+        for (int i = 0; i < 100; ++i) {
+            statistics.recordHold((i * 37) % 100 + 1);
+        }
+        QCOMPARE(statistics.sampleCount(), 100);
+
+        QCOMPARE(statistics.percentile(0), 1);
+        QCOMPARE(statistics.percentile(1), 1);
+        QCOMPARE(statistics.percentile(50), 50);
+        QCOMPARE(statistics.percentile(90), 90);
+        QCOMPARE(statistics.percentile(99), 99);
+        QCOMPARE(statistics.percentile(100), 100);
+    }
+
+    void testPercentileRoundsUp()
+    {
+        // With 40 samples, the 95th percentile is the 38th smallest.
+        KeyHoldStatistics statistics;
+        for (int i = 1; i <= 40; ++i) {
+            statistics.recordHold(i);
+        }
+        QCOMPARE(statistics.percentile(95), 38);
+    }
+
+    void testNewSampleInvalidatesCache()
+    {
+        KeyHoldStatistics statistics;
+        for (int i = 0; i < KeyHoldStatistics::kMinSampleCount; ++i) {
+            statistics.recordHold(10);
+        }
+        QCOMPARE(statistics.percentile(100), 10);
+
+        statistics.recordHold(500);
+        QCOMPARE(statistics.percentile(100), 500);
+    }
+
+    void testOldSamplesAreReplaced()
+    {
+        KeyHoldStatistics statistics;
+        for (int i = 0; i < KeyHoldStatistics::kSampleCount; ++i) {
+            statistics.recordHold(1000);
+        }
+        for (int i = 0; i < KeyHoldStatistics::kSampleCount - 1; ++i) {
+            statistics.recordHold(20);
+        }
+        QCOMPARE(statistics.sampleCount(), KeyHoldStatistics::kSampleCount);
+        QCOMPARE(statistics.percentile(99), 20);
+        QCOMPARE(statistics.percentile(100), 1000);
+
+        statistics.recordHold(20);
+        QCOMPARE(statistics.percentile(100), 20);
+    }
+
+    void testLongHoldsAreIgnored()
+    {
+        KeyHoldStatistics statistics;
+        statistics.recordHold(5000);
+        statistics.recordHold(-1);
+        QCOMPARE(statistics.sampleCount(), 0);
+    }
+
+    void testPressAndRelease()
+    {
+        KeyHoldStatistics statistics;
+        statistics.keyPressed(30);
+        statistics.keyPressed(31);
+        statistics.keyReleased(30);
+        QCOMPARE(statistics.sampleCount(), 1);
+
+        // Discarded holds and releases without a press are not recorded.
+        statistics.discard(31);
+        statistics.keyReleased(31);
+        statistics.keyReleased(32);
+        QCOMPARE(statistics.sampleCount(), 1);
+    }
+};
+
+QTEST_GUILESS_MAIN(KeyHoldStatisticsTest)
+
+#include "keyholdstatisticstest.moc"
@@ -1,525 +1,9 @@
 // SPDX-FileCopyrightText: 2026 Aleix Pol <aleixpol@kde.org>
 // SPDX-License-Identifier: GPL-2.0-or-later
 
-#include <KConfig>
-#include <KConfigGroup>
-#include <QCoreApplication>
-#include <QDir>
-#include <QElapsedTimer>
-#include <QGuiApplication>
-#include <QProcess>
-#include <QProcessEnvironment>
-#include <QSignalSpy>
-#include <QTemporaryDir>
-#include <QTimer>
-#include <QWindow>
-#include <QtTest/QTest>
-
-#include <memory>
-
-#include <QtWaylandCompositor/QWaylandCompositor>
-#include <QtWaylandCompositor/QWaylandCompositorExtension>
-#include <QtWaylandCompositor/QWaylandCompositorExtensionTemplate>
-#include <QtWaylandCompositor/QWaylandOutput>
-#include <QtWaylandCompositor/QWaylandOutputMode>
-#include <QtWaylandCompositor/QWaylandSeat>
-#include <QtWaylandCompositor/QWaylandSurface>
-#include <QtWaylandCompositor/QWaylandXdgShell>
-#include <private/qxkbcommon_p.h>
-
-#include "mockinputmethodcompositor_config.h"
-#include "qwayland-server-input-method-unstable-v1.h"
-#include "qwayland-server-wayland.h"
-
-#include <fcntl.h>
-#include <linux/input-event-codes.h>
-#include <sys/mman.h>
-#include <unistd.h>
-#include <xkbcommon/xkbcommon-compose.h>
-
-#define PLASMA_KEYBOARD_UNDER_GDB 0
-
-using namespace Qt::StringLiterals;
-
-/**
- * Whether we are running in a CI environment or not.
- *
- * This is used to adjust timing and wait durations in tests, as CI environments can have unpredictable timing.
- */
-static const bool RUNNING_IN_CI = qEnvironmentVariableIsSet("CI");
-
-static int createAnonymousKeymapFile(off_t size)
-{
-    int fd = -1;
-#ifdef MFD_CLOEXEC
-    fd = memfd_create("plasma-keyboard-keymap", MFD_CLOEXEC);
-    if (fd >= 0) {
-        if (ftruncate(fd, size) != 0) {
-            close(fd);
-            return -1;
-        }
-        return fd;
-    }
-#endif
-    char name[] = "/tmp/plasma-keyboard-keymap-XXXXXX";
-    fd = mkstemp(name);
-    if (fd < 0) {
-        return -1;
-    }
-    unlink(name);
-    if (ftruncate(fd, size) != 0) {
-        close(fd);
-        return -1;
-    }
-    return fd;
-}
-
-class InputMethodKeyboard : public QObject, public QtWaylandServer::wl_keyboard
-{
-    Q_OBJECT
-public:
-    InputMethodKeyboard(wl_client *client, uint32_t id, int version)
-        : QtWaylandServer::wl_keyboard(client, id, version)
-    {
-        initializeKeymap();
-        m_timer.start();
-    }
-
-    void setFocusSurface(wl_resource *surface)
-    {
-        if (!surface || m_focusSurface == surface) {
-            return;
-        }
-        m_focusSurface = surface;
-        send_enter(++m_serial, m_focusSurface, QByteArray());
-    }
-
-    void sendKey(uint32_t key, uint32_t state)
-    {
-        send_key(++m_serial, static_cast<uint32_t>(m_timer.elapsed()), key, state);
-    }
-
-    bool keymapped() const
-    {
-        return m_keymapped;
-    }
-
-    /**
-     * Sets an updated XKB keymap built from the given layout and variant.
-     * Use this to simulate a compositor keymap change (e.g. switching to us/intl
-     * so that dead keys produce the correct keysyms in the child process).
-     *
-     * @param layout XKB layout name (e.g. "us")
-     * @param variant XKB variant name (e.g. "intl"), or nullptr for none
-     */
-    void setKeymap(const char *layout, const char *variant = nullptr)
-    {
-        QXkbCommon::ScopedXKBContext context(xkb_context_new(XKB_CONTEXT_NO_FLAGS));
-        if (!context) {
-            qWarning() << "Failed to create xkb context";
-            return;
-        }
-
-        xkb_rule_names names = {};
-        names.rules = "evdev";
-        names.layout = layout;
-        names.variant = variant ? variant : "";
-        names.options = "compose:menu";
-
-        QXkbCommon::ScopedXKBKeymap keymap(xkb_keymap_new_from_names(context.get(), &names, XKB_KEYMAP_COMPILE_NO_FLAGS));
-        if (!keymap) {
-            qWarning() << "Failed to create xkb keymap for layout" << layout << variant;
-            return;
-        }
-
-        char *mapStr = xkb_keymap_get_as_string(keymap.get(), XKB_KEYMAP_FORMAT_TEXT_V1);
-        if (!mapStr) {
-            qWarning() << "Failed to get xkb keymap string";
-            return;
-        }
-
-        const QByteArray mapData(mapStr);
-        free(mapStr);
-
-        const int fd = createAnonymousKeymapFile(mapData.size() + 1);
-        if (fd < 0) {
-            qWarning() << "Failed to create keymap file";
-            return;
-        }
-
-        if (write(fd, mapData.constData(), mapData.size()) != mapData.size()) {
-            close(fd);
-            qWarning() << "Failed to write keymap";
-            return;
-        }
-        if (write(fd, "\0", 1) != 1) {
-            close(fd);
-            qWarning() << "Failed to write keymap terminator";
-            return;
-        }
-        if (lseek(fd, 0, SEEK_SET) < 0) {
-            close(fd);
-            qWarning() << "Failed to seek keymap file";
-            return;
-        }
-
-        send_keymap(WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1, fd, mapData.size() + 1);
-        close(fd);
-    }
-
-Q_SIGNALS:
-    void keymapDone();
-
-private:
-    void initializeKeymap()
-    {
-        setKeymap("us");
-        m_keymapped = true;
-        Q_EMIT keymapDone();
-    }
-
-    bool m_keymapped = false;
-    uint32_t m_serial = 0;
-    QElapsedTimer m_timer;
-    wl_resource *m_focusSurface = nullptr;
-};
-
-class InputMethodContext : public QObject, public QtWaylandServer::zwp_input_method_context_v1
-{
-    Q_OBJECT
-
-public:
-    explicit InputMethodContext(wl_resource *focusSurface, QObject *parent = nullptr)
-        : QObject(parent)
-        , m_focusSurface(focusSurface)
-    {
-        m_xkbContext.reset(xkb_context_new(XKB_CONTEXT_NO_FLAGS));
-        xkb_rule_names names = {};
-        names.rules = "evdev";
-        names.layout = "us";
-        m_xkbKeymap.reset(xkb_keymap_new_from_names(m_xkbContext.get(), &names, XKB_KEYMAP_COMPILE_NO_FLAGS));
-        m_xkbState.reset(xkb_state_new(m_xkbKeymap.get()));
-    }
-
-    InputMethodKeyboard *keyboard() const
-    {
-        return m_keyboard.get();
-    }
-
-Q_SIGNALS:
-    void keyboardGrabbed();
-    void commitStringChanged(const QString &commitString);
-    void keysymReceived(uint32_t sym, uint32_t state);
-    void keyReceived(uint32_t key, uint32_t state);
-
-protected:
-    void zwp_input_method_context_v1_destroy(Resource *resource) override
-    {
-        wl_resource_destroy(resource->handle);
-    }
-
-    void zwp_input_method_context_v1_commit_string(Resource *resource, uint32_t serial, const QString &text) override
-    {
-        Q_UNUSED(resource);
-        qInfo().noquote() << "commit_string" << serial << text;
-        Q_EMIT commitStringChanged(text);
-    }
-
-    void zwp_input_method_context_v1_preedit_string(Resource *resource, uint32_t serial, const QString &text, const QString &commit) override
-    {
-        Q_UNUSED(resource);
-        qInfo().noquote() << "preedit_string" << serial << text << commit;
-    }
+#include "mockcompositor.h"
 
-    void zwp_input_method_context_v1_delete_surrounding_text(Resource *resource, int32_t index, uint32_t length) override
-    {
-        Q_UNUSED(resource);
-        qInfo() << "delete_surrounding_text" << index << length;
-    }
-
-    void zwp_input_method_context_v1_keysym(Resource *resource, uint32_t serial, uint32_t time, uint32_t sym, uint32_t state, uint32_t modifiers) override
-    {
-        Q_UNUSED(resource);
-        qInfo() << "keysym" << serial << time << sym << state << modifiers;
-        Q_EMIT keysymReceived(sym, state);
-    }
-
-    void zwp_input_method_context_v1_grab_keyboard(Resource *resource, uint32_t keyboard) override
-    {
-        m_keyboard = std::make_unique<InputMethodKeyboard>(resource->client(), keyboard, resource->version());
-        m_keyboard->setFocusSurface(m_focusSurface);
-        Q_EMIT keyboardGrabbed();
-        qInfo() << "input_method_context grab_keyboard";
-    }
-
-    void zwp_input_method_context_v1_key(Resource *resource, uint32_t serial, uint32_t time, uint32_t key, uint32_t state) override
-    {
-        Q_UNUSED(resource);
-        Q_UNUSED(serial);
-        Q_UNUSED(time);
-        Q_EMIT keyReceived(key, state);
-        // Treat both PRESSED and REPEATED as press events (real compositors process
-        // auto-repeat keys the same way, using REPEATED to inform clients that this is an
-        // auto-repeat event).
-        if (state != WL_KEYBOARD_KEY_STATE_PRESSED && state != WL_KEYBOARD_KEY_STATE_REPEATED) {
-            return;
-        }
-        const uint32_t code = key + 8; // XKB keycode = Linux scancode + 8
-        char buf[8] = {};
-        xkb_state_key_get_utf8(m_xkbState.get(), code, buf, sizeof(buf));
-        const QString text = QString::fromUtf8(buf);
-        if (!text.isEmpty()) {
-            qInfo().noquote() << "raw key commit_string" << text;
-            Q_EMIT commitStringChanged(text);
-        }
-    }
-
-    void zwp_input_method_context_v1_modifiers(Resource *resource,
-                                               uint32_t serial,
-                                               uint32_t mods_depressed,
-                                               uint32_t mods_latched,
-                                               uint32_t mods_locked,
-                                               uint32_t group) override
-    {
-        Q_UNUSED(resource);
-        Q_UNUSED(serial);
-        xkb_state_update_mask(m_xkbState.get(), mods_depressed, mods_latched, mods_locked, 0, 0, group);
-    }
-
-private:
-    std::unique_ptr<InputMethodKeyboard> m_keyboard;
-    wl_resource *m_focusSurface = nullptr;
-    QXkbCommon::ScopedXKBContext m_xkbContext;
-    QXkbCommon::ScopedXKBKeymap m_xkbKeymap;
-    QXkbCommon::ScopedXKBState m_xkbState;
-};
-
-class InputPanelSurface : public QObject, public QtWaylandServer::zwp_input_panel_surface_v1
-{
-    Q_OBJECT
-
-public:
-    InputPanelSurface(QWaylandSurface *surface, wl_client *client, uint32_t id, int version, QObject *parent = nullptr)
-        : QObject(parent)
-        , QtWaylandServer::zwp_input_panel_surface_v1(client, id, version)
-        , m_surface(surface)
-    {
-    }
-
-Q_SIGNALS:
-    void toplevelRequested();
-    void overlayRequested();
-
-protected:
-    void zwp_input_panel_surface_v1_set_toplevel(Resource *resource, wl_resource *output, uint32_t position) override
-    {
-        Q_UNUSED(resource);
-        Q_UNUSED(output);
-        Q_UNUSED(position);
-        Q_EMIT toplevelRequested();
-        qInfo() << "input_panel_surface set_toplevel";
-    }
-
-    void zwp_input_panel_surface_v1_set_overlay_panel(Resource *resource) override
-    {
-        Q_UNUSED(resource);
-        Q_EMIT overlayRequested();
-        qInfo() << "input_panel_surface set_overlay_panel";
-    }
-
-    void zwp_input_panel_surface_v1_destroy_resource(Resource *resource) override
-    {
-        Q_UNUSED(resource);
-        delete this;
-    }
-
-private:
-    QWaylandSurface *m_surface = nullptr;
-};
-
-class InputPanelV1 : public QWaylandCompositorExtensionTemplate<InputPanelV1>, public QtWaylandServer::zwp_input_panel_v1
-{
-    Q_OBJECT
-
-public:
-    explicit InputPanelV1(QWaylandCompositor *compositor)
-        : QWaylandCompositorExtensionTemplate<InputPanelV1>(compositor)
-    {
-    }
-
-    void initialize() override
-    {
-        QWaylandCompositorExtensionTemplate::initialize();
-        auto *compositor = static_cast<QWaylandCompositor *>(extensionContainer());
-        if (!compositor) {
-            qWarning() << "No compositor available when initializing input panel";
-            return;
-        }
-        init(compositor->display(), interfaceVersion());
-    }
-
-    int overlayPanelCount() const
-    {
-        return m_overlayPanelCount;
-    }
-
-    int toplevelPanelCount() const
-    {
-        return m_toplevelPanelCount;
-    }
-
-    wl_resource *surfaceResource() const
-    {
-        return m_surfaceResource;
-    }
-
-    QWaylandSurface *surface() const
-    {
-        return m_surface;
-    }
-
-Q_SIGNALS:
-    void inputPanelSurfaceCreated();
-    void overlayPanelRequested();
-    void toplevelPanelRequested();
-
-protected:
-    void zwp_input_panel_v1_get_input_panel_surface(Resource *resource, uint32_t id, wl_resource *surface) override
-    {
-        auto *wlSurface = QWaylandSurface::fromResource(surface);
-        if (!wlSurface) {
-            qWarning() << "input_panel_surface requested for unknown surface";
-            return;
-        }
-
-        m_surfaceResource = surface;
-        m_surface = wlSurface;
-        connect(wlSurface, &QWaylandSurface::surfaceDestroyed, this, [this, wlSurface] {
-            if (m_surface == wlSurface) {
-                m_surface = nullptr;
-                m_surfaceResource = nullptr;
-            }
-        });
-        connect(wlSurface, &QWaylandSurface::damaged, this, [this, wlSurface] {
-            wlSurface->frameStarted();
-            wlSurface->sendFrameCallbacks();
-        });
-
-        auto *panelSurface = new InputPanelSurface(wlSurface, resource->client(), id, resource->version(), this);
-        connect(panelSurface, &InputPanelSurface::toplevelRequested, this, [this] {
-            ++m_toplevelPanelCount;
-            Q_EMIT toplevelPanelRequested();
-        });
-        connect(panelSurface, &InputPanelSurface::overlayRequested, this, [this] {
-            ++m_overlayPanelCount;
-            Q_EMIT overlayPanelRequested();
-        });
-        Q_EMIT inputPanelSurfaceCreated();
-        qInfo() << "input_panel_surface created";
-    }
-
-private:
-    int m_overlayPanelCount = 0;
-    int m_toplevelPanelCount = 0;
-    wl_resource *m_surfaceResource = nullptr;
-    QWaylandSurface *m_surface = nullptr;
-};
-
-class InputMethodV1 : public QWaylandCompositorExtensionTemplate<InputMethodV1>, public QtWaylandServer::zwp_input_method_v1
-{
-    Q_OBJECT
-public:
-    explicit InputMethodV1(QWaylandCompositor *compositor)
-        : QWaylandCompositorExtensionTemplate<InputMethodV1>(compositor)
-    {
-    }
-
-    void setInputPanel(InputPanelV1 *inputPanel)
-    {
-        m_inputPanel = inputPanel;
-    }
-
-    void initialize() override
-    {
-        QWaylandCompositorExtensionTemplate::initialize();
-        auto *compositor = static_cast<QWaylandCompositor *>(extensionContainer());
-        if (!compositor) {
-            qWarning() << "No compositor available when initializing input method";
-            return;
-        }
-        init(compositor->display(), interfaceVersion());
-    }
-
-    void sendActivate()
-    {
-        if (m_context) {
-            return;
-        }
-
-        const wl_resource *focusSurface = m_inputPanel ? m_inputPanel->surfaceResource() : nullptr;
-        m_context = std::make_unique<InputMethodContext>(const_cast<wl_resource *>(focusSurface), this);
-        for (auto *resource : resourceMap()) {
-            auto *contextResource = m_context->add(resource->client(), resource->version());
-            send_activate(resource->handle, contextResource->handle);
-        }
-        qInfo() << "input_method_v1 activated";
-        Q_EMIT activated();
-    }
-
-    void sendDeactivate()
-    {
-        if (!m_context) {
-            return;
-        }
-
-        for (auto *resource : resourceMap()) {
-            auto *contextResource = m_context->resourceMap().value(resource->client());
-            if (contextResource) {
-                send_deactivate(resource->handle, contextResource->handle);
-            }
-        }
-        m_context.reset();
-        qInfo() << "input_method_v1 deactivated";
-    }
-
-    InputMethodContext *context() const
-    {
-        return m_context.get();
-    }
-
-Q_SIGNALS:
-    void activated();
-
-protected:
-    void zwp_input_method_v1_bind_resource(Resource *resource) override
-    {
-        if (m_context) {
-            auto *contextResource = m_context->add(resource->client(), resource->version());
-            send_activate(resource->handle, contextResource->handle);
-            return;
-        }
-
-        if (!m_autoActivate || m_activatePending) {
-            return;
-        }
-
-        m_activatePending = true;
-        QTimer::singleShot(m_activateDelayMs, this, [this] {
-            m_activatePending = false;
-            sendActivate();
-        });
-    }
-
-private:
-    const bool m_autoActivate = true;
-    const int m_activateDelayMs = 200;
-
-    bool m_activatePending = false;
-    std::unique_ptr<InputMethodContext> m_context;
-    InputPanelV1 *m_inputPanel = nullptr;
-};
-
-class MockInputMethodCompositorTest : public QObject
+class MockInputMethodCompositorTest : public MockCompositorTestBase
 {
     Q_OBJECT
 
@@ -530,147 +14,30 @@ private Q_SLOTS:
     void initTestCase()
     {
         // create a temporary folder for test configs
-        if (!m_home.isValid() || !qputenv("HOME", qPrintable(m_home.path()))) {
-            qFatal("Couldn't create temporary home folder for the test");
-            return;
-        }
+        setUpHome();
 
         {
             KConfig cfg(QStringLiteral("plasmakeyboardrc"));
             KConfigGroup grp(&cfg, QStringLiteral("General"));
             grp.writeEntry(QStringLiteral("enabledLocales"), QStringLiteral("it_IT"));
             grp.writeEntry(QStringLiteral("keyboardNavigationEnabled"), true);
+            grp.writeEntry(QStringLiteral("emojiPopupEnabled"), true);
             // Set the long press threshold to max to avoid potential flakiness in CI where timing can be unpredictable.
             grp.writeEntry(QStringLiteral("diacriticsHoldThresholdMs"), 1500);
         }
 
-        m_compositor = std::make_unique<QWaylandCompositor>();
-        m_socketPath = m_runtimeDir.path() + QLatin1String("/plasma-keyboard-mock-") + QString::number(QCoreApplication::applicationPid());
-        m_compositor->setSocketName(m_socketPath.toUtf8());
-        m_compositor->setUseHardwareIntegrationExtension(false);
-        m_compositor->create();
-        QTRY_VERIFY_WITH_TIMEOUT(m_compositor->isCreated(), 2000);
-
-        m_seat = m_compositor->defaultSeat();
-        QVERIFY(m_seat);
-
-        m_outputWindow = std::make_unique<QWindow>();
-        m_outputWindow->setGeometry(0, 0, 1280, 720);
-        m_outputWindow->setTitle(u"Mock Compositor Output"_s);
-        m_outputWindow->setVisible(false);
-
-        m_output = std::make_unique<QWaylandOutput>(m_compositor.get(), m_outputWindow.get());
-        m_output->setManufacturer(u"Mock"_s);
-        m_output->setModel(u"InputMethod"_s);
-        m_output->addMode(QWaylandOutputMode(QSize(1280, 720), 60000), true);
-        m_output->setCurrentMode(m_output->modes().first());
-        m_compositor->setDefaultOutput(m_output.get());
-
-        m_xdgShell = std::make_unique<QWaylandXdgShell>(m_compositor.get());
-        m_xdgShell->initialize();
-
-        m_inputMethod = std::make_unique<InputMethodV1>(m_compositor.get());
-        m_inputMethod->initialize();
-
-        m_inputPanel = std::make_unique<InputPanelV1>(m_compositor.get());
-        m_inputPanel->initialize();
-        m_inputMethod->setInputPanel(m_inputPanel.get());
-
-        m_child = std::make_unique<QProcess>();
-        connect(m_child.get(), &QProcess::readyReadStandardError, this, [this] {
-            QTextStream(stderr) << m_child->readAllStandardError();
-        });
-        connect(m_child.get(), &QProcess::readyReadStandardOutput, this, [this] {
-            QTextStream(stdout) << m_child->readAllStandardOutput();
-        });
-        connect(m_child.get(), &QProcess::finished, this, [this] {
-            qWarning() << "child state:" << m_child->state() << "error:" << m_child->error() << m_child->errorString() << "exitStatus:" << m_child->exitStatus()
-                       << "exitCode:" << m_child->exitCode();
-        });
-        auto env = QProcessEnvironment::systemEnvironment();
-        env.insert(u"WAYLAND_DISPLAY"_s, m_socketPath);
-        env.insert(u"QT_QUICK_BACKEND"_s, u"software"_s); // Without this plasma-keyboard explodes on alpine for some reason
-        m_child->setProcessEnvironment(env);
-
-#if PLASMA_KEYBOARD_UNDER_GDB
-        m_child->setProgram(QStringLiteral("gdb"));
-        m_child->setArguments({QStringLiteral("-batch"),
-                               QStringLiteral("-ex"),
-                               QStringLiteral("set pagination off"),
-                               QStringLiteral("-ex"),
-                               QStringLiteral("run"),
-                               QStringLiteral("-ex"),
-                               QStringLiteral("bt"),
-                               QStringLiteral("-ex"),
-                               QStringLiteral("quit"),
-                               QStringLiteral("--args"),
-                               QStringLiteral(PLASMA_KEYBOARD_BINARY_PATH)});
-#else
-        m_child->setProgram(QStringLiteral(PLASMA_KEYBOARD_BINARY_PATH));
-#endif
-        m_child->start();
-        QVERIFY2(m_child->waitForStarted(), qPrintable(m_child->errorString()));
-
-        qInfo().noquote().nospace() << "Compositor running on WAYLAND_DISPLAY=" << m_socketPath << " " << PLASMA_KEYBOARD_BINARY_PATH;
-        {
-            QSignalSpy spy(m_inputMethod.get(), &InputMethodV1::activated);
-            QVERIFY(spy.count() || spy.wait());
-        }
-
-        QVERIFY(m_inputMethod->context());
-        if (!m_inputMethod->context()->keyboard()) {
-            QSignalSpy grabSpy(m_inputMethod->context(), &InputMethodContext::keyboardGrabbed);
-            QVERIFY(grabSpy.wait());
-        }
-
-        auto *keyboard = m_inputMethod->context()->keyboard();
-        QVERIFY(keyboard);
-        if (!keyboard->keymapped()) {
-            QSignalSpy grabSpy(keyboard, &InputMethodKeyboard::keymapDone);
-            QVERIFY(grabSpy.wait());
-        }
+        startCompositor();
     }
 
     /**
      * Clean up after each test function.
-     *
-     * Drains any pending Wayland events from the preceding test so that
-     * stale events/responses do not bleed into the next test.
-     *
-     * Uses longer waits in CI environments (where timing is less predictable)
-     * and shorter waits locally to keep iteration fast.
      */
     void cleanup()
     {
-        QTest::qWait(RUNNING_IN_CI ? 200 : 20);
-        wl_display_flush_clients(m_compositor->display());
-        QTest::qWait(RUNNING_IN_CI ? 100 : 20);
-    }
-
-    void sendKey(int key, int interval)
-    {
-        auto keyboard = m_inputMethod->context()->keyboard();
-        Q_ASSERT(keyboard);
-        keyboard->sendKey(key, WL_KEYBOARD_KEY_STATE_PRESSED);
-        wl_display_flush_clients(m_compositor->display());
-        QTest::qWait(interval);
-        keyboard->sendKey(key, WL_KEYBOARD_KEY_STATE_RELEASED);
-        wl_display_flush_clients(m_compositor->display());
-    }
-
-    /**
-     * Sets an updated keymap and waits for it to be processed.
-     *
-     * @param layout XKB layout name (e.g. "us")
-     * @param variant XKB variant name (e.g. "intl"), or nullptr for none
-     */
-    void setKeymap(const char *layout, const char *variant = nullptr)
-    {
-        auto *keyboard = m_inputMethod->context()->keyboard();
-        Q_ASSERT(keyboard);
-        keyboard->setKeymap(layout, variant);
-        wl_display_flush_clients(m_compositor->display());
-        QTest::qWait(200);
+        if (auto *context = m_inputMethod->context()) {
+            context->setEchoMode(InputMethodContext::EchoMode::None);
+        }
+        drainEvents();
     }
 
     /**
@@ -996,18 +363,115 @@ private Q_SLOTS:
         QCOMPARE(keySpy.at(last).at(1).toUInt(), static_cast<uint32_t>(WL_KEYBOARD_KEY_STATE_RELEASED));
     }
 
+    void testSurroundingTextEchoes_data()
+    {
+        addEchoModeRows();
+    }
+
+    /**
+     * Test that the overlay survives the client echoing the long-pressed key
+     * back, however the client chooses to report it, and that the selection
+     * replaces the base character.
+     */
+    void testSurroundingTextEchoes()
+    {
+        QFETCH(InputMethodContext::EchoMode, echoMode);
+        auto *context = m_inputMethod->context();
+        context->setEchoMode(echoMode);
+        context->setSurroundingText(u"Hello "_s, 6);
+        wl_display_flush_clients(m_compositor->display());
+        QTest::qWait(50);
+
+        QSignalSpy overlaySpy(m_inputPanel.get(), &InputPanelV1::overlayPanelRequested);
+        sendKey(KEY_A, 2000);
+        QVERIFY(overlaySpy.count() || overlaySpy.wait());
+
+        QSignalSpy commitStringSpy(context, &InputMethodContext::commitStringChanged);
+        sendKey(KEY_1, 10);
+        QVERIFY(commitStringSpy.count() || commitStringSpy.wait());
+        QCOMPARE(commitStringSpy.count(), 1);
+        QCOMPARE(commitStringSpy.first().first().toString(), QStringLiteral("à"));
+        QCOMPARE(context->surroundingText(), QStringLiteral("Hello à"));
+    }
+
+    void testExternalCursorMoveCancelsOverlay_data()
+    {
+        addEchoModeRows();
+    }
+
+    /**
+     * Test that moving the cursor while the overlay is open closes it, however
+     * the client echoes our own edits.
+     */
+    void testExternalCursorMoveCancelsOverlay()
+    {
+        QFETCH(InputMethodContext::EchoMode, echoMode);
+        auto *context = m_inputMethod->context();
+        context->setEchoMode(echoMode);
+        context->setSurroundingText(u"Hello "_s, 6);
+        wl_display_flush_clients(m_compositor->display());
+        QTest::qWait(50);
+
+        QSignalSpy overlaySpy(m_inputPanel.get(), &InputPanelV1::overlayPanelRequested);
+        sendKey(KEY_A, 2000);
+        QVERIFY(overlaySpy.count() || overlaySpy.wait());
+
+        // The user clicks at the start of the text.
+        context->setSurroundingText(u"Hello a"_s, 0);
+        wl_display_flush_clients(m_compositor->display());
+        QTest::qWait(100);
+
+        // With the overlay gone, 1 is typed rather than selecting a candidate.
+        QSignalSpy commitStringSpy(context, &InputMethodContext::commitStringChanged);
+        sendKey(KEY_1, 10);
+        QVERIFY(commitStringSpy.count() || commitStringSpy.wait());
+        QCOMPARE(commitStringSpy.first().first().toString(), QStringLiteral("1"));
+    }
+
+    /**
+     * Test that text typed through forwarded keys reaches the text-based
+     * triggers: completing an emoji query opens its overlay, and picking a
+     * candidate replaces the query.
+     */
+    void testTypedTextOpensEmojiOverlay()
+    {
+        auto *context = m_inputMethod->context();
+        context->setEchoMode(InputMethodContext::EchoMode::Single);
+        context->setSurroundingText(u"Moo :co"_s, 7);
+        wl_display_flush_clients(m_compositor->display());
+        QTest::qWait(50);
+
+        // w has no diacritics, so it is forwarded and only seen in the echo.
+        QSignalSpy overlaySpy(m_inputPanel.get(), &InputPanelV1::overlayPanelRequested);
+        sendKey(KEY_W, 10);
+        QVERIFY(overlaySpy.count() || overlaySpy.wait());
+
+        QSignalSpy commitStringSpy(context, &InputMethodContext::commitStringChanged);
+        sendKey(KEY_1, 10);
+        QVERIFY(commitStringSpy.count() || commitStringSpy.wait());
+        QCOMPARE(commitStringSpy.first().first().toString(), QStringLiteral("🐄"));
+        QCOMPARE(context->surroundingText(), QStringLiteral("Moo 🐄"));
+    }
+
     void cleanupTestCase()
     {
-        if (m_child) {
-            if (m_child->state() != QProcess::NotRunning) {
-                m_child->terminate();
-                m_child->waitForFinished(2000);
-            }
-            m_child.reset();
-        }
+        stopCompositor();
     }
 
 private:
+    /**
+     * Rows for tests that run against each way a client may echo our edits.
+     */
+    void addEchoModeRows()
+    {
+        QTest::addColumn<InputMethodContext::EchoMode>("echoMode");
+        QTest::newRow("no echo") << InputMethodContext::EchoMode::None;
+        QTest::newRow("single echo") << InputMethodContext::EchoMode::Single;
+        QTest::newRow("duplicate echo") << InputMethodContext::EchoMode::Duplicate;
+        QTest::newRow("stale then fresh") << InputMethodContext::EchoMode::StaleThenFresh;
+        QTest::newRow("late repeat") << InputMethodContext::EchoMode::Late;
+    }
+
     /**
      * Helper that simulates compositor-side auto-repeat when a key is held.
      *
@@ -1048,19 +512,6 @@ private:
         keyboard->sendKey(key, WL_KEYBOARD_KEY_STATE_RELEASED);
         wl_display_flush_clients(m_compositor->display());
     }
-
-    QTemporaryDir m_runtimeDir;
-    QTemporaryDir m_home;
-    QString m_socketPath;
-
-    std::unique_ptr<QWaylandCompositor> m_compositor;
-    std::unique_ptr<QWindow> m_outputWindow;
-    std::unique_ptr<QWaylandOutput> m_output;
-    QWaylandSeat *m_seat = nullptr;
-    std::unique_ptr<QWaylandXdgShell> m_xdgShell;
-    std::unique_ptr<InputMethodV1> m_inputMethod;
-    std::unique_ptr<InputPanelV1> m_inputPanel;
-    std::unique_ptr<QProcess> m_child;
 };
 
 QTEST_MAIN(MockInputMethodCompositorTest)
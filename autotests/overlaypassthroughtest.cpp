@@ -0,0 +1,92 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "mockcompositor.h"
+
+#include <optional>
+
+/**
+ * Checks that textless keys are passed through again once an overlay that was
+ * opened without a held key (the emoji overlay) is closed.
+ *
+ * The state is read from plasma-keyboard's own debug output, which logs every
+ * change of the textless keys pass-through.
+ */
+class OverlayPassThroughTest : public MockCompositorTestBase
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        setUpHome();
+
+        {
+            KConfig cfg(QStringLiteral("plasmakeyboardrc"));
+            KConfigGroup grp(&cfg, QStringLiteral("General"));
+            grp.writeEntry(QStringLiteral("enabledLocales"), QStringLiteral("it_IT"));
+            // Keyboard navigation keeps every key for itself, so it has to be off here.
+            grp.writeEntry(QStringLiteral("keyboardNavigationEnabled"), false);
+            grp.writeEntry(QStringLiteral("emojiPopupEnabled"), true);
+            // Textless keys are only passed through from the input thread.
+            grp.writeEntry(QStringLiteral("inputThreadEnabled"), true);
+            grp.writeEntry(QStringLiteral("diacriticsHoldThresholdMs"), 1500);
+        }
+
+        m_childEnvironment.insert(u"QT_LOGGING_RULES"_s, u"org.kde.plasma.keyboard.debug=true"_s);
+        startCompositor();
+    }
+
+    void testEmojiCommitRestoresPassThrough()
+    {
+        auto *context = m_inputMethod->context();
+        context->setEchoMode(InputMethodContext::EchoMode::Single);
+        context->setSurroundingText(u"Moo "_s, 4);
+        wl_display_flush_clients(m_compositor->display());
+        QTest::qWait(50);
+
+        sendKey(KEY_W, 10);
+        QTRY_COMPARE_WITH_TIMEOUT(passThrough(), std::optional<bool>(true), 5000);
+
+        context->setSurroundingText(u"Moo :co"_s, 7);
+        wl_display_flush_clients(m_compositor->display());
+        QTest::qWait(50);
+
+        QSignalSpy overlaySpy(m_inputPanel.get(), &InputPanelV1::overlayPanelRequested);
+        sendKey(KEY_W, 10);
+        QVERIFY(overlaySpy.count() || overlaySpy.wait());
+        QTRY_COMPARE_WITH_TIMEOUT(passThrough(), std::optional<bool>(false), 5000);
+
+        QSignalSpy commitStringSpy(context, &InputMethodContext::commitStringChanged);
+        sendKey(KEY_1, 10);
+        QVERIFY(commitStringSpy.count() || commitStringSpy.wait());
+        QCOMPARE(commitStringSpy.last().first().toString(), QStringLiteral("🐄"));
+
+        // The emoji overlay had no held key whose release would need swallowing,
+        // so nothing may keep the textless keys from the input thread.
+        QTRY_COMPARE_WITH_TIMEOUT(passThrough(), std::optional<bool>(true), 5000);
+    }
+
+    void cleanupTestCase()
+    {
+        stopCompositor();
+    }
+
+private:
+    /**
+     * The textless keys pass-through state plasma-keyboard logged last, if any.
+     */
+    std::optional<bool> passThrough() const
+    {
+        static constexpr QByteArrayView marker = "InputPlugin: Textless keys pass through: ";
+        const qsizetype index = m_childStandardError.lastIndexOf(marker);
+        if (index < 0) {
+            return std::nullopt;
+        }
+        return m_childStandardError.sliced(index + marker.size()).startsWith("true");
+    }
+};
+
+QTEST_MAIN(OverlayPassThroughTest)
+
+#include "overlaypassthroughtest.moc"
@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "mockcompositor.h"
+
+/**
+ * Cold start benchmark for plasma-keyboard.
+ *
+ * Launches plasma-keyboard against the mock compositor with --profile-startup
+ * and measures how long it takes until it has activated and grabbed the
+ * keyboard, and until the first hardware key press is committed to the text
+ * input. The per-step breakdown is printed by plasma-keyboard itself to the
+ * "org.kde.plasma.keyboard.startup" category.
+ *
+ * The mock compositor delays activation by a fixed 200 ms after the input
+ * method binds, which is included in the times.
+ */
+class StartupBenchmark : public MockCompositorTestBase
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        setUpHome();
+        m_childArguments = {QStringLiteral("--profile-startup")};
+    }
+
+    void cleanupTestCase()
+    {
+        stopCompositor();
+    }
+
+    void benchmarkTimeToFirstCommit()
+    {
+        QElapsedTimer clock;
+        clock.start();
+
+        startCompositor();
+        if (QTest::currentTestFailed()) {
+            return;
+        }
+        const qint64 readyMs = clock.elapsed();
+
+        QSignalSpy commitStringSpy(m_inputMethod->context(), &InputMethodContext::commitStringChanged);
+        sendKey(KEY_1, 10);
+        QVERIFY(commitStringSpy.count() || commitStringSpy.wait(RUNNING_IN_CI ? 30000 : 10000));
+        const qint64 firstCommitMs = clock.elapsed();
+
+        QCOMPARE(commitStringSpy.first().first().toString(), QStringLiteral("1"));
+
+        qInfo().nospace() << "keyboard grabbed after " << readyMs << " ms, first commit after " << firstCommitMs << " ms";
+    }
+};
+
+QTEST_MAIN(StartupBenchmark)
+
+#include "startupbenchmark.moc"
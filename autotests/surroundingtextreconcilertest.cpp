@@ -0,0 +1,177 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "surroundingtextreconciler.h"
+
+#include <QTest>
+
+using namespace Qt::StringLiterals;
+
+using Result = SurroundingTextReconciler::Result;
+
+/**
+ * Checks how SurroundingTextReconciler classifies surrounding-text updates.
+ */
+class SurroundingTextReconcilerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testFirstUpdateIsExternal()
+    {
+        SurroundingTextReconciler reconciler;
+        QCOMPARE(reconciler.reconcile(1, u"Hello"_s, 5, 5), Result::External);
+    }
+
+    void testRepeatedUpdateIsStale()
+    {
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(1, u"Hello"_s, 5, 5);
+        QCOMPARE(reconciler.reconcile(1, u"Hello"_s, 5, 5), Result::Stale);
+    }
+
+    void testEcho()
+    {
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(1, u"Hello"_s, 5, 5);
+        reconciler.expectEdit(2, 0, u"!"_s);
+        QCOMPARE(reconciler.pendingEdits(), 1);
+
+        QCOMPARE(reconciler.reconcile(2, u"Hello!"_s, 6, 6), Result::Echo);
+        QCOMPARE(reconciler.pendingEdits(), 0);
+
+        // Repeating the echoed state carries no news.
+        QCOMPARE(reconciler.reconcile(2, u"Hello!"_s, 6, 6), Result::Stale);
+    }
+
+    void testReplacementEcho()
+    {
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(1, u"Moo :cow"_s, 8, 8);
+        reconciler.expectEdit(2, 4, u"🐮"_s);
+        QCOMPARE(reconciler.reconcile(2, u"Moo 🐮"_s, 6, 6), Result::Echo);
+    }
+
+    void testBaseStateWhileEditPendingIsStale()
+    {
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(1, u"Hello"_s, 5, 5);
+        reconciler.expectEdit(2, 0, u"!"_s);
+
+        // Sent by some clients around the commit, before the edit is applied.
+        QCOMPARE(reconciler.reconcile(2, u"Hello"_s, 5, 5), Result::Stale);
+        QCOMPARE(reconciler.pendingEdits(), 1);
+
+        QCOMPARE(reconciler.reconcile(2, u"Hello!"_s, 6, 6), Result::Echo);
+    }
+
+    void testEditsStack()
+    {
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(1, u"Hello"_s, 5, 5);
+        reconciler.expectEdit(2, 0, u"a"_s);
+        reconciler.expectEdit(3, 0, u"b"_s);
+        reconciler.expectEdit(4, 0, u"c"_s);
+
+        // The echo of an older edit only settles the edits up to it.
+        QCOMPARE(reconciler.reconcile(4, u"Helloa"_s, 6, 6), Result::Echo);
+        QCOMPARE(reconciler.pendingEdits(), 2);
+
+        // The echo of the newest edit settles everything before it.
+        QCOMPARE(reconciler.reconcile(4, u"Helloabc"_s, 8, 8), Result::Echo);
+        QCOMPARE(reconciler.pendingEdits(), 0);
+    }
+
+    void testExternalChangeDropsPendingEdits()
+    {
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(1, u"Hello world"_s, 11, 11);
+        reconciler.expectEdit(2, 0, u"!"_s);
+
+        // The user moved the cursor.
+        QCOMPARE(reconciler.reconcile(2, u"Hello world"_s, 5, 5), Result::External);
+        QCOMPARE(reconciler.pendingEdits(), 0);
+    }
+
+    void testUnknownBaseMatchesInsertedText()
+    {
+        SurroundingTextReconciler reconciler;
+
+        // Nothing to recognise a pure deletion by.
+        reconciler.expectEdit(1, 3, QString());
+        QCOMPARE(reconciler.pendingEdits(), 0);
+
+        reconciler.expectEdit(1, 0, u"xyz"_s);
+        QCOMPARE(reconciler.reconcile(1, u"abcxyz def"_s, 6, 6), Result::Echo);
+    }
+
+    void testShiftedWindowMatches()
+    {
+        const QString text = u"The quick brown fox jumps over the lazy dog"_s;
+
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(1, text, text.size(), text.size());
+        reconciler.expectEdit(2, 0, u"!"_s);
+
+        // The client only reports a few words before the cursor.
+        const QString window = u"the lazy dog!"_s;
+        QCOMPARE(reconciler.reconcile(2, window, window.size(), window.size()), Result::Echo);
+    }
+
+    void testShortWindowDoesNotMatch()
+    {
+        const QString text = u"The quick brown fox jumps over the lazy dog"_s;
+
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(1, text, text.size(), text.size());
+        reconciler.expectEdit(2, 0, u"!"_s);
+
+        // Too short an overlap to say where the cursor is.
+        QCOMPARE(reconciler.reconcile(2, u"og!"_s, 3, 3), Result::External);
+    }
+
+    void testSelectionIsReplaced()
+    {
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(1, u"Hello world"_s, 11, 6);
+        reconciler.expectEdit(2, 0, u"there"_s);
+        QCOMPARE(reconciler.reconcile(2, u"Hello there"_s, 11, 11), Result::Echo);
+    }
+
+    void testUnechoedEditsExpire()
+    {
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(1, u"Hello"_s, 5, 5);
+        reconciler.expectEdit(2, 0, u"!"_s);
+
+        QCOMPARE(reconciler.reconcile(10, u"Hello"_s, 5, 5), Result::Stale);
+        QCOMPARE(reconciler.pendingEdits(), 1);
+
+        QCOMPARE(reconciler.reconcile(11, u"Hello"_s, 5, 5), Result::Stale);
+        QCOMPARE(reconciler.pendingEdits(), 0);
+    }
+
+    void testSerialWrapAround()
+    {
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(0xfffffffe, u"Hello"_s, 5, 5);
+        reconciler.expectEdit(0xfffffffe, 0, u"!"_s);
+
+        QCOMPARE(reconciler.reconcile(2, u"Hello!"_s, 6, 6), Result::Echo);
+    }
+
+    void testReset()
+    {
+        SurroundingTextReconciler reconciler;
+        reconciler.reconcile(1, u"Hello"_s, 5, 5);
+        reconciler.expectEdit(2, 0, u"!"_s);
+        reconciler.reset();
+
+        QCOMPARE(reconciler.pendingEdits(), 0);
+        QCOMPARE(reconciler.reconcile(2, u"Hello"_s, 5, 5), Result::External);
+    }
+};
+
+QTEST_GUILESS_MAIN(SurroundingTextReconcilerTest)
+
+#include "surroundingtextreconcilertest.moc"
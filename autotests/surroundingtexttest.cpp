@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "surroundingtext.h"
+
+#include <QTest>
+
+using namespace Qt::StringLiterals;
+
+/**
+ * Checks the UTF-8 and UTF-16 offset conversion of SurroundingText.
+ */
+class SurroundingTextTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testAscii()
+    {
+        SurroundingText text;
+        text.setText(u"Hello"_s);
+        QCOMPARE(text.toUtf16Offset(3), 3);
+        QCOMPARE(text.toUtf8Offset(3), 3);
+
+        // Offsets are clamped to the text.
+        QCOMPARE(text.toUtf16Offset(-1), 0);
+        QCOMPARE(text.toUtf16Offset(42), 5);
+        QCOMPARE(text.toUtf8Offset(-1), 0);
+        QCOMPARE(text.toUtf8Offset(42), 5);
+    }
+
+    void testMultiByte()
+    {
+        // One, two, three and four UTF-8 bytes per character.
+        SurroundingText text;
+        text.setText(u"aé€😀b"_s);
+
+        const QList<std::pair<qsizetype, qsizetype>> boundaries = {{0, 0}, {1, 1}, {2, 3}, {3, 6}, {5, 10}, {6, 11}};
+        for (const auto &[utf16, utf8] : boundaries) {
+            QCOMPARE(text.toUtf16Offset(utf8), utf16);
+            QCOMPARE(text.toUtf8Offset(utf16), utf8);
+        }
+        QCOMPARE(text.toUtf16Offset(42), 6);
+        QCOMPARE(text.toUtf8Offset(42), 11);
+    }
+
+    void testOffsetInsideCharacterRoundsDown()
+    {
+        SurroundingText text;
+        text.setText(u"aé€😀b"_s);
+
+        QCOMPARE(text.toUtf16Offset(2), 1);
+        QCOMPARE(text.toUtf16Offset(4), 2);
+        QCOMPARE(text.toUtf16Offset(5), 2);
+        QCOMPARE(text.toUtf16Offset(7), 3);
+        QCOMPARE(text.toUtf16Offset(9), 3);
+
+        // Between the two halves of the surrogate pair.
+        QCOMPARE(text.toUtf8Offset(4), 6);
+    }
+
+    void testLoneSurrogates()
+    {
+        // Lone surrogates are sent as U+FFFD, which takes three bytes.
+        const QChar high(char16_t(0xD83D));
+        const QChar low(char16_t(0xDE00));
+
+        SurroundingText text;
+        text.setText(u"a"_s + high + u"b"_s + low + u"c"_s + high);
+
+        const QList<std::pair<qsizetype, qsizetype>> boundaries = {{0, 0}, {1, 1}, {2, 4}, {3, 5}, {4, 8}, {5, 9}, {6, 12}};
+        for (const auto &[utf16, utf8] : boundaries) {
+            QCOMPARE(text.toUtf16Offset(utf8), utf16);
+            QCOMPARE(text.toUtf8Offset(utf16), utf8);
+        }
+    }
+
+    void testCheckpointBoundaries()
+    {
+        // Characters of every length, with surrogate pairs straddling the
+        // checkpoints every 64 code units.
+        QString content;
+        while (content.size() < 1000) {
+            content += u"é"_s.repeated(63 - content.size() % 64) + u"😀a€"_s;
+        }
+
+        SurroundingText text;
+        text.setText(content);
+
+        for (qsizetype utf16 = 0; utf16 <= content.size(); ++utf16) {
+            if (utf16 > 0 && utf16 < content.size() && content.at(utf16).isLowSurrogate()) {
+                continue;
+            }
+            const qsizetype utf8 = QStringView(content).left(utf16).toUtf8().size();
+            QCOMPARE(text.toUtf8Offset(utf16), utf8);
+            QCOMPARE(text.toUtf16Offset(utf8), utf16);
+        }
+    }
+
+    void testSetTextDropsIndex()
+    {
+        SurroundingText text;
+        text.setText(u"😀😀"_s);
+        QCOMPARE(text.toUtf16Offset(4), 2);
+
+        text.setText(u"abcd"_s);
+        QCOMPARE(text.toUtf16Offset(4), 4);
+        QCOMPARE(text.toUtf8Offset(2), 2);
+
+        text.setText(u"é"_s);
+        QCOMPARE(text.toUtf8Offset(1), 2);
+    }
+};
+
+QTEST_GUILESS_MAIN(SurroundingTextTest)
+
+#include "surroundingtexttest.moc"
@@ -0,0 +1,156 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "abbreviationtrie.h"
+
+#include <QRandomGenerator>
+#include <QSet>
+#include <QStringList>
+#include <QTest>
+
+using namespace Qt::StringLiterals;
+
+namespace
+{
+
+/**
+ * Deterministic set of @p count distinct lower-case abbreviations of 2 to 8
+ * letters, roughly what a synced snippet collection looks like.
+ */
+QStringList generateAbbreviations(int count)
+{
+    QRandomGenerator random(42);
+    QSet<QString> seen;
+    QStringList result;
+    result.reserve(count);
+    while (result.size() < count) {
+        QString abbreviation;
+        const int length = random.bounded(2, 9);
+        for (int i = 0; i < length; ++i) {
+            abbreviation.append(QChar(u'a' + random.bounded(26)));
+        }
+        if (!seen.contains(abbreviation)) {
+            seen.insert(abbreviation);
+            result.append(abbreviation);
+        }
+    }
+    return result;
+}
+
+/**
+ * The matching rule TextExpansionTrigger used before the trie: test every
+ * abbreviation with endsWith() and keep the longest on a word boundary.
+ */
+qsizetype bruteForceLongestMatch(const QStringList &abbreviations, const QString &text)
+{
+    qsizetype match = 0;
+    for (const QString &abbreviation : abbreviations) {
+        if (abbreviation.size() > match && text.endsWith(abbreviation)) {
+            const qsizetype pos = text.size() - abbreviation.size();
+            if (pos == 0 || text.at(pos - 1).isSpace()) {
+                match = abbreviation.size();
+            }
+        }
+    }
+    return match;
+}
+
+} // namespace
+
+/**
+ * Suffix matching for text expansion abbreviations.
+ *
+ * Checks AbbreviationTrie against a brute-force reference and measures the
+ * per-keystroke lookup cost, which should stay flat as the number of
+ * abbreviations grows.
+ */
+class TextExpansionBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testMatchesReference()
+    {
+        const QStringList abbreviations = generateAbbreviations(2000);
+        AbbreviationTrie trie;
+        for (const QString &abbreviation : abbreviations) {
+            trie.insert(abbreviation);
+        }
+        QCOMPARE(trie.size(), abbreviations.size());
+
+        for (const QString &abbreviation : abbreviations) {
+            const QStringList texts = {abbreviation, u"see you "_s + abbreviation, u"x"_s + abbreviation, abbreviation + u" "_s};
+            for (const QString &text : texts) {
+                QCOMPARE(trie.longestMatch(text), bruteForceLongestMatch(abbreviations, text));
+            }
+        }
+    }
+
+    void testRemove()
+    {
+        AbbreviationTrie trie;
+        trie.insert(u"brb");
+        trie.insert(u"rb");
+        trie.insert(u"afaik");
+        QCOMPARE(trie.longestMatch(u"ok brb"), qsizetype(3));
+
+        trie.remove(u"brb");
+        QCOMPARE(trie.size(), qsizetype(2));
+        QCOMPARE(trie.longestMatch(u"ok brb"), qsizetype(0));
+        QCOMPARE(trie.longestMatch(u"ok rb"), qsizetype(2));
+
+        // Removing an unknown abbreviation or a prefix of one is a no-op.
+        trie.remove(u"brb");
+        trie.remove(u"ik");
+        QCOMPARE(trie.size(), qsizetype(2));
+        QCOMPARE(trie.longestMatch(u"afaik"), qsizetype(5));
+
+        // Recycled nodes must not leak old edges.
+        trie.remove(u"afaik");
+        trie.insert(u"brb");
+        QCOMPARE(trie.longestMatch(u"afaik"), qsizetype(0));
+        QCOMPARE(trie.longestMatch(u"brb"), qsizetype(3));
+    }
+
+    void benchmarkLongestMatch_data()
+    {
+        QTest::addColumn<int>("abbreviationCount");
+
+        QTest::newRow("100 entries") << 100;
+        QTest::newRow("1000 entries") << 1000;
+        QTest::newRow("10000 entries") << 10000;
+    }
+
+    void benchmarkLongestMatch()
+    {
+        QFETCH(int, abbreviationCount);
+
+        const QStringList abbreviations = generateAbbreviations(abbreviationCount);
+        AbbreviationTrie trie;
+        for (const QString &abbreviation : abbreviations) {
+            trie.insert(abbreviation);
+        }
+
+        // Half of the typed words end in a known abbreviation, half are misses.
+        QStringList typed;
+        for (int i = 0; i < 1000; ++i) {
+            if (i % 2) {
+                typed.append(u"thanks "_s + abbreviations.at(i % abbreviations.size()));
+            } else {
+                typed.append(u"the quick brown fox"_s);
+            }
+        }
+
+        qsizetype matched = 0;
+        QBENCHMARK {
+            for (const QString &text : std::as_const(typed)) {
+                matched += trie.longestMatch(text);
+            }
+        }
+        QVERIFY(matched > 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(TextExpansionBenchmark)
+
+#include "textexpansionbenchmark.moc"
@@ -0,0 +1,184 @@
+// SPDX-FileCopyrightText: 2026 KDE contributors
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "mockcompositor.h"
+
+#include <algorithm>
+#include <array>
+
+namespace
+{
+
+struct BenchmarkKey {
+    int scancode;
+    char16_t text;
+};
+
+// "the quick brown fox jumps over the lazy dog " on a us layout
+// clang-format off
+constexpr std::array<BenchmarkKey, 44> BENCHMARK_TEXT = {{
+    {KEY_T, u't'}, {KEY_H, u'h'}, {KEY_E, u'e'}, {KEY_SPACE, u' '},
+    {KEY_Q, u'q'}, {KEY_U, u'u'}, {KEY_I, u'i'}, {KEY_C, u'c'}, {KEY_K, u'k'}, {KEY_SPACE, u' '},
+    {KEY_B, u'b'}, {KEY_R, u'r'}, {KEY_O, u'o'}, {KEY_W, u'w'}, {KEY_N, u'n'}, {KEY_SPACE, u' '},
+    {KEY_F, u'f'}, {KEY_O, u'o'}, {KEY_X, u'x'}, {KEY_SPACE, u' '},
+    {KEY_J, u'j'}, {KEY_U, u'u'}, {KEY_M, u'm'}, {KEY_P, u'p'}, {KEY_S, u's'}, {KEY_SPACE, u' '},
+    {KEY_O, u'o'}, {KEY_V, u'v'}, {KEY_E, u'e'}, {KEY_R, u'r'}, {KEY_SPACE, u' '},
+    {KEY_T, u't'}, {KEY_H, u'h'}, {KEY_E, u'e'}, {KEY_SPACE, u' '},
+    {KEY_L, u'l'}, {KEY_A, u'a'}, {KEY_Z, u'z'}, {KEY_Y, u'y'}, {KEY_SPACE, u' '},
+    {KEY_D, u'd'}, {KEY_O, u'o'}, {KEY_G, u'g'}, {KEY_SPACE, u' '},
+}};
+// clang-format on
+
+/**
+ * How far ahead of the oldest outstanding key a commit may be matched. Anything
+ * that doesn't match within this window is counted as a duplicate.
+ */
+constexpr int MATCH_WINDOW = 32;
+
+} // namespace
+
+/**
+ * Sustained typing benchmark for the keyboard grab path.
+ *
+ * Drives a steady stream of wl_keyboard.key press/release pairs through the
+ * grabbed keyboard at a fixed rate and matches every commit arriving from
+ * plasma-keyboard against the keys sent, reporting throughput, dropped and
+ * duplicated characters and per-key latency.
+ *
+ * Dropped or duplicated characters fail the test; the timings are logged for
+ * comparison between runs. On CI only the lowest rate is run, and the test is
+ * labelled "benchmark" so that it can be left out with `ctest -LE benchmark`.
+ */
+class TypingBenchmark : public MockCompositorTestBase
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase()
+    {
+        setUpHome();
+
+        {
+            KConfig cfg(QStringLiteral("plasmakeyboardrc"));
+            KConfigGroup grp(&cfg, QStringLiteral("General"));
+            // Keep diacritics enabled so letters with alternates go through the long-press
+            // pipeline, but make sure the hold threshold is never reached.
+            grp.writeEntry(QStringLiteral("diacriticsHoldThresholdMs"), 1500);
+        }
+
+        startCompositor();
+    }
+
+    void cleanup()
+    {
+        drainEvents();
+    }
+
+    void cleanupTestCase()
+    {
+        stopCompositor();
+    }
+
+    void benchmarkSustainedTyping_data()
+    {
+        QTest::addColumn<int>("keysPerSecond");
+        QTest::addColumn<int>("keyCount");
+
+        QTest::newRow("500 keys/s") << 500 << 1000;
+        QTest::newRow("2000 keys/s") << 2000 << 4000;
+        QTest::newRow("5000 keys/s") << 5000 << 10000;
+    }
+
+    void benchmarkSustainedTyping()
+    {
+        QFETCH(int, keysPerSecond);
+        QFETCH(int, keyCount);
+
+        // Shared CI runners cannot reliably keep up with the higher rates.
+        if (RUNNING_IN_CI && keysPerSecond > 500) {
+            QSKIP("Only the lowest rate is run on CI");
+        }
+
+        auto *context = m_inputMethod->context();
+        QVERIFY(context);
+        auto *keyboard = context->keyboard();
+        QVERIFY(keyboard);
+
+        QString expected;
+        expected.reserve(keyCount);
+        QList<qint64> sentAtNs(keyCount);
+        QList<qint64> latenciesNs;
+        latenciesNs.reserve(keyCount);
+
+        int sent = 0;
+        int nextExpected = 0;
+        int dropped = 0;
+        int duplicated = 0;
+        qint64 lastCommitNs = 0;
+
+        QElapsedTimer clock;
+        auto connection = connect(context, &InputMethodContext::commitStringChanged, this, [&](const QString &text) {
+            const qint64 now = clock.nsecsElapsed();
+            const int windowEnd = std::min(sent, nextExpected + MATCH_WINDOW);
+            int match = nextExpected;
+            while (match < windowEnd && (text.size() != 1 || expected.at(match) != text.front())) {
+                ++match;
+            }
+            if (match >= windowEnd) {
+                ++duplicated;
+                return;
+            }
+            dropped += match - nextExpected;
+            latenciesNs.append(now - sentAtNs[match]);
+            nextExpected = match + 1;
+            lastCommitNs = now;
+        });
+
+        // Send every key that is due, then give the event loop a turn so
+        // that requests from plasma-keyboard are dispatched while typing.
+        const qint64 intervalNs = 1'000'000'000LL / keysPerSecond;
+        clock.start();
+        while (sent < keyCount) {
+            const qint64 now = clock.nsecsElapsed();
+            while (sent < keyCount && sent * intervalNs <= now) {
+                const BenchmarkKey &key = BENCHMARK_TEXT[sent % BENCHMARK_TEXT.size()];
+                expected.append(QChar(key.text));
+                // Measure from when the key is actually sent, not from when it
+                // was due, so that falling behind schedule is not counted as latency.
+                sentAtNs[sent] = clock.nsecsElapsed();
+                ++sent;
+                keyboard->sendKey(key.scancode, WL_KEYBOARD_KEY_STATE_PRESSED);
+                keyboard->sendKey(key.scancode, WL_KEYBOARD_KEY_STATE_RELEASED);
+            }
+            wl_display_flush_clients(m_compositor->display());
+            QTest::qWait(1);
+        }
+
+        QTest::qWaitFor(
+            [&] {
+                return nextExpected == keyCount;
+            },
+            RUNNING_IN_CI ? 30000 : 10000);
+        disconnect(connection);
+        dropped += keyCount - nextExpected;
+
+        QVERIFY(!latenciesNs.isEmpty());
+        std::sort(latenciesNs.begin(), latenciesNs.end());
+        const auto percentileUs = [&latenciesNs](int percent) {
+            const qsizetype index = std::min(latenciesNs.size() - 1, latenciesNs.size() * percent / 100);
+            return latenciesNs.at(index) / 1000;
+        };
+        const double throughput = lastCommitNs > 0 ? latenciesNs.size() * 1e9 / lastCommitNs : 0;
+
+        qInfo().nospace() << "offered " << keysPerSecond << " keys/s: committed " << latenciesNs.size() << "/" << keyCount << " at " << qRound(throughput)
+                          << " keys/s, dropped " << dropped << ", duplicated " << duplicated << ", latency p50 " << percentileUs(50) << "us p99 "
+                          << percentileUs(99) << "us max " << latenciesNs.last() / 1000 << "us";
+
+        QCOMPARE(dropped, 0);
+        QCOMPARE(duplicated, 0);
+    }
+};
+
+QTEST_MAIN(TypingBenchmark)
+
+#include "typingbenchmark.moc"
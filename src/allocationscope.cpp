@@ -0,0 +1,14 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "allocationscope.h"
+
+#include <dlfcn.h>
+
+const AllocationScope::Hooks AllocationScope::s_hooks = {
+    reinterpret_cast<void (*)()>(dlsym(RTLD_DEFAULT, "plasma_keyboard_allocation_scope_enter")),
+    reinterpret_cast<void (*)()>(dlsym(RTLD_DEFAULT, "plasma_keyboard_allocation_scope_leave")),
+};
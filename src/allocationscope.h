@@ -0,0 +1,43 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QtGlobal>
+
+/**
+ * Marks code that is expected to run without heap allocations.
+ *
+ * The key allocation test preloads a library that counts allocations made
+ * on a thread while it is inside such a scope. The library's hooks are
+ * looked up once at startup; without it a scope costs a null check.
+ */
+class AllocationScope
+{
+public:
+    AllocationScope()
+    {
+        if (Q_UNLIKELY(s_hooks.enter)) {
+            s_hooks.enter();
+        }
+    }
+
+    ~AllocationScope()
+    {
+        if (Q_UNLIKELY(s_hooks.leave)) {
+            s_hooks.leave();
+        }
+    }
+
+private:
+    Q_DISABLE_COPY_MOVE(AllocationScope)
+
+    struct Hooks {
+        void (*enter)();
+        void (*leave)();
+    };
+    static const Hooks s_hooks;
+};
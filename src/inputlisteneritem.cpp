@@ -16,6 +16,7 @@
 #include "overlay/prefixquerytrigger.h"
 #include "overlay/textexpansiontrigger.h"
 
+#include <QKeyEvent>
 #include <QLoggingCategory>
 #include <QTextFormat>
 
@@ -50,14 +51,27 @@ InputListenerItem::InputListenerItem()
     : m_input(&(*s_im))
     , m_overlayController(new OverlayController(&m_input, this))
 {
-    // Grab and listen to physical keyboard input
-    m_input.setGrabbing(true);
+    m_surroundingTextUpdateTimer.setSingleShot(true);
+    m_surroundingTextUpdateTimer.setInterval(0);
+    connect(&m_surroundingTextUpdateTimer, &QTimer::timeout, this, &InputListenerItem::flushSurroundingText);
 
     // Register overlay triggers
     m_overlayController->registerTrigger(new LongPressTrigger(m_overlayController));
     m_overlayController->registerTrigger(new PrefixQueryTrigger(m_overlayController));
     m_overlayController->registerTrigger(new TextExpansionTrigger(m_overlayController));
 
+    // Grab and listen to physical keyboard input, as long as a feature needs it
+    updateGrabbing();
+    connect(m_overlayController, &OverlayController::needsKeyboardGrabChanged, this, &InputListenerItem::updateGrabbing);
+    connect(PlasmaKeyboardSettings::self(), &PlasmaKeyboardSettings::keyboardNavigationEnabledChanged, this, &InputListenerItem::updateGrabbing);
+
+    // Let keys nobody here would look at skip the GUI thread
+    updateKeyPassThrough();
+    connect(m_overlayController, &OverlayController::overlayVisibleChanged, this, &InputListenerItem::updateKeyPassThrough);
+    connect(m_overlayController, &OverlayController::pendingTextChanged, this, &InputListenerItem::updateKeyPassThrough);
+    connect(m_overlayController, &OverlayController::needsKeyboardGrabChanged, this, &InputListenerItem::updateKeyPassThrough);
+    connect(PlasmaKeyboardSettings::self(), &PlasmaKeyboardSettings::keyboardNavigationEnabledChanged, this, &InputListenerItem::updateKeyPassThrough);
+
     connect(&m_input, &InputPlugin::contextChanged, this, [this] {
         const bool hasContext = m_input.hasContext();
 
@@ -68,6 +82,7 @@ InputListenerItem::InputListenerItem()
 
         if (hasContext) {
             QGuiApplication::inputMethod()->update(Qt::ImQueryAll);
+            Q_EMIT inputPanelRequested();
             QGuiApplication::inputMethod()->show();
         } else {
             QGuiApplication::inputMethod()->setVisible(false);
@@ -77,21 +92,25 @@ InputListenerItem::InputListenerItem()
         // Notify the overlay controller first so it can cancel the overlay if an
         // external cursor movement is detected (e.g. user tapped elsewhere in the
         // text field while the diacritics overlay was open or the hold timer was
-        // still running). The controller uses an internal counter to distinguish
-        // its own commit_string echoes from external cursor moves.
+        // still running). The controller compares the new text against the
+        // edits it sent to tell its own echoes from external cursor moves.
         if (m_overlayController) {
             m_overlayController->handleSurroundingTextChanged();
+            // Text typed at the cursor may have started or ended a trigger's interest in keys
+            updateKeyPassThrough();
         }
 
         if (m_input.hasContext()) {
             // Re-activate when text input activates, and there is context
             if (!window()->isVisible()) {
+                Q_EMIT inputPanelRequested();
                 QGuiApplication::inputMethod()->setVisible(true);
             }
 
-            // Update vkbd input method only if the virtual keyboard panel is shown
-            if (window()->isExposed()) {
-                QGuiApplication::inputMethod()->update(Qt::ImSurroundingText);
+            // Clients often send several surrounding_text events per commit;
+            // only the last one of a burst is pushed to the vkbd input method.
+            if (!m_surroundingTextUpdateTimer.isActive()) {
+                m_surroundingTextUpdateTimer.start();
             }
         }
     });
@@ -106,60 +125,7 @@ InputListenerItem::InputListenerItem()
         window()->setVisible(QGuiApplication::inputMethod()->isVisible());
     });
 
-    connect(&m_input, &InputPlugin::keyPressed, this, [this](QKeyEvent *keyEvent) {
-        // qCDebug(PlasmaKeyboard) << "keyPressed. keycode:" << keyEvent->key() << "text:" << keyEvent->text() << "modifiers:" << keyEvent->modifiers();
-
-        // Delegate to overlay controller for diacritics/emoji/text expansion
-        if (m_overlayController && m_overlayController->processKeyPress(keyEvent)) {
-            keyEvent->accept();
-            return;
-        }
-        // The window can have isVisible() = true, but not be shown by the compositor if the input panel is suppressed
-        if (!window()->isExposed()) {
-            return;
-        }
-
-        if (PlasmaKeyboardSettings::self()->keyboardNavigationEnabled()) {
-            // Keys to capture for keyboard navigation
-            const auto keys = m_keyboardNavigationActive ? *KEYBOARD_NAVIGATION_ACTIVE_CAPTURE_KEYS : *KEYBOARD_NAVIGATION_CAPTURE_KEYS;
-
-            // Forward and accept keyboard navigation events
-            for (const auto key : keys) {
-                if (keyEvent->key() == key) {
-                    keyEvent->accept();
-                    Q_EMIT keyNavigationPressed(key);
-                    break;
-                }
-            }
-        }
-    });
-    connect(&m_input, &InputPlugin::keyReleased, this, [this](QKeyEvent *keyEvent) {
-        // qCDebug(PlasmaKeyboard) << "keyReleased. keycode:" << keyEvent->key() << "text:" << keyEvent->text();
-
-        // Let the overlay controller handle release events (e.g. diacritics, emoji)
-        if (m_overlayController && m_overlayController->processKeyRelease(keyEvent)) {
-            keyEvent->accept();
-            return;
-        }
-        // The window can have isVisible() = true, but not be shown by the compositor if the input panel is suppressed
-        if (!window()->isExposed()) {
-            return;
-        }
-
-        if (PlasmaKeyboardSettings::self()->keyboardNavigationEnabled()) {
-            // Keys to capture for keyboard navigation
-            const auto keys = m_keyboardNavigationActive ? *KEYBOARD_NAVIGATION_ACTIVE_CAPTURE_KEYS : *KEYBOARD_NAVIGATION_CAPTURE_KEYS;
-
-            // Forward and accept keyboard navigation events
-            for (const auto key : keys) {
-                if (keyEvent->key() == key) {
-                    keyEvent->accept();
-                    Q_EMIT keyNavigationReleased(key);
-                    break;
-                }
-            }
-        }
-    });
+    m_input.setKeySink(this);
 
     // Don't hook into the &InputPlugin::receivedCommit signal and call setVisible(true)
     // -> it can cause a race condition as receivedCommit is emitted when the text field loses focus.
@@ -182,6 +148,61 @@ InputListenerItem::InputListenerItem()
     QGuiApplication::inputMethod()->update(Qt::ImQueryAll);
 }
 
+bool InputListenerItem::handleKey(const KeyRecord &key)
+{
+    // qCDebug(PlasmaKeyboard) << "handleKey. keycode:" << key.qtKey << "text:" << key.text() << "modifiers:" << key.modifiers << "pressed:" << key.isPress();
+    bool handled = false;
+
+    // Delegate to overlay controller for diacritics/emoji/text expansion
+    if (m_overlayController && (key.isPress() ? m_overlayController->processKeyPress(key) : m_overlayController->processKeyRelease(key))) {
+        handled = true;
+    } else if (window()->isExposed() && PlasmaKeyboardSettings::self()->keyboardNavigationEnabled()) {
+        // The window can have isVisible() = true, but not be shown by the compositor if the input panel is suppressed
+
+        // Keys to capture for keyboard navigation
+        const QList<Qt::Key> &keys = m_keyboardNavigationActive ? *KEYBOARD_NAVIGATION_ACTIVE_CAPTURE_KEYS : *KEYBOARD_NAVIGATION_CAPTURE_KEYS;
+
+        // Forward and accept keyboard navigation events
+        for (const auto captured : keys) {
+            if (key.qtKey == captured) {
+                handled = true;
+                if (key.isPress()) {
+                    Q_EMIT keyNavigationPressed(captured);
+                } else {
+                    Q_EMIT keyNavigationReleased(captured);
+                }
+                break;
+            }
+        }
+    }
+
+    // The overlay controller may have started or ended an overlay, a hold or a compose sequence
+    updateKeyPassThrough();
+    return handled;
+}
+
+void InputListenerItem::flushSurroundingText()
+{
+    // Update vkbd input method only if the virtual keyboard panel is shown
+    if (m_input.hasContext() && window()->isExposed()) {
+        QGuiApplication::inputMethod()->update(Qt::ImSurroundingText);
+    }
+}
+
+void InputListenerItem::updateGrabbing()
+{
+    const bool grabbing = m_overlayController->needsKeyboardGrab() || PlasmaKeyboardSettings::self()->keyboardNavigationEnabled();
+    qCDebug(PlasmaKeyboard) << "InputListenerItem: Keyboard grab" << (grabbing ? "needed" : "not needed");
+    m_input.setGrabbing(grabbing);
+}
+
+void InputListenerItem::updateKeyPassThrough()
+{
+    // Keyboard navigation captures arrow keys, which type no text.
+    const bool passThrough = !m_overlayController->wantsTextlessKeys() && !PlasmaKeyboardSettings::self()->keyboardNavigationEnabled();
+    m_input.setTextlessKeysPassThrough(passThrough);
+}
+
 OverlayController *InputListenerItem::overlayController() const
 {
     return m_overlayController;
@@ -281,36 +302,21 @@ QVariant InputListenerItem::inputMethodQuery(Qt::InputMethodQuery query) const
         }
         return QVariant::fromValue<int>(qtHints);
     }
+    // The protocol positions are UTF-8 byte offsets; the *CharPos() accessors
+    // convert them through an index cached with the surrounding text.
     case Qt::ImCurrentSelection: {
-        // cursorPos and anchorPos are in bytes, we need to convert QString to QByteArray for index operations
-        QByteArray surroundingText = m_input.surroundingText().toUtf8();
-        int start = qMin(m_input.cursorPos(), m_input.anchorPos());
-        int end = qMax(m_input.cursorPos(), m_input.anchorPos());
-        return QString::fromUtf8(surroundingText.mid(start, end - start));
-    }
-    case Qt::ImAnchorPosition: {
-        // anchorPos is in bytes, we need to convert QString to QByteArray for index operations
-        QByteArray surroundingText = m_input.surroundingText().toUtf8();
-        int anchorBytes = qBound(0, int(m_input.anchorPos()), surroundingText.size());
-        return QString::fromUtf8(surroundingText.first(anchorBytes)).length();
-    }
-    case Qt::ImCursorPosition: {
-        // cursorPos is in bytes, we need to convert QString to QByteArray for index operations
-        QByteArray surroundingText = m_input.surroundingText().toUtf8();
-        int cursorBytes = qBound(0, int(m_input.cursorPos()), surroundingText.size());
-        return QString::fromUtf8(surroundingText.first(cursorBytes)).length();
-    }
-    case Qt::ImTextBeforeCursor: {
-        // cursorPos is in bytes, we need to convert QString to QByteArray for index operations
-        QByteArray surroundingText = m_input.surroundingText().toUtf8();
-        int cursorBytes = qBound(0, int(m_input.cursorPos()), surroundingText.size());
-        return QString::fromUtf8(surroundingText.first(cursorBytes));
-    }
-    case Qt::ImTextAfterCursor: {
-        // cursorPos is in bytes, we need to convert QString to QByteArray for index operations
-        QByteArray surroundingText = m_input.surroundingText().toUtf8();
-        return QString::fromUtf8(surroundingText.mid(m_input.cursorPos()));
+        const int start = qMin(m_input.cursorCharPos(), m_input.anchorCharPos());
+        const int end = qMax(m_input.cursorCharPos(), m_input.anchorCharPos());
+        return m_input.surroundingText().mid(start, end - start);
     }
+    case Qt::ImAnchorPosition:
+        return m_input.anchorCharPos();
+    case Qt::ImCursorPosition:
+        return m_input.cursorCharPos();
+    case Qt::ImTextBeforeCursor:
+        return m_input.surroundingText().first(m_input.cursorCharPos());
+    case Qt::ImTextAfterCursor:
+        return m_input.surroundingText().mid(m_input.cursorCharPos());
     case Qt::ImCursorRectangle:
     case Qt::ImFont:
     case Qt::ImMaximumTextLength:
@@ -359,6 +365,9 @@ void InputListenerItem::keyReleaseEvent(QKeyEvent *event)
         } else {
             // If we have text coming as a key event, use it to commit the string
             m_input.commit(event->text());
+            if (m_overlayController) {
+                m_overlayController->processTextCommitted(event->text());
+            }
         }
     }
 }
@@ -374,29 +383,39 @@ void InputListenerItem::inputMethodEvent(QInputMethodEvent *event)
 
     QString commit = event->commitString();
     QString preedit = event->preeditString();
+
+    // Everything below is one edit of the text field; send it in one go.
+    InputPlugin::Batch batch(&m_input);
+
     bool needsReplacement = event->replacementStart() != 0 || event->replacementLength() != 0;
+    // UTF-16 code units deleted right before the cursor, -1 if the deleted range is elsewhere
+    int deletedBeforeCursor = 0;
 
     // Delete characters that are supposed to be replaced
     if (needsReplacement) {
         // The positions we send to need to be in bytes (to support UTF8)
-        QString surroundingText = m_input.surroundingText();
-        QByteArray surroundingUtf8 = surroundingText.toUtf8();
-        int boundedCursorBytes = qBound(0, int(m_input.cursorPos()), surroundingUtf8.size());
-        int cursorChars = QString::fromUtf8(surroundingUtf8.first(boundedCursorBytes)).size();
-        int startChars = qBound(0, cursorChars + event->replacementStart(), surroundingText.size());
-        int endChars = qBound(startChars, startChars + event->replacementLength(), surroundingText.size());
+        const int textLength = m_input.surroundingText().size();
+        int cursorChars = m_input.cursorCharPos();
+        int cursorBytes = m_input.surroundingTextBytePos(cursorChars);
+        int startChars = qBound(0, cursorChars + event->replacementStart(), textLength);
+        int endChars = qBound(startChars, startChars + event->replacementLength(), textLength);
+        deletedBeforeCursor = endChars == cursorChars ? endChars - startChars : -1;
 
-        int startBytes = surroundingText.first(startChars).toUtf8().size();
-        int endBytes = surroundingText.first(endChars).toUtf8().size();
+        int startBytes = m_input.surroundingTextBytePos(startChars);
+        int endBytes = m_input.surroundingTextBytePos(endChars);
 
         if (endBytes > startBytes) {
-            m_input.deleteSurroundingText(startBytes - boundedCursorBytes, endBytes - startBytes);
+            m_input.deleteSurroundingText(startBytes - cursorBytes, endBytes - startBytes);
         }
     }
 
     // Commit string if there is something to commit, or we did a replacement
     if (needsReplacement || !commit.isEmpty()) {
         m_input.commit(commit);
+        // Edits elsewhere reach the overlay controller through the client's surrounding text.
+        if (m_overlayController && deletedBeforeCursor >= 0) {
+            m_overlayController->processTextCommitted(commit, deletedBeforeCursor);
+        }
     }
 
     // Set attributes for style (ex. needed for CJK)
@@ -427,6 +446,11 @@ void InputListenerItem::inputMethodEvent(QInputMethodEvent *event)
 
     // Send currently being edited string
     m_input.setPreEditString(preedit);
+
+    if (m_overlayController) {
+        m_overlayController->processPreeditChanged(preedit);
+        updateKeyPassThrough();
+    }
 }
 
 #include "moc_inputlisteneritem.cpp"
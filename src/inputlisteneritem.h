@@ -10,16 +10,18 @@
 
 #include <QQuickItem>
 #include <QQuickWindow>
+#include <QTimer>
 #include <QVirtualKeyboardInputEngine>
 #include <qqmlintegration.h>
 
 #include <xkbcommon/xkbcommon.h>
 
 #include "inputplugin.h"
+#include "keyrecord.h"
 
 class OverlayController;
 
-class InputListenerItem : public QQuickItem
+class InputListenerItem : public QQuickItem, public KeySink
 {
     Q_OBJECT
     QML_ELEMENT
@@ -45,6 +47,11 @@ public:
     void keyReleaseEvent(QKeyEvent *event) override;
     void inputMethodEvent(QInputMethodEvent *event) override;
 
+    /**
+     * Handle a key of the grabbed physical keyboard.
+     */
+    bool handleKey(const KeyRecord &key) override;
+
     /**
      * Get the overlay controller.
      */
@@ -54,8 +61,24 @@ Q_SIGNALS:
     void keyNavigationPressed(int key);
     void keyNavigationReleased(int key);
 
+    /**
+     * Emitted right before the input panel is asked to show, so that a
+     * lazily created panel can be created first.
+     */
+    void inputPanelRequested();
+
 private:
+    void flushSurroundingText();
+    void updateGrabbing();
+    void updateKeyPassThrough();
+
     InputPlugin m_input;
     OverlayController *m_overlayController = nullptr;
     bool m_keyboardNavigationActive = false;
+
+    /**
+     * Coalesces bursts of surrounding_text events so that Qt VirtualKeyboard
+     * only sees the latest state, once per event-loop turn.
+     */
+    QTimer m_surroundingTextUpdateTimer;
 };
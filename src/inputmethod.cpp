@@ -5,16 +5,25 @@
 */
 
 #include "inputmethod_p.h"
+#include "allocationscope.h"
+#include "inputthread.h"
+#include "latencytracer.h"
 #include "logging.h"
+#include "plasmakeyboardsettings.h"
+#include "startupprofiler.h"
 
 #include <QDateTime>
 #include <QDebug>
 #include <QGuiApplication>
 #include <QInputMethod>
-#include <QKeyEvent>
 #include <QStandardPaths>
+#include <QStringDecoder>
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <fcntl.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
 #include <unistd.h>
 
@@ -32,13 +41,25 @@ InputMethod::InputMethod()
             }
         },
         Qt::QueuedConnection);
+
+    if (PlasmaKeyboardSettings::self()->inputThreadEnabled()) {
+        if (auto waylandApp = qGuiApp->nativeInterface<QNativeInterface::QWaylandApplication>()) {
+            m_inputThread = std::make_unique<InputThread>(waylandApp->display());
+            m_inputThread->start();
+            // Stop reading from the connection before Qt closes it.
+            connect(qGuiApp, &QCoreApplication::aboutToQuit, this, [this] {
+                m_inputThread->stop();
+            });
+        }
+    }
 }
 
 InputMethod::~InputMethod() = default;
 
 void InputMethod::zwp_input_method_v1_activate(struct ::zwp_input_method_context_v1 *id)
 {
-    setCurrentContext(new InputMethodContext(id));
+    StartupProfiler::mark("first zwp_input_method_v1_activate");
+    setCurrentContext(new InputMethodContext(id, m_inputThread.get()));
 }
 
 void InputMethod::zwp_input_method_v1_deactivate(struct ::zwp_input_method_context_v1 *context)
@@ -61,8 +82,9 @@ void InputMethod::setCurrentContext(InputMethodContext *context)
         Q_EMIT deactivate();
 }
 
-InputMethodContext::InputMethodContext(struct ::zwp_input_method_context_v1 *id)
+InputMethodContext::InputMethodContext(struct ::zwp_input_method_context_v1 *id, InputThread *inputThread)
     : QtWayland::zwp_input_method_context_v1(id)
+    , m_inputThread(inputThread)
 {
 }
 
@@ -93,7 +115,7 @@ void InputMethodContext::zwp_input_method_context_v1_preferred_language(const QS
 
 void InputMethodContext::zwp_input_method_context_v1_surrounding_text(const QString &text, uint32_t cursor, uint32_t anchor)
 {
-    m_text = text;
+    m_surroundingText.setText(text);
     m_cursor = cursor;
     m_anchor = anchor;
     Q_EMIT surroundingTextChanged(text, cursor, anchor);
@@ -103,29 +125,81 @@ void InputMethodContext::zwp_input_method_context_v1_invoke_action(uint32_t butt
 {
 }
 
-std::shared_ptr<Keyboard> InputMethodContext::keyboard()
+std::shared_ptr<Keyboard> InputMethodContext::keyboard(const std::shared_ptr<Keyboard> &retained)
 {
     if (auto existing = m_keyboard.lock()) {
         return existing;
     }
 
-    auto wlKeyboard = grab_keyboard();
-    auto keyboard = std::make_shared<Keyboard>(wlKeyboard, this);
+    // Keep the input thread from dispatching the new keyboard's first events,
+    // the keymap in particular, before its listener is set up.
+    QMutexLocker locker(m_inputThread ? m_inputThread->dispatchMutex() : nullptr);
+    auto wlKeyboard = m_inputThread ? m_inputThread->grabKeyboard(object()) : grab_keyboard();
+    std::shared_ptr<Keyboard> keyboard;
+    if (retained) {
+        retained->rebind(wlKeyboard, this);
+        keyboard = retained;
+    } else {
+        keyboard = std::make_shared<Keyboard>(wlKeyboard, this, m_inputThread);
+    }
     m_keyboard = keyboard;
     return keyboard;
 }
 
-Keyboard::Keyboard(::wl_keyboard *keyboard, InputMethodContext *parent)
+Keyboard::Keyboard(::wl_keyboard *keyboard, InputMethodContext *parent, InputThread *inputThread)
     : wl_keyboard(keyboard)
     , m_parent(parent)
+    , m_inputThread(inputThread)
 {
-    mXkbContext.reset(xkb_context_new(XKB_CONTEXT_NO_FLAGS));
+    if (m_inputThread) {
+        m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        m_wakeNotifier = new QSocketNotifier(m_wakeFd, QSocketNotifier::Read, this);
+        connect(m_wakeNotifier, &QSocketNotifier::activated, this, &Keyboard::drainKeys);
+    }
 }
 
 Keyboard::~Keyboard()
 {
     // needs version guarding, and the versioning here is messed up here, unless we're in sync with seat :/
     //        release();
+    // Destroying the proxy only stops its events from being dispatched to us.
+    QMutexLocker locker(m_inputThread ? m_inputThread->dispatchMutex() : nullptr);
+    if (isInitialized()) {
+        wl_keyboard_destroy(object());
+    }
+    locker.unlock();
+
+    delete m_wakeNotifier;
+    if (m_wakeFd >= 0) {
+        close(m_wakeFd);
+    }
+}
+
+void Keyboard::rebind(::wl_keyboard *keyboard, InputMethodContext *parent)
+{
+    if (isInitialized()) {
+        wl_keyboard_destroy(object());
+    }
+    init(keyboard);
+    m_parent = parent;
+    ++m_generation;
+}
+
+void Keyboard::unbind()
+{
+    QMutexLocker locker(m_inputThread ? m_inputThread->dispatchMutex() : nullptr);
+    m_parent = nullptr;
+    ++m_generation;
+}
+
+void Keyboard::setKeySink(KeySink *sink)
+{
+    m_sink = sink;
+}
+
+void Keyboard::setTextlessKeysPassThrough(bool passThrough)
+{
+    m_textlessKeysPassThrough = passThrough;
 }
 
 void Keyboard::keyboard_keymap(uint32_t format, int32_t fd, uint32_t size)
@@ -142,12 +216,17 @@ void Keyboard::keyboard_keymap(uint32_t format, int32_t fd, uint32_t size)
         return;
     }
 
-    mXkbKeymap.reset(xkb_keymap_new_from_string(mXkbContext.get(), map_str, XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS));
-    QXkbCommon::verifyHasLatinLayout(mXkbKeymap.get());
+    // The compositor sends the same keymap on every grab; compile it only once.
+    KeymapPtr keymap = XkbCache::keymap(QByteArrayView(map_str, size));
 
     munmap(map_str, size);
     close(fd);
 
+    // A re-bound keyboard usually gets the keymap it already has.
+    if (keymap && keymap == mXkbKeymap && mXkbState) {
+        return;
+    }
+    mXkbKeymap = keymap;
     if (mXkbKeymap)
         mXkbState.reset(xkb_state_new(mXkbKeymap.get()));
     else
@@ -156,44 +235,197 @@ void Keyboard::keyboard_keymap(uint32_t format, int32_t fd, uint32_t size)
 
 void Keyboard::keyboard_key(uint32_t serial, uint32_t time, uint32_t key, uint32_t state)
 {
-    // Store the serial and time from the compositor so they can be used later
-    // by InputPlugin::key() for synthetic key event forwarding.
-    m_parent->m_lastKeyboardSerial = serial;
-    m_parent->m_lastKeyboardTime = time;
+    if (!m_parent) {
+        return;
+    }
 
-    auto code = key + 8; // map to wl_keyboard::keymap_format::keymap_format_xkb_v1
+    if (!m_inputThread) {
+        LatencyTracer::beginKey();
+        KeyRecord record;
+        {
+            AllocationScope scope;
+            record = lookupKey(serial, time, key, state);
+        }
+        LatencyTracer::mark(LatencyTracer::Stage::Lookup);
+        handleKey(record);
+        return;
+    }
+
+    // On the input thread. Keys without text are not looked at on the GUI
+    // side while it is idle, unless they may start a compose sequence; they
+    // can go to the client right away, unless keys sent to the GUI thread
+    // earlier have not been forwarded yet.
+    LatencyTracer::beginKey();
+    KeyQueueEntry entry;
+    entry.generation = m_generation.load(std::memory_order_relaxed);
+    bool passThrough;
+    {
+        AllocationScope scope;
+        entry.key = lookupKey(serial, time, key, state);
+        const xkb_keysym_t sym = entry.key.keysym;
+        const bool startsCompose = sym == XKB_KEY_Multi_key || (sym >= XKB_KEY_dead_grave && sym <= XKB_KEY_dead_longsolidusoverlay);
+        passThrough = !entry.key.hasText && !startsCompose && m_textlessKeysPassThrough && m_keyQueue.isIdle();
+    }
+    LatencyTracer::mark(LatencyTracer::Stage::Lookup);
+    if (passThrough) {
+        forward(entry);
+        LatencyTracer::mark(LatencyTracer::Stage::Forward);
+        LatencyTracer::endKey();
+        return;
+    }
+    entry.trace = LatencyTracer::suspendKey();
+    enqueue(entry);
+}
+
+void Keyboard::keyboard_modifiers(uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked, uint32_t group)
+{
+    if (!m_parent) {
+        return;
+    }
+
+    xkb_state_update_mask(mXkbState.get(), mods_depressed, mods_latched, mods_locked, 0, 0, group);
 
-    xkb_keysym_t sym = xkb_state_key_get_one_sym(mXkbState.get(), code);
+    KeyQueueEntry entry;
+    entry.type = KeyQueueEntry::Type::Modifiers;
+    entry.generation = m_generation.load(std::memory_order_relaxed);
+    entry.serial = serial;
+    entry.modsDepressed = mods_depressed;
+    entry.modsLatched = mods_latched;
+    entry.modsLocked = mods_locked;
+    entry.group = group;
+
+    // currently not filterable, but must not overtake keys still on their
+    // way through the GUI thread
+    if (m_inputThread && !m_keyQueue.isIdle()) {
+        enqueue(entry);
+        return;
+    }
+    forward(entry);
+}
 
-    auto modifiers = QXkbCommon::modifiers(mXkbState.get());
-    int qtkey = QXkbCommon::keysymToQtKey(sym, modifiers, mXkbState.get(), code);
-    QString text = QXkbCommon::lookupString(mXkbState.get(), code);
+/**
+ * QXkbCommon::keysymToQtKey() maps keysyms of characters beyond Latin-1 by
+ * looking their text up into a QString and upper-casing it. The character is
+ * known already, so map those the same way without the allocations.
+ */
+static int keysymToQtKey(xkb_keysym_t sym, Qt::KeyboardModifiers modifiers, xkb_state *state, xkb_keycode_t code, char32_t utf32)
+{
+    const bool mappedThroughText = (sym > 0xff && sym < 0xfd00) || (sym >= 0x01000100 && sym <= 0x0110ffff);
+    if (!mappedThroughText || !utf32 || (modifiers & Qt::ControlModifier)) {
+        return QXkbCommon::keysymToQtKey(sym, modifiers, state, code);
+    }
+    if (QChar::isDigit(utf32)) {
+        // Also non-latin digits map to the Qt::Key_0 … Qt::Key_9 keys.
+        return Qt::Key_0 + QChar::digitValue(utf32);
+    }
+    return int(QChar::toUpper(utf32));
+}
 
-    // wl_keyboard::key_state: 0 = released, 1 = pressed, 2 = repeated (since v10).
-    // Repeated is semantically a press with auto-repeat.
-    const bool isRepeat = (state == 2);
-    QEvent::Type type = (state == 0) ? QEvent::KeyRelease : QEvent::KeyPress;
+KeyRecord Keyboard::lookupKey(uint32_t serial, uint32_t time, uint32_t key, uint32_t state) const
+{
+    KeyRecord record;
+    record.scancode = key;
+    record.state = KeyRecord::State(state);
+    record.serial = serial;
+    record.time = time;
 
-    QKeyEvent keyEvent(type, qtkey, modifiers, key, sym, 0, text, isRepeat);
-    keyEvent.setAccepted(false);
+    auto code = key + 8; // map to wl_keyboard::keymap_format::keymap_format_xkb_v1
 
-    if (type == QEvent::KeyPress) {
-        Q_EMIT keyPressed(&keyEvent);
-    } else {
-        Q_EMIT keyReleased(&keyEvent);
+    record.keysym = xkb_state_key_get_one_sym(mXkbState.get(), code);
+    record.modifiers = QXkbCommon::modifiers(mXkbState.get());
+    record.utf32 = xkb_state_key_get_utf32(mXkbState.get(), code);
+
+    // Keys may type several code points at once, e.g. a grapheme cluster;
+    // decode their text through buffers on the stack.
+    char utf8[64];
+    const int utf8Length = xkb_state_key_get_utf8(mXkbState.get(), code, utf8, sizeof(utf8));
+    record.hasText = utf8Length > 0;
+    if (record.hasText && utf8Length < int(sizeof(utf8))) {
+        // UTF-16 never takes more code units than UTF-8 takes bytes.
+        QChar utf16[sizeof(utf8)];
+        QStringDecoder decoder(QStringDecoder::Utf8, QStringDecoder::Flag::Stateless);
+        const qsizetype utf16Length = decoder.appendToBuffer(utf16, QByteArrayView(utf8, utf8Length)) - utf16;
+        if (utf16Length <= KeyRecord::kMaxTextLength) {
+            std::copy_n(reinterpret_cast<const char16_t *>(utf16), utf16Length, record.textData);
+            record.textLength = quint8(utf16Length);
+        }
     }
+    record.qtKey = keysymToQtKey(record.keysym, record.modifiers, mXkbState.get(), code, record.utf32);
+    return record;
+}
 
-    if (!keyEvent.isAccepted()) {
-        m_parent->key(serial, time, key, state);
+void Keyboard::enqueue(const KeyQueueEntry &entry)
+{
+    bool wasIdle = false;
+    if (!m_keyQueue.push(entry, &wasIdle)) {
+        // The GUI thread is hopelessly behind; better out of order than lost.
+        qCWarning(PlasmaKeyboard) << "Keyboard: Key queue full, forwarding directly";
+        forward(entry);
+        return;
+    }
+    if (wasIdle) {
+        const uint64_t one = 1;
+        if (write(m_wakeFd, &one, sizeof(one)) < 0) {
+            qCWarning(PlasmaKeyboard) << "Keyboard: Failed to wake up the GUI thread:" << strerror(errno);
+        }
     }
 }
 
-void Keyboard::keyboard_modifiers(uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked, uint32_t group)
+void Keyboard::drainKeys()
 {
-    xkb_state_update_mask(mXkbState.get(), mods_depressed, mods_latched, mods_locked, 0, 0, group);
+    uint64_t wakeups;
+    if (read(m_wakeFd, &wakeups, sizeof(wakeups)) < 0 && errno != EAGAIN) {
+        qCWarning(PlasmaKeyboard) << "Keyboard: Failed to read wake-ups:" << strerror(errno);
+    }
 
-    // currently not filterable
-    m_parent->modifiers(serial, mods_depressed, mods_latched, mods_locked, group);
+    KeyQueueEntry entry;
+    while (m_keyQueue.pop(&entry)) {
+        // Keys of a previous grab must not reach the current context.
+        if (m_parent && entry.generation == m_generation.load(std::memory_order_relaxed)) {
+            if (entry.type == KeyQueueEntry::Type::Key) {
+                LatencyTracer::resumeKey(entry.trace);
+                LatencyTracer::mark(LatencyTracer::Stage::Queue);
+                handleKey(entry.key);
+            } else {
+                forward(entry);
+            }
+        }
+        m_keyQueue.finish();
+    }
+}
+
+void Keyboard::handleKey(const KeyRecord &key)
+{
+    // Store the serial and time from the compositor so they can be used later
+    // by InputPlugin::key() for synthetic key event forwarding.
+    m_parent->m_lastKeyboardSerial = key.serial;
+    m_parent->m_lastKeyboardTime = key.time;
+
+    bool handled = false;
+    if (m_sink) {
+        AllocationScope scope;
+        handled = m_sink->handleKey(key);
+    }
+    LatencyTracer::mark(LatencyTracer::Stage::Dispatch);
+
+    if (!handled) {
+        m_parent->key(key.serial, key.time, key.scancode, uint32_t(key.state));
+        LatencyTracer::mark(LatencyTracer::Stage::Forward);
+    }
+
+    LatencyTracer::endKey();
+}
+
+void Keyboard::forward(const KeyQueueEntry &entry)
+{
+    if (!m_parent || entry.generation != m_generation.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (entry.type == KeyQueueEntry::Type::Key) {
+        m_parent->key(entry.key.serial, entry.key.time, entry.key.scancode, uint32_t(entry.key.state));
+    } else {
+        m_parent->modifiers(entry.serial, entry.modsDepressed, entry.modsLatched, entry.modsLocked, entry.group);
+    }
 }
 
 #include "moc_inputmethod_p.cpp"
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <QObject>
+#include <QSocketNotifier>
 #include <QString>
 #include <QtGui/private/qxkbcommon_p.h>
 #include <QtWaylandClient/QWaylandClientExtensionTemplate>
@@ -16,8 +17,15 @@
 #include <qwayland-wayland.h>
 
 #include "inputplugin.h"
+#include "keyeventqueue.h"
+#include "keyrecord.h"
+#include "surroundingtext.h"
+#include "xkbcache.h"
+
+#include <atomic>
 
 class InputMethodContext;
+class InputThread;
 class Keyboard;
 
 // private implementations, InputPlugin acts as the public facade / multiplexer
@@ -39,6 +47,15 @@ public:
         return bool(m_activeContext);
     }
 
+    /**
+     * The thread the grabbed keyboard is dispatched on, or null if it is
+     * dispatched on the GUI thread.
+     */
+    InputThread *inputThread() const
+    {
+        return m_inputThread.get();
+    }
+
 Q_SIGNALS:
     void activate();
     void deactivate();
@@ -49,6 +66,7 @@ private:
     void zwp_input_method_v1_deactivate(struct ::zwp_input_method_context_v1 *context) override;
 
     void setCurrentContext(InputMethodContext *context);
+    std::unique_ptr<InputThread> m_inputThread;
     std::shared_ptr<InputMethodContext> m_activeContext;
 };
 
@@ -56,11 +74,17 @@ class InputMethodContext : public QObject, public QtWayland::zwp_input_method_co
 {
     Q_OBJECT
 public:
-    explicit InputMethodContext(struct ::zwp_input_method_context_v1 *id);
+    InputMethodContext(struct ::zwp_input_method_context_v1 *id, InputThread *inputThread);
     ~InputMethodContext() override;
 
-    std::shared_ptr<Keyboard> keyboard();
-    QString m_text;
+    /**
+     * Grab the keyboard for this context.
+     *
+     * If @p retained is given, it is re-bound to the new grab instead of
+     * creating a new Keyboard, keeping its XKB state.
+     */
+    std::shared_ptr<Keyboard> keyboard(const std::shared_ptr<Keyboard> &retained = {});
+    SurroundingText m_surroundingText;
     uint32_t m_cursor = 0;
     uint32_t m_anchor = 0;
     uint32_t m_latestSerial = 0;
@@ -84,6 +108,7 @@ private:
     void zwp_input_method_context_v1_commit_state(uint32_t serial) override;
     void zwp_input_method_context_v1_preferred_language(const QString &language) override;
 
+    InputThread *m_inputThread;
     std::weak_ptr<Keyboard> m_keyboard;
 };
 
@@ -91,12 +116,39 @@ class Keyboard : public QObject, public QtWayland::wl_keyboard
 {
     Q_OBJECT
 public:
-    Keyboard(::wl_keyboard *keyboard, InputMethodContext *parent);
+    /**
+     * @param inputThread The thread @p keyboard is dispatched on, or null for
+     *                    the GUI thread.
+     */
+    Keyboard(::wl_keyboard *keyboard, InputMethodContext *parent, InputThread *inputThread);
     ~Keyboard();
 
-Q_SIGNALS:
-    void keyPressed(QKeyEvent *keyEvent);
-    void keyReleased(QKeyEvent *keyEvent);
+    /**
+     * Switch to the grab of another context. The grab of the previous
+     * context ended with it, so its wl_keyboard is dropped.
+     *
+     * Must be called with the input thread's dispatch mutex held.
+     */
+    void rebind(::wl_keyboard *keyboard, InputMethodContext *parent);
+
+    /**
+     * Detach from the context, which is about to go away. Key events still
+     * queued for its grab are ignored until the next rebind().
+     */
+    void unbind();
+
+    /**
+     * Where keys are handled on the GUI thread. Keys the sink does not
+     * handle, and all keys while there is none, are forwarded to the client.
+     */
+    void setKeySink(KeySink *sink);
+
+    /**
+     * Whether keys without text may be forwarded to the client right away on
+     * the input thread, without reaching the sink. Set while nothing on the
+     * GUI side handles such keys.
+     */
+    void setTextlessKeysPassThrough(bool passThrough);
 
 protected:
     void keyboard_keymap(uint32_t format, int32_t fd, uint32_t size) override;
@@ -104,9 +156,36 @@ protected:
     void keyboard_modifiers(uint32_t serial, uint32_t mods_depressed, uint32_t mods_latched, uint32_t mods_locked, uint32_t group) override;
 
 private:
+    KeyRecord lookupKey(uint32_t serial, uint32_t time, uint32_t key, uint32_t state) const;
+    void enqueue(const KeyQueueEntry &entry);
+    void drainKeys();
+    void handleKey(const KeyRecord &key);
+    void forward(const KeyQueueEntry &entry);
+
+    /** Written on the GUI thread with the dispatch mutex held. */
     InputMethodContext *m_parent;
+    InputThread *m_inputThread;
+    KeySink *m_sink = nullptr;
+
+    /** Keys and modifiers on their way from the input thread to the GUI thread. */
+    KeyEventQueue m_keyQueue;
+    std::atomic<bool> m_textlessKeysPassThrough = false;
+
+    /**
+     * Bumped whenever the keyboard is re-bound or unbound, with the dispatch
+     * mutex held. Entries still queued from an earlier grab carry an older
+     * value and are dropped instead of reaching the new context.
+     */
+    std::atomic<quint32> m_generation = 0;
+
+    /**
+     * Wakes the GUI thread up to drain m_keyQueue. Unlike posting an event,
+     * this does not allocate for every key.
+     */
+    int m_wakeFd = -1;
+    QSocketNotifier *m_wakeNotifier = nullptr;
+
     uint32_t mKeymapFormat = WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1;
-    QXkbCommon::ScopedXKBContext mXkbContext;
-    QXkbCommon::ScopedXKBKeymap mXkbKeymap;
+    KeymapPtr mXkbKeymap;
     QXkbCommon::ScopedXKBState mXkbState;
 };
@@ -7,6 +7,13 @@
 
 #include "inputplugin.h"
 #include "inputmethod_p.h"
+#include "latencytracer.h"
+#include "logging.h"
+#include "plasmakeyboardsettings.h"
+
+#include <QGuiApplication>
+
+#include <wayland-client-core.h>
 
 InputPlugin::InputPlugin(InputMethod *inputMethod)
 {
@@ -15,7 +22,12 @@ InputPlugin::InputPlugin(InputMethod *inputMethod)
         if (m_context) {
             disconnect(m_context.get(), nullptr, this, nullptr);
         }
-        m_keyboard.reset();
+        if (m_keyboard && m_grabbing && PlasmaKeyboardSettings::self()->retainKeyboardGrab()) {
+            // Re-bound to the next context's grab in setGrabbingInternal().
+            m_keyboard->unbind();
+        } else {
+            m_keyboard.reset();
+        }
         m_context = inputMethod->activeContext();
         Q_EMIT contextChanged();
         Q_EMIT surroundingTextChanged();
@@ -45,8 +57,30 @@ void InputPlugin::setGrabbing(bool grabbing)
         setGrabbingInternal();
     }
     if (m_keyboard && !grabbing) {
-        disconnect(m_keyboard.get(), nullptr, this, nullptr);
-        m_keyboard.reset();
+        // input-method-v1 has no way to end a grab; it lasts as long as the
+        // context. Until then keys pass through unfiltered, and the next
+        // context is not grabbed at all.
+        m_keyboard->setKeySink(nullptr);
+    }
+}
+
+void InputPlugin::setKeySink(KeySink *sink)
+{
+    m_keySink = sink;
+    if (m_keyboard && m_grabbing) {
+        m_keyboard->setKeySink(sink);
+    }
+}
+
+void InputPlugin::setTextlessKeysPassThrough(bool passThrough)
+{
+    if (m_textlessKeysPassThrough == passThrough) {
+        return;
+    }
+    qCDebug(PlasmaKeyboard) << "InputPlugin: Textless keys pass through:" << passThrough;
+    m_textlessKeysPassThrough = passThrough;
+    if (m_keyboard) {
+        m_keyboard->setTextlessKeysPassThrough(passThrough);
     }
 }
 
@@ -56,6 +90,7 @@ void InputPlugin::setPreEditString(const QString &text)
         return;
     }
     m_context->preedit_string(m_context->m_latestSerial, text, text);
+    requestSent();
 }
 
 void InputPlugin::moveCursor(int cusorPosition, int anchorPosition)
@@ -64,6 +99,7 @@ void InputPlugin::moveCursor(int cusorPosition, int anchorPosition)
         return;
     }
     m_context->cursor_position(cusorPosition, anchorPosition);
+    requestSent();
 }
 
 void InputPlugin::setPreEditCursor(int cursorPosition)
@@ -72,6 +108,7 @@ void InputPlugin::setPreEditCursor(int cursorPosition)
         return;
     }
     m_context->preedit_cursor(cursorPosition);
+    requestSent();
 }
 
 void InputPlugin::setPreEditStyle(int startPosition, int length, int style)
@@ -80,6 +117,7 @@ void InputPlugin::setPreEditStyle(int startPosition, int length, int style)
         return;
     }
     m_context->preedit_styling(startPosition, length, style);
+    requestSent();
 }
 
 void InputPlugin::deleteSurroundingText(int index, int length)
@@ -88,6 +126,7 @@ void InputPlugin::deleteSurroundingText(int index, int length)
         return;
     }
     m_context->delete_surrounding_text(index, length);
+    requestSent();
 }
 
 void InputPlugin::commit(const QString &text)
@@ -96,6 +135,8 @@ void InputPlugin::commit(const QString &text)
         return;
     }
     m_context->commit_string(m_context->m_latestSerial, text);
+    requestSent();
+    LatencyTracer::mark(LatencyTracer::Stage::Forward);
 }
 
 void InputPlugin::keysym(uint timestamp, uint sym, KeyState state, uint modifiers)
@@ -104,6 +145,7 @@ void InputPlugin::keysym(uint timestamp, uint sym, KeyState state, uint modifier
         return;
     }
     m_context->keysym(m_context->m_latestSerial, timestamp, sym, state, modifiers);
+    requestSent();
 }
 
 void InputPlugin::key(KeyState state, quint32 scancode)
@@ -112,6 +154,8 @@ void InputPlugin::key(KeyState state, quint32 scancode)
         return;
     }
     m_context->key(m_context->m_lastKeyboardSerial, m_context->m_lastKeyboardTime, scancode, static_cast<uint32_t>(state));
+    requestSent();
+    LatencyTracer::mark(LatencyTracer::Stage::Forward);
 }
 
 InputPlugin::ContentHint InputPlugin::contentHint() const
@@ -135,7 +179,7 @@ QString InputPlugin::surroundingText() const
     if (!m_context) {
         return QString();
     }
-    return m_context->m_text;
+    return m_context->m_surroundingText.text();
 }
 
 uint32_t InputPlugin::cursorPos() const
@@ -154,12 +198,80 @@ uint32_t InputPlugin::anchorPos() const
     return m_context->m_anchor;
 }
 
+int InputPlugin::cursorCharPos() const
+{
+    if (!m_context) {
+        return 0;
+    }
+    return int(m_context->m_surroundingText.toUtf16Offset(m_context->m_cursor));
+}
+
+int InputPlugin::anchorCharPos() const
+{
+    if (!m_context) {
+        return 0;
+    }
+    return int(m_context->m_surroundingText.toUtf16Offset(m_context->m_anchor));
+}
+
+int InputPlugin::surroundingTextBytePos(int charPos) const
+{
+    if (!m_context) {
+        return 0;
+    }
+    return int(m_context->m_surroundingText.toUtf8Offset(charPos));
+}
+
+InputPlugin::Batch::Batch(InputPlugin *plugin)
+    : m_plugin(plugin)
+{
+    m_plugin->beginBatch();
+}
+
+InputPlugin::Batch::~Batch()
+{
+    m_plugin->endBatch();
+}
+
+void InputPlugin::beginBatch()
+{
+    ++m_batchDepth;
+}
+
+void InputPlugin::endBatch()
+{
+    Q_ASSERT(m_batchDepth > 0);
+    if (--m_batchDepth > 0 || !m_batchHasRequests) {
+        return;
+    }
+    m_batchHasRequests = false;
+
+    if (auto waylandApp = qGuiApp->nativeInterface<QNativeInterface::QWaylandApplication>()) {
+        wl_display_flush(waylandApp->display());
+    }
+}
+
+void InputPlugin::requestSent()
+{
+    if (m_batchDepth > 0) {
+        m_batchHasRequests = true;
+    }
+}
+
+uint32_t InputPlugin::serial() const
+{
+    if (!m_context) {
+        return 0;
+    }
+    return m_context->m_latestSerial;
+}
+
 void InputPlugin::setGrabbingInternal()
 {
     Q_ASSERT(m_context);
-    m_keyboard = m_context->keyboard();
-    connect(m_keyboard.get(), &Keyboard::keyPressed, this, &InputPlugin::keyPressed);
-    connect(m_keyboard.get(), &Keyboard::keyReleased, this, &InputPlugin::keyReleased);
+    m_keyboard = m_context->keyboard(m_keyboard);
+    m_keyboard->setTextlessKeysPassThrough(m_textlessKeysPassThrough);
+    m_keyboard->setKeySink(m_keySink);
 }
 
 #include "moc_inputplugin.cpp"
@@ -7,13 +7,13 @@
 
 #pragma once
 
-#include <QKeyEvent>
 #include <QObject>
 #include <memory>
 
 class InputMethod;
 class Keyboard;
 class InputMethodContext;
+class KeySink;
 
 /**
  * High level facade above the underlying classes
@@ -64,6 +64,19 @@ public:
      */
     void setGrabbing(bool grabbing);
 
+    /**
+     * Where intercepted keys are handled. Keys it does not handle are sent on
+     * to the client.
+     */
+    void setKeySink(KeySink *sink);
+
+    /**
+     * Whether keys without text may bypass the key sink, because nothing
+     * would handle them right now. They then reach the client without
+     * waiting for the GUI thread when an input thread is used.
+     */
+    void setTextlessKeysPassThrough(bool passThrough);
+
     void setPreEditString(const QString &text);
     void moveCursor(int cusorPosition, int anchorPosition);
     void setPreEditCursor(int cursorPosition);
@@ -79,11 +92,57 @@ public:
     void keysym(uint timestamp, uint sym, KeyState state, uint modifiers);
     void key(KeyState state, quint32 scancode);
 
+    /**
+     * Groups the requests of one logical input action, e.g. a
+     * delete_surrounding_text followed by the commit_string it belongs to.
+     *
+     * Requests are written to the Wayland connection's buffer as usual, and
+     * the connection is flushed once when the outermost batch ends, so the
+     * whole action reaches the compositor in a single write instead of
+     * whenever the event loop gets to it. Batches may be nested.
+     *
+     * @code
+     * InputPlugin::Batch batch(plugin);
+     * plugin->deleteSurroundingText(-1, 1);
+     * plugin->commit(text);
+     * @endcode
+     */
+    class Batch
+    {
+    public:
+        explicit Batch(InputPlugin *plugin);
+        ~Batch();
+
+    private:
+        Q_DISABLE_COPY_MOVE(Batch)
+        InputPlugin *m_plugin;
+    };
+
+    void beginBatch();
+    void endBatch();
+
     ContentHint contentHint() const;
     ContentPurpose contentPurpose() const;
     uint32_t cursorPos() const;
     uint32_t anchorPos() const;
     QString surroundingText() const;
+
+    /**
+     * Cursor and anchor as UTF-16 positions in surroundingText(), rather than
+     * the UTF-8 byte offsets used by the protocol.
+     */
+    int cursorCharPos() const;
+    int anchorCharPos() const;
+
+    /**
+     * Convert a UTF-16 position in surroundingText() to a UTF-8 byte offset.
+     */
+    int surroundingTextBytePos(int charPos) const;
+
+    /**
+     * Serial of the latest commit_state, which requests are sent with.
+     */
+    uint32_t serial() const;
     bool hasContext() const
     {
         return m_context.get();
@@ -99,20 +158,18 @@ Q_SIGNALS:
     void deactivate();
     void preferredLanguageChanged(const QString &language);
 
-    /**
-     * A key has been pressed
-     * Set the event to accepted to block the key being sent to the client
-     */
-    void keyPressed(QKeyEvent *keyEvent);
-    void keyReleased(QKeyEvent *keyEvent);
-
 protected:
     // move to private when this facade wraps everything
 
 private:
     void setGrabbingInternal();
+    void requestSent();
 
     bool m_grabbing = false;
+    bool m_textlessKeysPassThrough = false;
+    KeySink *m_keySink = nullptr;
+    int m_batchDepth = 0;
+    bool m_batchHasRequests = false;
     std::shared_ptr<Keyboard> m_keyboard;
     std::shared_ptr<InputMethodContext> m_context = nullptr;
 };
@@ -0,0 +1,115 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "inputthread.h"
+
+#include "logging.h"
+
+#include <wayland-client-core.h>
+#include <wayland-input-method-unstable-v1-client-protocol.h>
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace Qt::StringLiterals;
+
+InputThread::InputThread(wl_display *display, QObject *parent)
+    : QThread(parent)
+    , m_display(display)
+    , m_queue(wl_display_create_queue(display))
+    , m_wakeFd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+    setObjectName(u"plasma-keyboard input"_s);
+}
+
+InputThread::~InputThread()
+{
+    stop();
+    // m_queue is not destroyed: the input method, and us with it, only goes
+    // away at exit, after the Wayland connection has been closed.
+    if (m_wakeFd >= 0) {
+        close(m_wakeFd);
+    }
+}
+
+void InputThread::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+    m_quit = true;
+    const uint64_t one = 1;
+    if (write(m_wakeFd, &one, sizeof(one)) < 0) {
+        qCWarning(PlasmaKeyboard) << "InputThread: Failed to wake up the input thread:" << strerror(errno);
+    }
+    wait();
+}
+
+QMutex *InputThread::dispatchMutex()
+{
+    return &m_dispatchMutex;
+}
+
+::wl_keyboard *InputThread::grabKeyboard(::zwp_input_method_context_v1 *context)
+{
+    // The context itself stays on the default queue; only the keyboard
+    // created through this wrapper ends up on ours.
+    auto *wrapper = static_cast<::zwp_input_method_context_v1 *>(wl_proxy_create_wrapper(context));
+    wl_proxy_set_queue(reinterpret_cast<wl_proxy *>(wrapper), m_queue);
+    ::wl_keyboard *keyboard = zwp_input_method_context_v1_grab_keyboard(wrapper);
+    wl_proxy_wrapper_destroy(wrapper);
+    return keyboard;
+}
+
+void InputThread::run()
+{
+    pollfd fds[2] = {
+        {wl_display_get_fd(m_display), POLLIN, 0},
+        {m_wakeFd, POLLIN, 0},
+    };
+
+    while (!m_quit) {
+        // Dispatch what other threads already read into our queue first.
+        while (wl_display_prepare_read_queue(m_display, m_queue) != 0) {
+            QMutexLocker locker(&m_dispatchMutex);
+            if (wl_display_dispatch_queue_pending(m_display, m_queue) < 0) {
+                qCWarning(PlasmaKeyboard) << "InputThread: Failed to dispatch input events:" << strerror(errno);
+                return;
+            }
+        }
+
+        // Keys forwarded while dispatching were only buffered so far.
+        wl_display_flush(m_display);
+
+        if (poll(fds, 2, -1) < 0) {
+            wl_display_cancel_read(m_display);
+            if (errno == EINTR) {
+                continue;
+            }
+            qCWarning(PlasmaKeyboard) << "InputThread: poll() failed:" << strerror(errno);
+            return;
+        }
+        if (fds[1].revents & POLLIN) {
+            wl_display_cancel_read(m_display);
+            return;
+        }
+        if (wl_display_read_events(m_display) < 0) {
+            qCWarning(PlasmaKeyboard) << "InputThread: Failed to read events:" << strerror(errno);
+            return;
+        }
+
+        QMutexLocker locker(&m_dispatchMutex);
+        if (wl_display_dispatch_queue_pending(m_display, m_queue) < 0) {
+            qCWarning(PlasmaKeyboard) << "InputThread: Failed to dispatch input events:" << strerror(errno);
+            return;
+        }
+    }
+}
+
+#include "moc_inputthread.cpp"
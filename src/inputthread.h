@@ -0,0 +1,70 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QMutex>
+#include <QThread>
+
+#include <atomic>
+
+struct wl_display;
+struct wl_event_queue;
+struct wl_keyboard;
+struct zwp_input_method_context_v1;
+
+/**
+ * Dispatches the grabbed keyboard on its own thread.
+ *
+ * The wl_keyboard of a grab is created on a dedicated wl_event_queue, which
+ * this thread reads and dispatches independently of the GUI thread. Keys
+ * that nothing on the GUI side wants can then be forwarded to the client
+ * right away, even while the GUI thread is busy with a frame, a layout
+ * switch or loading data.
+ *
+ * Everything else, including the input method context itself, stays on the
+ * default queue and is dispatched by Qt on the GUI thread.
+ */
+class InputThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit InputThread(wl_display *display, QObject *parent = nullptr);
+    ~InputThread() override;
+
+    /**
+     * Stop dispatching and wait for the thread to finish.
+     */
+    void stop();
+
+    /**
+     * Held while events of the input queue are dispatched.
+     *
+     * Lock it to create, re-bind or destroy a proxy on the input queue, so
+     * that no event of it is dispatched halfway.
+     */
+    QMutex *dispatchMutex();
+
+    /**
+     * Grab the keyboard of @p context, with the new wl_keyboard on the input
+     * queue. The caller must hold dispatchMutex() until a listener has been
+     * added to it.
+     */
+    ::wl_keyboard *grabKeyboard(::zwp_input_method_context_v1 *context);
+
+protected:
+    void run() override;
+
+private:
+    wl_display *m_display;
+    wl_event_queue *m_queue;
+
+    /** eventfd that wakes the thread up from poll() to quit. */
+    int m_wakeFd = -1;
+    std::atomic<bool> m_quit = false;
+    QMutex m_dispatchMutex;
+};
@@ -0,0 +1,115 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "keyrecord.h"
+#include "latencytracer.h"
+
+#include <array>
+#include <atomic>
+
+/**
+ * A key or modifier event of the grabbed keyboard, as handed from the input
+ * thread to the GUI thread.
+ */
+struct KeyQueueEntry {
+    enum class Type : quint8 {
+        Key,
+        Modifiers,
+    };
+
+    Type type = Type::Key;
+
+    /** Keyboard::generation() when the entry was created. */
+    quint32 generation = 0;
+
+    // Type::Key
+    KeyRecord key;
+    /** The key's latency trace, started when it arrived on the input thread. */
+    LatencyTracer::Trace trace;
+
+    // Type::Modifiers
+    quint32 serial = 0;
+    quint32 modsDepressed = 0;
+    quint32 modsLatched = 0;
+    quint32 modsLocked = 0;
+    quint32 group = 0;
+};
+
+/**
+ * Lock-free queue of KeyQueueEntries from one producer thread to one consumer
+ * thread.
+ *
+ * Besides the entries waiting in the ring, the queue counts entries the
+ * consumer has taken but not finished yet, so that the producer can tell
+ * whether anything it sent earlier may still reach the client after an
+ * event it would send directly.
+ */
+class KeyEventQueue
+{
+public:
+    static constexpr quint32 kCapacity = 256;
+
+    /**
+     * Producer: whether every entry pushed so far has been finished.
+     */
+    bool isIdle() const
+    {
+        return m_inFlight.load(std::memory_order_acquire) == 0;
+    }
+
+    /**
+     * Producer: append @p entry.
+     *
+     * @param wasIdle Set to whether nothing was in flight before, i.e. the
+     *                consumer has to be woken up.
+     * @return False if the queue is full.
+     */
+    bool push(const KeyQueueEntry &entry, bool *wasIdle)
+    {
+        const quint32 tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == kCapacity) {
+            return false;
+        }
+        m_entries[tail % kCapacity] = entry;
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        // The consumer may take and finish the entry before it is counted
+        // here, so the count can dip below zero for a moment.
+        *wasIdle = m_inFlight.fetch_add(1, std::memory_order_acq_rel) == 0;
+        return true;
+    }
+
+    /**
+     * Consumer: take the oldest entry. Call finish() once it is handled.
+     */
+    bool pop(KeyQueueEntry *entry)
+    {
+        const quint32 head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        *entry = m_entries[head % kCapacity];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer: the entry taken last is handled, including anything sent
+     * to the client for it.
+     */
+    void finish()
+    {
+        m_inFlight.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+private:
+    std::array<KeyQueueEntry, kCapacity> m_entries;
+    alignas(64) std::atomic<quint32> m_head = 0;
+    alignas(64) std::atomic<quint32> m_tail = 0;
+    alignas(64) std::atomic<int> m_inFlight = 0;
+};
@@ -0,0 +1,91 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * A key event of the grabbed physical keyboard, looked up in its XKB state.
+ *
+ * Plain data that is built, queued and handled without any heap
+ * allocation; only code that acts on a key, e.g. to open an overlay, turns
+ * its text into a QString.
+ */
+struct KeyRecord {
+    /// UTF-16 code units of text carried inline; fits grapheme clusters such
+    /// as flags and most emoji sequences.
+    static constexpr qsizetype kMaxTextLength = 16;
+
+    /// wl_keyboard::key_state
+    enum class State : quint8 {
+        Released = 0,
+        Pressed = 1,
+        /// A press with auto-repeat, since wl_keyboard version 10.
+        Repeated = 2,
+    };
+
+    /// Linux evdev scan code, as sent by the compositor.
+    quint32 scancode = 0;
+    quint32 keysym = 0;
+    /// The character the key types, 0 if it types none or several.
+    char32_t utf32 = 0;
+    int qtKey = 0;
+    Qt::KeyboardModifiers modifiers;
+    State state = State::Released;
+    /// Whether the key types anything, possibly more than fits in textData.
+    bool hasText = false;
+    /// Length of textData, 0 if the text is longer than kMaxTextLength.
+    quint8 textLength = 0;
+    /// The text the key types, in UTF-16.
+    char16_t textData[kMaxTextLength] = {};
+
+    quint32 serial = 0;
+    quint32 time = 0;
+
+    bool isPress() const
+    {
+        return state != State::Released;
+    }
+
+    bool isRepeat() const
+    {
+        return state == State::Repeated;
+    }
+
+    /**
+     * The text the key types, without copying it.
+     */
+    QStringView textView() const
+    {
+        return QStringView(textData, textLength);
+    }
+
+    /**
+     * The text the key types, as a QString. Allocates.
+     */
+    QString text() const
+    {
+        return textView().toString();
+    }
+};
+
+/**
+ * Receives the keys of the grabbed keyboard on the GUI thread.
+ */
+class KeySink
+{
+public:
+    virtual ~KeySink() = default;
+
+    /**
+     * Handle @p key.
+     *
+     * @return True to keep the key from the client.
+     */
+    virtual bool handleKey(const KeyRecord &key) = 0;
+};
@@ -0,0 +1,182 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "latencytracer.h"
+
+#include "latencylogging.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <mutex>
+
+namespace
+{
+
+/// Number of traced keys between two logged summaries.
+constexpr quint64 kReportInterval = 500;
+
+/// Values below this many microseconds get one bucket each; above it, every
+/// power of two is split into kSubBuckets linear buckets (~12% resolution).
+constexpr int kSubBucketBits = 3;
+constexpr int kSubBuckets = 1 << kSubBucketBits;
+constexpr int kBucketCount = 256;
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * Log-linear histogram of microsecond durations with a fixed footprint, so
+ * recording a sample never allocates.
+ */
+struct Histogram {
+    std::array<quint32, kBucketCount> buckets{};
+    quint64 count = 0;
+    quint64 maxUs = 0;
+
+    static int bucketFor(quint64 us)
+    {
+        if (us < kSubBuckets) {
+            return int(us);
+        }
+        const int msb = int(std::bit_width(us)) - 1;
+        const int sub = int(us >> (msb - kSubBucketBits)) & (kSubBuckets - 1);
+        return std::min((msb - kSubBucketBits + 1) * kSubBuckets + sub, kBucketCount - 1);
+    }
+
+    static quint64 upperBoundOf(int bucket)
+    {
+        if (bucket < kSubBuckets) {
+            return quint64(bucket) + 1;
+        }
+        const int msb = bucket / kSubBuckets + kSubBucketBits - 1;
+        const int sub = bucket % kSubBuckets;
+        return quint64(kSubBuckets + sub + 1) << (msb - kSubBucketBits);
+    }
+
+    void record(quint64 us)
+    {
+        ++buckets[bucketFor(us)];
+        ++count;
+        maxUs = std::max(maxUs, us);
+    }
+
+    quint64 percentile(double fraction) const
+    {
+        if (count == 0) {
+            return 0;
+        }
+        const quint64 rank = std::max<quint64>(1, quint64(fraction * double(count) + 0.5));
+        quint64 seen = 0;
+        for (int i = 0; i < kBucketCount; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return std::min(upperBoundOf(i), maxUs);
+            }
+        }
+        return maxUs;
+    }
+};
+
+constexpr std::array<const char *, size_t(LatencyTracer::Stage::Count)> kStageNames = {
+    "lookup",
+    "queue",
+    "compose",
+    "triggers",
+    "dispatch",
+    "forward",
+    "total",
+};
+
+// Shared by the threads keys are traced on.
+std::mutex s_mutex;
+std::array<Histogram, size_t(LatencyTracer::Stage::Count)> s_histograms;
+quint64 s_tracedKeys = 0;
+
+// The key currently traced on this thread.
+thread_local qint64 t_keyStart = 0;
+thread_local qint64 t_lastMark = 0;
+
+qint64 now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+quint64 microsecondsBetween(qint64 from, qint64 to)
+{
+    return quint64(std::max<qint64>(0, to - from) / 1000);
+}
+
+void report()
+{
+    qCInfo(PlasmaKeyboardLatency) << "Key latency after" << s_tracedKeys << "keys (microseconds):";
+    for (size_t i = 0; i < s_histograms.size(); ++i) {
+        const Histogram &histogram = s_histograms[i];
+        if (histogram.count == 0) {
+            continue;
+        }
+        qCInfo(PlasmaKeyboardLatency).nospace() << "  " << kStageNames[i] << ": n=" << histogram.count << " p50=" << histogram.percentile(0.50)
+                                                << " p99=" << histogram.percentile(0.99) << " max=" << histogram.maxUs;
+    }
+}
+
+} // namespace
+
+void LatencyTracer::setEnabled(bool enabled)
+{
+    if (s_enabled.exchange(enabled, std::memory_order_relaxed) == enabled) {
+        return;
+    }
+    s_keyInFlight = false;
+
+    std::lock_guard lock(s_mutex);
+    if (!enabled && s_tracedKeys > 0) {
+        report();
+    }
+    qCInfo(PlasmaKeyboardLatency) << "Key latency tracing" << (enabled ? "enabled" : "disabled");
+}
+
+void LatencyTracer::beginKeyImpl()
+{
+    t_keyStart = now();
+    t_lastMark = t_keyStart;
+    s_keyInFlight = true;
+}
+
+LatencyTracer::Trace LatencyTracer::suspendKeyImpl()
+{
+    s_keyInFlight = false;
+    return Trace{t_keyStart, t_lastMark};
+}
+
+void LatencyTracer::resumeKeyImpl(const Trace &trace)
+{
+    t_keyStart = trace.start;
+    t_lastMark = trace.lastMark;
+    s_keyInFlight = true;
+}
+
+void LatencyTracer::markImpl(Stage stage)
+{
+    const qint64 mark = now();
+    {
+        std::lock_guard lock(s_mutex);
+        s_histograms[size_t(stage)].record(microsecondsBetween(t_lastMark, mark));
+    }
+    t_lastMark = mark;
+}
+
+void LatencyTracer::endKeyImpl()
+{
+    const quint64 total = microsecondsBetween(t_keyStart, now());
+    s_keyInFlight = false;
+
+    std::lock_guard lock(s_mutex);
+    s_histograms[size_t(Stage::Total)].record(total);
+    if (++s_tracedKeys % kReportInterval == 0) {
+        report();
+    }
+}
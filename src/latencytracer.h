@@ -0,0 +1,142 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+
+/**
+ * @file
+ *
+ * Built-in latency tracer for the physical key path.
+ *
+ * Every key delivered through the keyboard grab is timestamped on arrival in
+ * Keyboard::keyboard_key() and again at each stage of the pipeline (XKB lookup,
+ * compose handling, trigger evaluation, signal dispatch and the final
+ * InputPlugin key/commit request). Keys looked up on the input thread are
+ * handed to the GUI thread along with their trace, so the time they wait in
+ * between is a stage of its own. Each stage keeps its own histogram, and a
+ * p50/p99/max summary is logged periodically to the
+ * "org.kde.plasma.keyboard.latency" category.
+ *
+ * Tracing is toggled at runtime through the latencyTracingEnabled setting, e.g.
+ *
+ *     kwriteconfig6 --notify --file plasmakeyboardrc --group General --key latencyTracingEnabled true
+ *
+ * When disabled, every entry point reduces to a single predictable branch on a
+ * relaxed atomic bool or a thread-local one.
+ */
+class LatencyTracer
+{
+public:
+    /**
+     * Pipeline stages. The time recorded for a stage is the time elapsed since
+     * the previous mark of the same key.
+     */
+    enum class Stage {
+        /** Keysym, modifier and text lookup from the XKB state. */
+        Lookup,
+        /** Wait in the queue from the input thread to the GUI thread. */
+        Queue,
+        /** XKB compose state machine in OverlayController. */
+        Compose,
+        /** Overlay trigger evaluation in OverlayController. */
+        Triggers,
+        /** Remaining signal dispatch (InputListenerItem, keyboard navigation). */
+        Dispatch,
+        /** Wayland key/commit request issued through InputPlugin. */
+        Forward,
+        /** From arrival to the key being handled completely. */
+        Total,
+        Count,
+    };
+
+    /**
+     * A key being traced while it is passed from one thread to another.
+     * Timestamps are steady-clock nanoseconds; a zero start means the key
+     * is not traced.
+     */
+    struct Trace {
+        qint64 start = 0;
+        qint64 lastMark = 0;
+    };
+
+    /**
+     * Enable or disable tracing. Collected histograms are kept across toggles
+     * so that tracing can be briefly enabled while reproducing an issue.
+     */
+    static void setEnabled(bool enabled);
+
+    static bool isEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Start tracing a key that has just arrived from the compositor.
+     */
+    static void beginKey()
+    {
+        if (Q_UNLIKELY(isEnabled())) {
+            beginKeyImpl();
+        }
+    }
+
+    /**
+     * Stop tracing the current key on this thread, to continue on another
+     * thread with resumeKey().
+     */
+    static Trace suspendKey()
+    {
+        if (Q_UNLIKELY(s_keyInFlight)) {
+            return suspendKeyImpl();
+        }
+        return {};
+    }
+
+    /**
+     * Continue tracing a key suspended on another thread.
+     */
+    static void resumeKey(const Trace &trace)
+    {
+        if (Q_UNLIKELY(trace.start != 0)) {
+            resumeKeyImpl(trace);
+        }
+    }
+
+    /**
+     * Record the end of @p stage for the key currently being traced.
+     */
+    static void mark(Stage stage)
+    {
+        if (Q_UNLIKELY(s_keyInFlight)) {
+            markImpl(stage);
+        }
+    }
+
+    /**
+     * Finish tracing the current key and record its total latency.
+     */
+    static void endKey()
+    {
+        if (Q_UNLIKELY(s_keyInFlight)) {
+            endKeyImpl();
+        }
+    }
+
+private:
+    static void beginKeyImpl();
+    static Trace suspendKeyImpl();
+    static void resumeKeyImpl(const Trace &trace);
+    static void markImpl(Stage stage);
+    static void endKeyImpl();
+
+    static inline std::atomic<bool> s_enabled = false;
+    /// Keys are traced on the input thread and on the GUI thread.
+    static inline thread_local bool s_keyInFlight = false;
+};
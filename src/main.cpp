@@ -7,12 +7,17 @@
 
 #include "config-plasma-keyboard.h"
 #include "inputpanelintegration.h"
+#include "latencytracer.h"
 #include "layoutpathhelper.h"
 #include "logging.h"
 #include "plasmakeyboardsettings.h"
+#include "startupprofiler.h"
+#include "xkbcache.h"
 #include <plasma_keyboard_version.h>
 
 #include <KAboutData>
+#include <KConfig>
+#include <KConfigGroup>
 #include <KConfigWatcher>
 #include <KCrash>
 #include <KLocalizedQmlContext>
@@ -35,12 +40,30 @@
 
 int main(int argc, char **argv)
 {
+    StartupProfiler::start();
+
     qputenv("QT_IM_MODULE", QByteArray("qtvirtualkeyboard"));
+    {
+        // A lazily created panel is provided by main.qml only later on; Qt VirtualKeyboard
+        // must not create its own desktop panel in the meantime. It reads the variable
+        // when QGuiApplication loads it, before the settings singleton can be used.
+        const KConfig config(QStringLiteral("plasmakeyboardrc"));
+        const KConfigGroup general(&config, QStringLiteral("General"));
+        if (general.readEntry("lazyPanelEnabled", PlasmaKeyboardSettings::defaultLazyPanelEnabledValue())) {
+            qputenv("QT_VIRTUALKEYBOARD_DESKTOP_DISABLE", QByteArray("1"));
+        }
+    }
 
-    initLayoutsPath();
+    {
+        StartupProfiler::Scope scope("initLayoutsPath");
+        initLayoutsPath();
+    }
 
     QGuiApplication application(argc, argv);
 
+    // Compile the compose table while the rest of the keyboard starts up.
+    XkbCache::precompileComposeTable(XkbCache::composeLocale());
+
     KLocalizedString::setApplicationDomain("plasma-keyboard");
 
     KAboutData aboutData(QStringLiteral("plasma-keyboard"),
@@ -62,9 +85,13 @@ int main(int argc, char **argv)
 
     {
         QCommandLineParser parser;
+        const QCommandLineOption profileStartupOption(QStringLiteral("profile-startup"), i18n("Log how long each step of the startup takes."));
+        parser.addOption(profileStartupOption);
         aboutData.setupCommandLine(&parser);
         parser.process(application);
         aboutData.processCommandLine(&parser);
+
+        StartupProfiler::setEnabled(parser.isSet(profileStartupOption) || qEnvironmentVariableIntValue("PLASMA_KEYBOARD_PROFILE_STARTUP") != 0);
     }
 
     if (!PLASMA_KEYBOARD_SOUND_ENABLED) {
@@ -75,6 +102,12 @@ int main(int argc, char **argv)
         PlasmaKeyboardSettings::self()->setVibrationEnabled(false);
     }
 
+    // Key latency tracing can be toggled at runtime via the config watcher below
+    LatencyTracer::setEnabled(PlasmaKeyboardSettings::self()->latencyTracingEnabled());
+    QObject::connect(PlasmaKeyboardSettings::self(), &PlasmaKeyboardSettings::latencyTracingEnabledChanged, &application, [] {
+        LatencyTracer::setEnabled(PlasmaKeyboardSettings::self()->latencyTracingEnabled());
+    });
+
     // Listen to config updates from kcm, and reparse
     auto watcher = KConfigWatcher::create(PlasmaKeyboardSettings::self()->sharedConfig());
     // clang-format off
@@ -92,7 +125,11 @@ int main(int argc, char **argv)
 
     QObject::connect(&view, &QQmlApplicationEngine::objectCreated, &application, [](QObject *object) {
         auto window = qobject_cast<QWindow *>(object);
-        const bool initSuccessful = initInputPanelIntegration(window, InputPanelRole::Keyboard);
+        bool initSuccessful;
+        {
+            StartupProfiler::Scope scope("initInputPanelIntegration");
+            initSuccessful = initInputPanelIntegration(window, InputPanelRole::Keyboard);
+        }
 
         if (!initSuccessful) {
             qCCritical(PlasmaKeyboard)
@@ -100,10 +137,18 @@ int main(int argc, char **argv)
             exit(1);
         }
 
+        // A lazily created panel shows the window once it is first requested.
+        if (PlasmaKeyboardSettings::self()->lazyPanelEnabled()) {
+            return;
+        }
+
         window->requestActivate();
         window->setVisible(true);
     });
-    view.load(QUrl(QStringLiteral("qrc:/qt/qml/org/kde/plasma/keyboard/main.qml")));
+    {
+        StartupProfiler::Scope scope("QML engine load");
+        view.load(QUrl(QStringLiteral("qrc:/qt/qml/org/kde/plasma/keyboard/main.qml")));
+    }
 
 #ifdef Q_OS_UNIX
     /**
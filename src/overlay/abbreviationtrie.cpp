@@ -0,0 +1,144 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "abbreviationtrie.h"
+
+#include <QChar>
+#include <QVarLengthArray>
+
+#include <algorithm>
+
+void AbbreviationTrie::insert(QStringView abbreviation)
+{
+    if (abbreviation.isEmpty()) {
+        return;
+    }
+    if (m_nodes.isEmpty()) {
+        m_nodes.append(Node{});
+    }
+
+    quint32 current = 0;
+    for (qsizetype i = abbreviation.size() - 1; i >= 0; --i) {
+        const char16_t character = abbreviation.at(i).unicode();
+        QList<Edge> &children = m_nodes[current].children;
+        auto it = std::lower_bound(children.begin(), children.end(), character, [](const Edge &edge, char16_t value) {
+            return edge.character < value;
+        });
+        if (it != children.end() && it->character == character) {
+            current = it->node;
+            continue;
+        }
+
+        // allocateNode() may grow m_nodes, so look the parent up again afterwards.
+        const qsizetype position = it - children.begin();
+        const quint32 child = allocateNode();
+        m_nodes[current].children.insert(position, Edge{character, child});
+        current = child;
+    }
+
+    if (!m_nodes[current].terminal) {
+        m_nodes[current].terminal = true;
+        ++m_size;
+    }
+}
+
+void AbbreviationTrie::remove(QStringView abbreviation)
+{
+    if (abbreviation.isEmpty() || m_nodes.isEmpty()) {
+        return;
+    }
+
+    QVarLengthArray<quint32, 32> path;
+    path.append(0);
+    for (qsizetype i = abbreviation.size() - 1; i >= 0; --i) {
+        const Edge *edge = findEdge(m_nodes.at(path.last()), abbreviation.at(i).unicode());
+        if (!edge) {
+            return;
+        }
+        path.append(edge->node);
+    }
+
+    Node &leaf = m_nodes[path.last()];
+    if (!leaf.terminal) {
+        return;
+    }
+    leaf.terminal = false;
+    --m_size;
+
+    // Prune the nodes that no other abbreviation passes through.
+    for (qsizetype depth = path.size() - 1; depth > 0; --depth) {
+        Node &node = m_nodes[path.at(depth)];
+        if (node.terminal || !node.children.isEmpty()) {
+            break;
+        }
+        node.children.squeeze();
+        m_freeNodes.append(path.at(depth));
+
+        const char16_t character = abbreviation.at(abbreviation.size() - depth).unicode();
+        QList<Edge> &siblings = m_nodes[path.at(depth - 1)].children;
+        siblings.removeIf([character](const Edge &edge) {
+            return edge.character == character;
+        });
+    }
+}
+
+void AbbreviationTrie::clear()
+{
+    m_nodes.clear();
+    m_freeNodes.clear();
+    m_size = 0;
+}
+
+qsizetype AbbreviationTrie::size() const
+{
+    return m_size;
+}
+
+bool AbbreviationTrie::isEmpty() const
+{
+    return m_size == 0;
+}
+
+qsizetype AbbreviationTrie::longestMatch(QStringView text) const
+{
+    if (m_size == 0) {
+        return 0;
+    }
+
+    qsizetype match = 0;
+    const Node *node = &m_nodes.at(0);
+    for (qsizetype i = text.size() - 1; i >= 0; --i) {
+        const Edge *edge = findEdge(*node, text.at(i).unicode());
+        if (!edge) {
+            break;
+        }
+        node = &m_nodes.at(edge->node);
+        if (node->terminal && (i == 0 || text.at(i - 1).isSpace())) {
+            match = text.size() - i;
+        }
+    }
+    return match;
+}
+
+const AbbreviationTrie::Edge *AbbreviationTrie::findEdge(const Node &node, char16_t character)
+{
+    const auto it = std::lower_bound(node.children.cbegin(), node.children.cend(), character, [](const Edge &edge, char16_t value) {
+        return edge.character < value;
+    });
+    if (it == node.children.cend() || it->character != character) {
+        return nullptr;
+    }
+    return &*it;
+}
+
+quint32 AbbreviationTrie::allocateNode()
+{
+    if (!m_freeNodes.isEmpty()) {
+        return m_freeNodes.takeLast();
+    }
+    m_nodes.append(Node{});
+    return quint32(m_nodes.size() - 1);
+}
@@ -0,0 +1,75 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QList>
+#include <QStringView>
+
+/**
+ * Reversed-suffix trie over text expansion abbreviations.
+ *
+ * Abbreviations are stored back to front, so finding the abbreviation the
+ * typed text ends with is a single walk from the end of the text towards its
+ * start. The cost of a lookup is bounded by the length of the longest
+ * abbreviation, independent of how many abbreviations are stored.
+ *
+ * Nodes live in one flat array and are recycled through a free list, so
+ * insert() and remove() keep the trie compact without rebuilding it.
+ */
+class AbbreviationTrie
+{
+public:
+    /**
+     * Add @p abbreviation. Empty abbreviations are ignored.
+     */
+    void insert(QStringView abbreviation);
+
+    /**
+     * Remove @p abbreviation and prune the nodes only it was using.
+     */
+    void remove(QStringView abbreviation);
+
+    /**
+     * Remove all abbreviations.
+     */
+    void clear();
+
+    /**
+     * Number of abbreviations stored.
+     */
+    qsizetype size() const;
+
+    bool isEmpty() const;
+
+    /**
+     * Length of the longest abbreviation @p text ends with that starts on a
+     * word boundary (the start of @p text or after whitespace).
+     *
+     * @return The abbreviation length in UTF-16 code units, or 0 if none matches.
+     */
+    qsizetype longestMatch(QStringView text) const;
+
+private:
+    struct Edge {
+        char16_t character;
+        quint32 node;
+    };
+
+    struct Node {
+        /** Outgoing edges, sorted by character. */
+        QList<Edge> children;
+        bool terminal = false;
+    };
+
+    static const Edge *findEdge(const Node &node, char16_t character);
+    quint32 allocateNode();
+
+    /** Node 0 is the root and always exists once anything was inserted. */
+    QList<Node> m_nodes;
+    QList<quint32> m_freeNodes;
+    qsizetype m_size = 0;
+};
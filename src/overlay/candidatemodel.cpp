@@ -16,15 +16,34 @@ int CandidateModel::rowCount(const QModelIndex &parent) const
     if (parent.isValid()) {
         return 0;
     }
+    if (!m_indexCandidates.isEmpty()) {
+        return static_cast<int>(m_indexCandidates.size());
+    }
     return static_cast<int>(m_candidates.size());
 }
 
 QVariant CandidateModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || index.row() < 0 || index.row() >= m_candidates.size()) {
+    if (!index.isValid() || index.row() < 0 || index.row() >= rowCount()) {
         return {};
     }
 
+    if (!m_indexCandidates.isEmpty()) {
+        switch (role) {
+        case DisplayRole:
+        case Qt::DisplayRole:
+        case InsertTextRole:
+            return indexCandidateAt(index.row());
+        case DescriptionRole:
+        case CategoryRole:
+            return QString();
+        case KeywordsRole:
+            return QStringList();
+        default:
+            return {};
+        }
+    }
+
     const auto &candidate = m_candidates.at(index.row());
 
     switch (role) {
@@ -86,6 +105,9 @@ void CandidateModel::setTriggerId(const QString &triggerId)
 void CandidateModel::setCandidates(const QStringList &candidates)
 {
     beginResetModel();
+    m_index = {};
+    m_indexCandidates = {};
+    m_indexOrder.clear();
     m_candidates.clear();
     m_candidates.reserve(candidates.size());
     for (const auto &text : candidates) {
@@ -94,20 +116,45 @@ void CandidateModel::setCandidates(const QStringList &candidates)
     endResetModel();
 }
 
+void CandidateModel::setCandidates(const DiacriticsIndex &index, DiacriticsIndex::CandidateList candidates, bool upperCase, const CandidateOrder &order)
+{
+    Q_ASSERT(order.isEmpty() || order.size() == candidates.size());
+
+    beginResetModel();
+    m_candidates.clear();
+    m_index = index;
+    m_indexCandidates = candidates;
+    m_indexUpperCase = upperCase;
+    m_indexOrder = order;
+    endResetModel();
+}
+
 void CandidateModel::clear()
 {
     beginResetModel();
     m_candidates.clear();
+    m_index = {};
+    m_indexCandidates = {};
+    m_indexOrder.clear();
     endResetModel();
 }
 
 QString CandidateModel::insertTextAt(int index) const
 {
-    if (index < 0 || index >= m_candidates.size()) {
+    if (index < 0 || index >= rowCount()) {
         return {};
     }
+    if (!m_indexCandidates.isEmpty()) {
+        return indexCandidateAt(index);
+    }
     const auto &candidate = m_candidates.at(index);
     return candidate.insertText.isEmpty() ? candidate.display : candidate.insertText;
 }
 
+QString CandidateModel::indexCandidateAt(int row) const
+{
+    const QStringView candidate = m_indexCandidates.at(m_indexOrder.isEmpty() ? row : m_indexOrder.at(row));
+    return m_indexUpperCase ? candidate.toString().toUpper() : candidate.toString();
+}
+
 #include "moc_candidatemodel.cpp"
@@ -6,7 +6,10 @@
 
 #pragma once
 
+#include "diacriticsindex.h"
+
 #include <QAbstractListModel>
+#include <QVarLengthArray>
 #include <qqmlintegration.h>
 
 /**
@@ -48,6 +51,12 @@ public:
     };
     Q_ENUM(Roles)
 
+    /**
+     * Display order of index-backed candidates, as positions in the
+     * DiacriticsIndex::CandidateList. Small orders are stored inline.
+     */
+    using CandidateOrder = QVarLengthArray<quint16, 16>;
+
     explicit CandidateModel(QObject *parent = nullptr);
     ~CandidateModel() override = default;
 
@@ -68,6 +77,21 @@ public:
      */
     void setCandidates(const QStringList &candidates);
 
+    /**
+     * Show candidates straight out of a diacritics index.
+     *
+     * Nothing is copied up front; rows are read from the index when QML asks
+     * for them, so opening a popup does not allocate per candidate.
+     *
+     * @param index      The index @p candidates points into. The model keeps
+     *                   a (shared) reference to it while the rows are shown.
+     * @param candidates Candidates of one base character in @p index.
+     * @param upperCase  Whether to present the candidates upper-cased.
+     * @param order      Display order as positions in @p candidates, or empty
+     *                   to keep the index order.
+     */
+    void setCandidates(const DiacriticsIndex &index, DiacriticsIndex::CandidateList candidates, bool upperCase, const CandidateOrder &order = {});
+
     /**
      * Clear all candidates.
      */
@@ -94,7 +118,15 @@ private:
         QStringList keywords;
     };
 
+    QString indexCandidateAt(int row) const;
+
     QList<Candidate> m_candidates;
+
+    /** Rows referenced from a diacritics index, used instead of m_candidates when non-empty. */
+    DiacriticsIndex m_index;
+    DiacriticsIndex::CandidateList m_indexCandidates;
+    bool m_indexUpperCase = false;
+    CandidateOrder m_indexOrder;
     QString m_query;
     QString m_triggerId;
 };
@@ -0,0 +1,139 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "candidateusagestore.h"
+
+#include "logging.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <algorithm>
+
+using namespace Qt::StringLiterals;
+
+/// Name of the state config file holding the counters.
+static const QString kStateFileName = u"plasmakeyboardstaterc"_s;
+
+/// Delay after the last selection before counters are written to disk.
+static constexpr int kFlushDelayMs = 30000;
+
+/// When a counter reaches this value, all counters of its base key are
+/// halved. This keeps the numbers small and lets recent habits win over
+/// old ones without changing the relative order.
+static constexpr quint32 kMaxCount = 1000;
+
+CandidateUsageStore::CandidateUsageStore(const QString &groupName, QObject *parent)
+    : QObject(parent)
+    , m_groupName(groupName)
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(kFlushDelayMs);
+    connect(&m_flushTimer, &QTimer::timeout, this, &CandidateUsageStore::flush);
+}
+
+CandidateUsageStore::~CandidateUsageStore()
+{
+    flush();
+}
+
+quint32 CandidateUsageStore::count(const QString &baseKey, QStringView candidate) const
+{
+    ensureLoaded();
+    const auto it = m_counts.constFind(baseKey);
+    if (it == m_counts.cend()) {
+        return 0;
+    }
+    for (const Counter &counter : it.value()) {
+        if (counter.candidate == candidate) {
+            return counter.count;
+        }
+    }
+    return 0;
+}
+
+bool CandidateUsageStore::hasCounts(const QString &baseKey) const
+{
+    ensureLoaded();
+    return m_counts.contains(baseKey);
+}
+
+void CandidateUsageStore::record(const QString &baseKey, const QString &candidate)
+{
+    ensureLoaded();
+    QList<Counter> &counters = m_counts[baseKey];
+
+    auto it = std::find_if(counters.begin(), counters.end(), [&candidate](const Counter &counter) {
+        return counter.candidate == candidate;
+    });
+    if (it == counters.end()) {
+        counters.append({candidate, 0});
+        it = counters.end() - 1;
+    }
+
+    if (++it->count >= kMaxCount) {
+        for (Counter &counter : counters) {
+            counter.count /= 2;
+        }
+    }
+
+    m_dirtyKeys.insert(baseKey);
+    m_flushTimer.start();
+}
+
+void CandidateUsageStore::flush()
+{
+    m_flushTimer.stop();
+    if (m_dirtyKeys.isEmpty()) {
+        return;
+    }
+
+    KSharedConfig::Ptr config = KSharedConfig::openStateConfig(kStateFileName);
+    KConfigGroup group = config->group(m_groupName);
+    for (const QString &baseKey : std::as_const(m_dirtyKeys)) {
+        KConfigGroup keyGroup = group.group(baseKey);
+        for (const Counter &counter : m_counts.value(baseKey)) {
+            if (counter.count > 0) {
+                keyGroup.writeEntry(counter.candidate, counter.count);
+            } else {
+                keyGroup.deleteEntry(counter.candidate);
+            }
+        }
+    }
+    config->sync();
+
+    qCDebug(PlasmaKeyboard) << "CandidateUsageStore: Wrote counters for" << m_dirtyKeys.size() << "keys in" << m_groupName;
+    m_dirtyKeys.clear();
+}
+
+void CandidateUsageStore::ensureLoaded() const
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    const KSharedConfig::Ptr config = KSharedConfig::openStateConfig(kStateFileName);
+    const KConfigGroup group = config->group(m_groupName);
+    const QStringList baseKeys = group.groupList();
+    for (const QString &baseKey : baseKeys) {
+        const KConfigGroup keyGroup = group.group(baseKey);
+        const QStringList candidates = keyGroup.keyList();
+        QList<Counter> counters;
+        counters.reserve(candidates.size());
+        for (const QString &candidate : candidates) {
+            const quint32 count = keyGroup.readEntry(candidate, 0u);
+            if (count > 0) {
+                counters.append({candidate, count});
+            }
+        }
+        if (!counters.isEmpty()) {
+            m_counts.insert(baseKey, counters);
+        }
+    }
+}
+
+#include "moc_candidateusagestore.cpp"
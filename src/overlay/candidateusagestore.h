@@ -0,0 +1,102 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QStringView>
+#include <QTimer>
+#include <QVarLengthArray>
+
+#include <algorithm>
+
+/**
+ * Persistent counters of how often each overlay candidate was picked.
+ *
+ * Counters are kept per base key (e.g. "e" → {"é": 12, "è": 3}) in the
+ * plasmakeyboard state config, in one group per trigger. Selections are
+ * recorded in memory and written back in batches, a while after the last
+ * selection and when the store is destroyed, rather than on every commit.
+ */
+class CandidateUsageStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param groupName Config group holding the counters, e.g. the trigger ID.
+     */
+    explicit CandidateUsageStore(const QString &groupName, QObject *parent = nullptr);
+    ~CandidateUsageStore() override;
+
+    /**
+     * How often @p candidate was picked for @p baseKey.
+     */
+    quint32 count(const QString &baseKey, QStringView candidate) const;
+
+    /**
+     * Whether anything was ever picked for @p baseKey.
+     */
+    bool hasCounts(const QString &baseKey) const;
+
+    /**
+     * Display order of @p candidates for @p baseKey, most picked first, as
+     * positions in @p candidates. Ties keep their order in @p candidates.
+     *
+     * @param candidates A list of strings with size() and at(), e.g. a
+     *                   DiacriticsIndex::CandidateList.
+     * @return The order, or an empty list if nothing was ever picked for
+     *         @p baseKey and @p candidates can be shown as they are.
+     */
+    template<typename CandidateList>
+    QVarLengthArray<quint16, 16> order(const QString &baseKey, const CandidateList &candidates) const
+    {
+        QVarLengthArray<quint16, 16> result;
+        if (!hasCounts(baseKey)) {
+            return result;
+        }
+        QVarLengthArray<quint32, 16> counts;
+        for (qsizetype i = 0; i < candidates.size(); ++i) {
+            result.append(quint16(i));
+            counts.append(count(baseKey, candidates.at(i)));
+        }
+        std::stable_sort(result.begin(), result.end(), [&counts](quint16 a, quint16 b) {
+            return counts.at(a) > counts.at(b);
+        });
+        return result;
+    }
+
+    /**
+     * Record that @p candidate was picked for @p baseKey.
+     */
+    void record(const QString &baseKey, const QString &candidate);
+
+    /**
+     * Write pending changes to disk now.
+     */
+    void flush();
+
+private:
+    struct Counter {
+        QString candidate;
+        quint32 count;
+    };
+
+    void ensureLoaded() const;
+
+    QString m_groupName;
+
+    /** Per base key; a handful of candidates each, so a list beats a hash. */
+    mutable QHash<QString, QList<Counter>> m_counts;
+    mutable bool m_loaded = false;
+
+    /** Base keys whose counters changed since the last flush. */
+    QSet<QString> m_dirtyKeys;
+    QTimer m_flushTimer;
+};
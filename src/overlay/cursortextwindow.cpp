@@ -0,0 +1,95 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "cursortextwindow.h"
+
+#include <algorithm>
+
+/// UTF-16 code units before the cursor taken from surrounding text.
+static constexpr qsizetype kWindowLength = 64;
+
+/// Longest insertion recognised as such; anything longer counts as replaced.
+static constexpr qsizetype kMaxInsertLength = 32;
+
+/// Windows of different lengths only match if they overlap by at least this
+/// much, as in SurroundingTextReconciler.
+static constexpr qsizetype kMinOverlap = 8;
+
+/// Whether two pieces of text before the cursor are the same, compared over
+/// their overlap if one of them is cut shorter.
+static bool endsMatch(QStringView a, QStringView b)
+{
+    if (a.size() == b.size()) {
+        return a == b;
+    }
+    const QStringView shorter = a.size() < b.size() ? a : b;
+    const QStringView longer = a.size() < b.size() ? b : a;
+    return shorter.size() >= kMinOverlap && longer.endsWith(shorter);
+}
+
+void CursorTextWindow::edit(qsizetype deleteBeforeCursor, QStringView insert)
+{
+    m_before.chop(std::min(deleteBeforeCursor, m_before.size()));
+    m_before += insert;
+    m_position = std::max<qsizetype>(0, m_position - deleteBeforeCursor) + insert.size();
+    trim();
+}
+
+CursorTextWindow::Change CursorTextWindow::update(const QString &text, qsizetype cursor, qsizetype anchor)
+{
+    cursor = std::clamp<qsizetype>(cursor, 0, text.size());
+    anchor = std::clamp<qsizetype>(anchor, 0, text.size());
+
+    // A selection is replaced by the next insertion, so only what precedes it counts.
+    const qsizetype start = std::min(cursor, anchor);
+    const qsizetype length = std::min(start, kWindowLength);
+    const QStringView before = QStringView(text).sliced(start - length, length);
+
+    // Content alone does not tell e.g. "aaaa" from "aaa" once both are cut
+    // to the window, so the cursor has to have moved by what was inserted.
+    // Clients that report a window of the text shifted along with the cursor
+    // keep it at the same position instead.
+    if (m_known) {
+        if (start == m_position && endsMatch(m_before, before)) {
+            return Change::None;
+        }
+
+        // Typing appends at the cursor: what precedes the new text is what we had.
+        const qsizetype maxInserted = std::min(before.size(), kMaxInsertLength);
+        for (qsizetype inserted = 1; inserted <= maxInserted; ++inserted) {
+            if ((start == m_position + inserted || start == m_position) && endsMatch(m_before, before.chopped(inserted))) {
+                m_before += before.last(inserted);
+                m_position = start;
+                trim();
+                return Change::Inserted;
+            }
+        }
+    }
+
+    m_before = before.toString();
+    m_position = start;
+    m_known = true;
+    return Change::Replaced;
+}
+
+void CursorTextWindow::reset()
+{
+    m_before.clear();
+    m_position = 0;
+    m_known = false;
+}
+
+const QString &CursorTextWindow::beforeCursor() const
+{
+    return m_before;
+}
+
+void CursorTextWindow::trim()
+{
+    if (m_before.size() > 2 * kWindowLength) {
+        m_before.remove(0, m_before.size() - kWindowLength);
+    }
+}
@@ -0,0 +1,73 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QString>
+#include <QStringView>
+
+/**
+ * The text right before the cursor, as far as text-based triggers need it.
+ *
+ * Commits and other edits at the cursor are applied to the window directly.
+ * Surrounding-text updates only contribute the last few dozen code units
+ * before the cursor, so the document is never copied as a whole, and are
+ * compared against the window, along with the cursor position, to tell text
+ * typed at the cursor, e.g. by keys forwarded to the client, from any other
+ * change.
+ *
+ * The window mostly grows by appending and is only cut once it has grown
+ * well past its length, so that a trigger seeing it again can tell what was
+ * added since.
+ */
+class CursorTextWindow
+{
+public:
+    enum class Change {
+        /** The text before the cursor is the same as before. */
+        None,
+        /** Text was inserted at the cursor. */
+        Inserted,
+        /** Anything else, e.g. the cursor moved. */
+        Replaced,
+    };
+
+    /**
+     * Apply an edit at the cursor.
+     *
+     * @param deleteBeforeCursor Number of UTF-16 code units deleted before the cursor.
+     * @param insert             Text inserted at the cursor.
+     */
+    void edit(qsizetype deleteBeforeCursor, QStringView insert);
+
+    /**
+     * Take the text before the cursor from a surrounding-text update.
+     *
+     * @param text   The surrounding text.
+     * @param cursor Cursor position in UTF-16 code units.
+     * @param anchor Anchor position in UTF-16 code units.
+     * @return How the text before the cursor changed.
+     */
+    Change update(const QString &text, qsizetype cursor, qsizetype anchor);
+
+    /**
+     * Forget the text, e.g. when the input context changes.
+     */
+    void reset();
+
+    /**
+     * The text before the cursor; its start may be cut.
+     */
+    const QString &beforeCursor() const;
+
+private:
+    void trim();
+
+    QString m_before;
+    /** Cursor position in the surrounding text, as far as known. */
+    qsizetype m_position = 0;
+    bool m_known = false;
+};
@@ -7,6 +7,7 @@
 #include "diacriticsdataloader.h"
 
 #include "logging.h"
+#include "startupprofiler.h"
 
 #include <QFile>
 #include <QJsonArray>
@@ -15,6 +16,8 @@
 #include <QJsonParseError>
 #include <QSet>
 #include <QStandardPaths>
+#include <QStringIterator>
+#include <QTextBoundaryFinder>
 
 using namespace Qt::StringLiterals;
 
@@ -34,17 +37,49 @@ static const QString kBaseFileName = u"base.json"_s;
 /// when base.json cannot be found on the filesystem.
 static const QString kResourceBasePath = u":/diacritics/base.json"_s;
 
+/// Directory beneath CacheLocation where merged diacritics indexes are cached,
+/// one file per enabled-locale list.
+static const QString kCacheSubPath = u"/diacritics/"_s;
+
+/// Whether @p text is exactly one grapheme cluster.
+static bool isSingleGrapheme(const QString &text)
+{
+    if (text.isEmpty()) {
+        return false;
+    }
+    QTextBoundaryFinder finder(QTextBoundaryFinder::Grapheme, text);
+    return finder.toNextBoundary() == text.size();
+}
+
+/// Whether every code point of @p text can be shown as a keyboard alternate.
+/// Format characters such as ZERO WIDTH JOINER are allowed since they only
+/// occur inside clusters (e.g. emoji ZWJ sequences); unpaired surrogates are not.
+static bool isDisplayable(const QString &text)
+{
+    QStringIterator it(text);
+    while (it.hasNext()) {
+        const char32_t codePoint = it.next(0xFFFFFFFF);
+        if (codePoint == 0xFFFFFFFF) {
+            return false;
+        }
+        if (!QChar::isPrint(codePoint) && QChar::category(codePoint) != QChar::Other_Format) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // ── Public API ───────────────────────────────────────────────────────────────
 
-QHash<QChar, QStringList> DiacriticsDataLoader::loadMap(const QStringList &enabledLocales)
+QHash<QString, QStringList> DiacriticsDataLoader::loadMap(const QStringList &enabledLocales)
 {
-    const QHash<QChar, QStringList> base = loadBaseMap();
+    const QHash<QString, QStringList> base = loadBaseMap();
 
     if (enabledLocales.isEmpty()) {
         return base;
     }
 
-    QList<QHash<QChar, QStringList>> localeMaps;
+    QList<QHash<QString, QStringList>> localeMaps;
     localeMaps.reserve(enabledLocales.size());
     for (const QString &locale : enabledLocales) {
         localeMaps.append(loadLocaleMap(locale));
@@ -53,12 +88,22 @@ QHash<QChar, QStringList> DiacriticsDataLoader::loadMap(const QStringList &enabl
     return mergeMaps(base, localeMaps);
 }
 
-QHash<QChar, QStringList> DiacriticsDataLoader::loadBaseMap()
+DiacriticsIndex DiacriticsDataLoader::loadIndex(const QStringList &enabledLocales)
+{
+    StartupProfiler::Scope scope("DiacriticsDataLoader::loadIndex");
+    const QString basePath = QStandardPaths::locate(QStandardPaths::GenericDataLocation, kDataSubPath + kBaseFileName);
+    const quint64 fingerprint = MappedIndex::sourceFingerprint(basePath.isEmpty() ? kResourceBasePath : basePath, kDataSubPath, enabledLocales);
+    return DiacriticsIndex::cached(MappedIndex::cachePath(kCacheSubPath, enabledLocales), fingerprint, [&enabledLocales, fingerprint] {
+        return DiacriticsIndex::build(loadMap(enabledLocales), fingerprint);
+    });
+}
+
+QHash<QString, QStringList> DiacriticsDataLoader::loadBaseMap()
 {
     // Try GenericDataLocation first (e.g., ~/.local/share/plasma/keyboard/diacritics/base.json or the installed equivalent).
     const QString path = QStandardPaths::locate(QStandardPaths::GenericDataLocation, kDataSubPath + kBaseFileName);
     if (!path.isEmpty()) {
-        const QHash<QChar, QStringList> result = parseJsonFile(path);
+        const QHash<QString, QStringList> result = parseJsonFile(path);
         if (!result.isEmpty()) {
             qCDebug(PlasmaKeyboard) << "DiacriticsDataLoader: Loaded base map from" << path;
             return result;
@@ -68,7 +113,7 @@ QHash<QChar, QStringList> DiacriticsDataLoader::loadBaseMap()
     // Fallback: compiled-in Qt resource (populated by diacritics.qrc).
     QFile resourceFile(kResourceBasePath);
     if (resourceFile.open(QIODevice::ReadOnly)) {
-        const QHash<QChar, QStringList> result = parseJsonContent(resourceFile.readAll(), kResourceBasePath);
+        const QHash<QString, QStringList> result = parseJsonContent(resourceFile.readAll(), kResourceBasePath);
         if (!result.isEmpty()) {
             qCDebug(PlasmaKeyboard) << "DiacriticsDataLoader: Loaded base map from Qt resource";
             return result;
@@ -80,7 +125,7 @@ QHash<QChar, QStringList> DiacriticsDataLoader::loadBaseMap()
     return {};
 }
 
-QHash<QChar, QStringList> DiacriticsDataLoader::loadLocaleMap(const QString &locale)
+QHash<QString, QStringList> DiacriticsDataLoader::loadLocaleMap(const QString &locale)
 {
     const QString fileName = locale + u".json"_s;
     const QString path = QStandardPaths::locate(QStandardPaths::GenericDataLocation, kDataSubPath + fileName);
@@ -91,7 +136,7 @@ QHash<QChar, QStringList> DiacriticsDataLoader::loadLocaleMap(const QString &loc
         return {};
     }
 
-    const QHash<QChar, QStringList> result = parseJsonFile(path);
+    const QHash<QString, QStringList> result = parseJsonFile(path);
     if (result.isEmpty()) {
         qCWarning(PlasmaKeyboard) << "DiacriticsDataLoader: Failed to parse locale diacritics file for" << locale;
     } else {
@@ -100,10 +145,10 @@ QHash<QChar, QStringList> DiacriticsDataLoader::loadLocaleMap(const QString &loc
     return result;
 }
 
-QHash<QChar, QStringList> DiacriticsDataLoader::mergeMaps(const QHash<QChar, QStringList> &base, const QList<QHash<QChar, QStringList>> &localeMaps)
+QHash<QString, QStringList> DiacriticsDataLoader::mergeMaps(const QHash<QString, QStringList> &base, const QList<QHash<QString, QStringList>> &localeMaps)
 {
-    // Collect the union of all character keys across base and all locale maps.
-    QSet<QChar> allKeys;
+    // Collect the union of all base keys across base and all locale maps.
+    QSet<QString> allKeys;
     allKeys.reserve(base.size());
     for (auto it = base.cbegin(); it != base.cend(); ++it) {
         allKeys.insert(it.key());
@@ -114,10 +159,10 @@ QHash<QChar, QStringList> DiacriticsDataLoader::mergeMaps(const QHash<QChar, QSt
         }
     }
 
-    QHash<QChar, QStringList> merged;
+    QHash<QString, QStringList> merged;
     merged.reserve(allKeys.size());
 
-    for (const QChar key : std::as_const(allKeys)) {
+    for (const QString &key : std::as_const(allKeys)) {
         QStringList result;
         QSet<QString> seen;
 
@@ -152,7 +197,7 @@ QHash<QChar, QStringList> DiacriticsDataLoader::mergeMaps(const QHash<QChar, QSt
 
 // ── Private helpers ───────────────────────────────────────────────────────────
 
-QHash<QChar, QStringList> DiacriticsDataLoader::parseJsonFile(const QString &filePath)
+QHash<QString, QStringList> DiacriticsDataLoader::parseJsonFile(const QString &filePath)
 {
     QFile file(filePath);
     if (!file.open(QIODevice::ReadOnly)) {
@@ -162,7 +207,7 @@ QHash<QChar, QStringList> DiacriticsDataLoader::parseJsonFile(const QString &fil
     return parseJsonContent(file.readAll(), filePath);
 }
 
-QHash<QChar, QStringList> DiacriticsDataLoader::parseJsonContent(const QByteArray &content, const QString &sourceName)
+QHash<QString, QStringList> DiacriticsDataLoader::parseJsonContent(const QByteArray &content, const QString &sourceName)
 {
     QJsonParseError parseError;
     const QJsonDocument doc = QJsonDocument::fromJson(content, &parseError);
@@ -187,17 +232,17 @@ QHash<QChar, QStringList> DiacriticsDataLoader::parseJsonContent(const QByteArra
         return {};
     }
 
-    QHash<QChar, QStringList> result;
+    QHash<QString, QStringList> result;
     result.reserve(mapObj.size());
 
     for (auto it = mapObj.constBegin(); it != mapObj.constEnd(); ++it) {
-        const QString keyStr = it.key();
-        if (keyStr.size() != 1) {
-            qCWarning(PlasmaKeyboard) << "DiacriticsDataLoader: Map key must be a single character, got:" << keyStr << "in" << sourceName << "(skipping)";
+        const QString key = it.key();
+        if (!isSingleGrapheme(key)) {
+            qCWarning(PlasmaKeyboard) << "DiacriticsDataLoader: Map key" << key << "in" << sourceName
+                                      << "is empty or spans more than one grapheme cluster (skipping)";
             continue;
         }
 
-        const QChar key = keyStr.at(0);
         const QJsonArray candidatesArray = it.value().toArray();
 
         QStringList candidates;
@@ -205,22 +250,15 @@ QHash<QChar, QStringList> DiacriticsDataLoader::parseJsonContent(const QByteArra
         for (const QJsonValue &val : candidatesArray) {
             const QString candidate = val.toString();
             if (candidate.isEmpty()) {
-                qCWarning(PlasmaKeyboard) << "DiacriticsDataLoader: Empty candidate string for key" << keyStr << "in" << sourceName << "(skipping)";
+                qCWarning(PlasmaKeyboard) << "DiacriticsDataLoader: Empty candidate string for key" << key << "in" << sourceName << "(skipping)";
                 continue;
             }
 
             // Validate that all characters in the candidate are printable.
             // Non-printable characters (control characters, etc.) cannot be
             // meaningfully displayed as keyboard alternates.
-            bool hasNonPrintable = false;
-            for (const QChar ch : candidate) {
-                if (!ch.isPrint()) {
-                    hasNonPrintable = true;
-                    break;
-                }
-            }
-            if (hasNonPrintable) {
-                qCWarning(PlasmaKeyboard) << "DiacriticsDataLoader: Candidate" << candidate << "for key" << keyStr << "in" << sourceName
+            if (!isDisplayable(candidate)) {
+                qCWarning(PlasmaKeyboard) << "DiacriticsDataLoader: Candidate" << candidate << "for key" << key << "in" << sourceName
                                           << "contains non-printable characters (skipping)";
                 continue;
             }
@@ -231,7 +269,7 @@ QHash<QChar, QStringList> DiacriticsDataLoader::parseJsonContent(const QByteArra
         if (!candidates.isEmpty()) {
             result.insert(key, candidates);
         } else {
-            qCWarning(PlasmaKeyboard) << "DiacriticsDataLoader: No valid candidates for key" << keyStr << "in" << sourceName;
+            qCWarning(PlasmaKeyboard) << "DiacriticsDataLoader: No valid candidates for key" << key << "in" << sourceName;
         }
     }
 
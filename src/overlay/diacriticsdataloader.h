@@ -6,12 +6,12 @@
 
 #pragma once
 
+#include "diacriticsindex.h"
+
 #include <QHash>
 #include <QList>
 #include <QStringList>
 
-class QChar;
-
 /**
  * @file
  *
@@ -28,6 +28,10 @@ class QChar;
  * - Per-locale files (e.g., "de_DE.json") that reorder or extend the base map
  *   for a specific locale. Keys absent from a locale file fall through to the
  *   base map's candidates.
+ *
+ * The merged result for a given locale list is cached as a DiacriticsIndex
+ * under CacheLocation, so that only the first load after a data file or locale
+ * list change has to parse JSON.
  */
 
 /**
@@ -43,18 +47,32 @@ public:
     /**
      * Load and merge the diacritics map for the given enabled locales.
      *
-     * Returns a map from base character to an ordered list of diacritic
-     * candidates. When @p enabledLocales is empty, returns the base map
-     * unchanged.
+     * Returns a map from base key (a single grapheme cluster, e.g. "a",
+     * "क़" or "👍") to an ordered list of diacritic candidates. When
+     * @p enabledLocales is empty, returns the base map unchanged.
      *
      * @param enabledLocales Ordered list of enabled locale codes (e.g.,
      *        {"de_DE", "fr_FR"}). The first entry is the primary locale whose
      *        ordering takes precedence during merging.
-     * @return Merged QHash mapping QChar keys to ordered candidate QStringList
+     * @return Merged QHash mapping base keys to ordered candidate QStringList
      *         values. Returns an empty hash if neither the base file on disk
      *         nor the Qt resource fallback could be loaded.
      */
-    static QHash<QChar, QStringList> loadMap(const QStringList &enabledLocales);
+    static QHash<QString, QStringList> loadMap(const QStringList &enabledLocales);
+
+    /**
+     * Load the merged diacritics table for the given enabled locales as a
+     * compact index.
+     *
+     * Memory-maps a cached index when one exists for @p enabledLocales and its
+     * fingerprint still matches the data files (paths, sizes and modification
+     * times). Otherwise the map is loaded through loadMap(), converted to an
+     * index and written back to the cache for the next start.
+     *
+     * @param enabledLocales Ordered list of enabled locale codes, see loadMap().
+     * @return The diacritics index; empty (but valid) if no data is available.
+     */
+    static DiacriticsIndex loadIndex(const QStringList &enabledLocales);
 
     /**
      * Load the base diacritics map from the "base.json" data file.
@@ -67,10 +85,10 @@ public:
      * Logs a warning if neither the filesystem nor the resource file is
      * available.
      *
-     * @return QHash mapping QChar keys to candidate QStringList values, or
+     * @return QHash mapping base keys to candidate QStringList values, or
      *         an empty hash if neither source is available.
      */
-    static QHash<QChar, QStringList> loadBaseMap();
+    static QHash<QString, QStringList> loadBaseMap();
 
     /**
      * Load the locale-specific diacritics map for the given locale.
@@ -84,16 +102,16 @@ public:
      * (not an error; gracefully falls back to the base map for that locale).
      *
      * @param locale BCP 47-style locale code (e.g., "de_DE").
-     * @return QHash mapping QChar keys to candidate QStringList values, or
+     * @return QHash mapping base keys to candidate QStringList values, or
      *         an empty hash if the locale file is not found or cannot be
      *         parsed.
      */
-    static QHash<QChar, QStringList> loadLocaleMap(const QString &locale);
+    static QHash<QString, QStringList> loadLocaleMap(const QString &locale);
 
     /**
      * Merge a base map with zero or more locale-specific maps.
      *
-     * For each character key, candidates are ordered as follows:
+     * For each base key, candidates are ordered as follows:
      * 1. Candidates from the primary (first) locale map, in its order.
      * 2. New candidates from each subsequent locale map, in list order,
      *    excluding duplicates already seen.
@@ -107,7 +125,7 @@ public:
      * @return Merged QHash with the union of all candidates, ordered by
      *         primary-locale priority.
      */
-    static QHash<QChar, QStringList> mergeMaps(const QHash<QChar, QStringList> &base, const QList<QHash<QChar, QStringList>> &localeMaps);
+    static QHash<QString, QStringList> mergeMaps(const QHash<QString, QStringList> &base, const QList<QHash<QString, QStringList>> &localeMaps);
 
 private:
     /**
@@ -117,15 +135,16 @@ private:
      * @return Parsed QHash, or an empty hash if the file cannot be opened or
      *         parsed.
      */
-    static QHash<QChar, QStringList> parseJsonFile(const QString &filePath);
+    static QHash<QString, QStringList> parseJsonFile(const QString &filePath);
 
     /**
      * Parse raw JSON bytes into a diacritics QHash.
      *
      * Validates the "version" field (must equal 1) and iterates the "map"
-     * object. Each key must be a single character; multi-character keys, empty
-     * candidate strings, and candidates containing non-printable characters
-     * are logged as warnings and skipped.
+     * object. Each key must be a single grapheme cluster, which may span
+     * several code points or UTF-16 code units; keys spanning several
+     * clusters, empty candidate strings, and candidates containing
+     * non-printable characters are logged as warnings and skipped.
      *
      * @param content    Raw JSON bytes.
      * @param sourceName Descriptive label used in log messages (e.g. file
@@ -133,5 +152,5 @@ private:
      * @return Parsed QHash, or an empty hash on version mismatch or JSON
      *         parse error.
      */
-    static QHash<QChar, QStringList> parseJsonContent(const QByteArray &content, const QString &sourceName);
+    static QHash<QString, QStringList> parseJsonContent(const QByteArray &content, const QString &sourceName);
 };
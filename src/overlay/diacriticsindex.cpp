@@ -0,0 +1,270 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "diacriticsindex.h"
+
+#include "logging.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+/// Identifies a diacritics index file ("PKDI" in native byte order).
+static constexpr quint32 kMagic = 0x49444b50;
+
+/// Bumped whenever the on-disk layout changes; older files are rebuilt.
+static constexpr quint32 kFormatVersion = 2;
+
+struct DiacriticsIndex::Header {
+    MappedIndex::Prefix prefix;
+    quint32 keyCount;
+    quint32 candidateCount;
+    quint32 poolSize; ///< In UTF-16 code units.
+    quint32 reserved;
+};
+
+struct DiacriticsIndex::KeyEntry {
+    quint32 keyOffset; ///< Into the pool, in UTF-16 code units.
+    quint16 keyLength; ///< In UTF-16 code units.
+    quint16 candidateCount;
+    quint32 firstCandidate;
+};
+
+struct DiacriticsIndex::CandidateEntry {
+    quint32 offset; ///< Into the pool, in UTF-16 code units.
+    quint32 length; ///< In UTF-16 code units.
+};
+
+static std::u16string_view toStringView(QStringView string)
+{
+    return std::u16string_view(string.utf16(), string.size());
+}
+
+// ── Construction ─────────────────────────────────────────────────────────────
+
+DiacriticsIndex DiacriticsIndex::build(const QHash<QString, QStringList> &map, quint64 fingerprint)
+{
+    // Entries whose key length or candidate count does not fit a KeyEntry
+    // are left out rather than truncated.
+    constexpr qsizetype maxKeyEntryValue = std::numeric_limits<quint16>::max();
+    QStringList sortedKeys;
+    sortedKeys.reserve(map.size());
+    quint32 candidateCount = 0;
+    quint32 poolSize = 0;
+    for (auto it = map.cbegin(); it != map.cend(); ++it) {
+        if (it.key().size() > maxKeyEntryValue || it.value().size() > maxKeyEntryValue) {
+            qCWarning(PlasmaKeyboard) << "DiacriticsIndex: Skipping oversized entry with a key of" << it.key().size() << "code units and"
+                                      << it.value().size() << "candidates";
+            continue;
+        }
+        sortedKeys.append(it.key());
+        poolSize += it.key().size();
+        candidateCount += it.value().size();
+        for (const QString &candidate : it.value()) {
+            poolSize += candidate.size();
+        }
+    }
+
+    // Sorted by code units, the order find() searches in.
+    std::sort(sortedKeys.begin(), sortedKeys.end(), [](const QString &a, const QString &b) {
+        return toStringView(a) < toStringView(b);
+    });
+
+    const qsizetype keysOffset = sizeof(Header);
+    const qsizetype candidatesOffset = keysOffset + sortedKeys.size() * sizeof(KeyEntry);
+    const qsizetype poolOffset = candidatesOffset + candidateCount * sizeof(CandidateEntry);
+
+    QByteArray data(poolOffset + poolSize * sizeof(char16_t), Qt::Uninitialized);
+    char *base = data.data();
+
+    Header header{{kMagic, kFormatVersion, fingerprint}, quint32(sortedKeys.size()), candidateCount, poolSize, 0};
+    std::memcpy(base, &header, sizeof(Header));
+
+    auto *keyEntries = reinterpret_cast<KeyEntry *>(base + keysOffset);
+    auto *candidateEntries = reinterpret_cast<CandidateEntry *>(base + candidatesOffset);
+    auto *poolData = reinterpret_cast<char16_t *>(base + poolOffset);
+
+    quint32 nextCandidate = 0;
+    quint32 nextPoolOffset = 0;
+    for (const QString &key : std::as_const(sortedKeys)) {
+        const QStringList candidates = map.value(key);
+        *keyEntries++ = KeyEntry{nextPoolOffset, quint16(key.size()), quint16(candidates.size()), nextCandidate};
+        std::memcpy(poolData + nextPoolOffset, key.utf16(), key.size() * sizeof(char16_t));
+        nextPoolOffset += key.size();
+        for (const QString &candidate : candidates) {
+            *candidateEntries++ = CandidateEntry{nextPoolOffset, quint32(candidate.size())};
+            std::memcpy(poolData + nextPoolOffset, candidate.utf16(), candidate.size() * sizeof(char16_t));
+            nextPoolOffset += candidate.size();
+        }
+        nextCandidate += candidates.size();
+    }
+
+    return DiacriticsIndex(MappedIndex(data));
+}
+
+DiacriticsIndex::DiacriticsIndex(const MappedIndex &index)
+    : m_index(index)
+{
+}
+
+DiacriticsIndex DiacriticsIndex::open(const QString &filePath)
+{
+    return DiacriticsIndex(MappedIndex::open(filePath, format()));
+}
+
+DiacriticsIndex DiacriticsIndex::cached(const QString &filePath, quint64 fingerprint, const std::function<DiacriticsIndex()> &build)
+{
+    return DiacriticsIndex(MappedIndex::cached(filePath, format(), fingerprint, [&build] {
+        return build().m_index;
+    }));
+}
+
+const MappedIndex::Format &DiacriticsIndex::format()
+{
+    static const MappedIndex::Format format{kMagic, kFormatVersion, "diacritics index", &DiacriticsIndex::validate};
+    return format;
+}
+
+bool DiacriticsIndex::validate(const QByteArray &data)
+{
+    if (data.size() < qsizetype(sizeof(Header))) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, data.constData(), sizeof(Header));
+
+    const qsizetype expectedSize =
+        sizeof(Header) + qsizetype(header.keyCount) * sizeof(KeyEntry) + qsizetype(header.candidateCount) * sizeof(CandidateEntry) + qsizetype(header.poolSize) * sizeof(char16_t);
+    if (data.size() != expectedSize) {
+        return false;
+    }
+
+    // Every range must stay inside its table so lookups never need bounds checks.
+    const auto *keyEntries = reinterpret_cast<const KeyEntry *>(data.constData() + sizeof(Header));
+    const auto *candidateEntries = reinterpret_cast<const CandidateEntry *>(keyEntries + header.keyCount);
+    const auto *poolData = reinterpret_cast<const char16_t *>(candidateEntries + header.candidateCount);
+    std::u16string_view previousKey;
+    for (quint32 i = 0; i < header.keyCount; ++i) {
+        const KeyEntry &entry = keyEntries[i];
+        if (quint64(entry.firstCandidate) + entry.candidateCount > header.candidateCount) {
+            return false;
+        }
+        if (entry.keyLength == 0 || quint64(entry.keyOffset) + entry.keyLength > header.poolSize) {
+            return false;
+        }
+        const std::u16string_view key(poolData + entry.keyOffset, entry.keyLength);
+        if (i > 0 && previousKey >= key) {
+            return false;
+        }
+        previousKey = key;
+    }
+    for (quint32 i = 0; i < header.candidateCount; ++i) {
+        if (quint64(candidateEntries[i].offset) + candidateEntries[i].length > header.poolSize) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ── Lookup ───────────────────────────────────────────────────────────────────
+
+bool DiacriticsIndex::isValid() const
+{
+    return m_index.isValid();
+}
+
+quint64 DiacriticsIndex::fingerprint() const
+{
+    return m_index.fingerprint();
+}
+
+QByteArray DiacriticsIndex::data() const
+{
+    return m_index.data();
+}
+
+bool DiacriticsIndex::contains(QStringView key) const
+{
+    return find(key) != nullptr;
+}
+
+QStringList DiacriticsIndex::candidates(QStringView key) const
+{
+    const CandidateList list = candidateList(key);
+
+    QStringList result;
+    result.reserve(list.size());
+    for (qsizetype i = 0; i < list.size(); ++i) {
+        result.append(list.at(i).toString());
+    }
+    return result;
+}
+
+DiacriticsIndex::CandidateList DiacriticsIndex::candidateList(QStringView key) const
+{
+    const KeyEntry *entry = find(key);
+    if (!entry) {
+        return {};
+    }
+
+    CandidateList list;
+    list.m_entries = candidateEntries() + entry->firstCandidate;
+    list.m_pool = pool();
+    list.m_count = entry->candidateCount;
+    return list;
+}
+
+QStringView DiacriticsIndex::CandidateList::at(qsizetype i) const
+{
+    Q_ASSERT(i >= 0 && i < m_count);
+    const CandidateEntry &entry = m_entries[i];
+    return QStringView(m_pool + entry.offset, qsizetype(entry.length));
+}
+
+const DiacriticsIndex::Header *DiacriticsIndex::header() const
+{
+    return reinterpret_cast<const Header *>(m_index.constData());
+}
+
+const DiacriticsIndex::KeyEntry *DiacriticsIndex::keys() const
+{
+    return reinterpret_cast<const KeyEntry *>(m_index.constData() + sizeof(Header));
+}
+
+const DiacriticsIndex::CandidateEntry *DiacriticsIndex::candidateEntries() const
+{
+    return reinterpret_cast<const CandidateEntry *>(keys() + header()->keyCount);
+}
+
+const char16_t *DiacriticsIndex::pool() const
+{
+    return reinterpret_cast<const char16_t *>(candidateEntries() + header()->candidateCount);
+}
+
+const DiacriticsIndex::KeyEntry *DiacriticsIndex::find(QStringView key) const
+{
+    if (!isValid() || key.isEmpty()) {
+        return nullptr;
+    }
+
+    const char16_t *poolData = pool();
+    const auto keyOf = [poolData](const KeyEntry &entry) {
+        return std::u16string_view(poolData + entry.keyOffset, entry.keyLength);
+    };
+
+    const std::u16string_view needle = toStringView(key);
+    const KeyEntry *begin = keys();
+    const KeyEntry *end = begin + header()->keyCount;
+    const KeyEntry *it = std::lower_bound(begin, end, needle, [&keyOf](const KeyEntry &entry, std::u16string_view value) {
+        return keyOf(entry) < value;
+    });
+    if (it == end || keyOf(*it) != needle || it->candidateCount == 0) {
+        return nullptr;
+    }
+    return it;
+}
@@ -0,0 +1,152 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "mappedindex.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QStringList>
+#include <QStringView>
+
+#include <functional>
+
+/**
+ * Compact, read-only diacritics lookup table.
+ *
+ * The index is a single contiguous MappedIndex buffer that can be written to
+ * disk and memory-mapped back without any parsing:
+ *
+ * - a header with a magic, the format version, entry counts and the
+ *   fingerprint of the data files it was built from,
+ * - the base keys sorted by UTF-16 code units, each pointing at its key
+ *   string in the pool and at a contiguous range of candidate entries,
+ * - one (offset, length) entry per candidate,
+ * - a single UTF-16 pool holding all key and candidate strings back to back.
+ *
+ * Base keys are full grapheme clusters rather than single code units, so
+ * supplementary-plane characters and multi-code-point bases (e.g. a Devanagari
+ * consonant with nukta, or an emoji taking skin-tone modifiers) are looked up
+ * the same way as plain Latin letters: a binary search over a sorted array.
+ *
+ * Copies share the underlying buffer or mapping.
+ */
+class DiacriticsIndex
+{
+    struct Header;
+    struct KeyEntry;
+    struct CandidateEntry;
+
+public:
+    /**
+     * Non-owning view of the ordered candidates of one base key.
+     *
+     * The strings point straight into the index pool; the view stays valid
+     * for as long as a DiacriticsIndex sharing the same buffer is alive.
+     */
+    class CandidateList
+    {
+    public:
+        CandidateList() = default;
+
+        qsizetype size() const
+        {
+            return m_count;
+        }
+
+        bool isEmpty() const
+        {
+            return m_count == 0;
+        }
+
+        /**
+         * The candidate at @p i, which must be in [0, size()).
+         */
+        QStringView at(qsizetype i) const;
+
+    private:
+        friend class DiacriticsIndex;
+
+        const CandidateEntry *m_entries = nullptr;
+        const char16_t *m_pool = nullptr;
+        qsizetype m_count = 0;
+    };
+
+    DiacriticsIndex() = default;
+
+    /**
+     * Build an in-memory index from a merged diacritics map.
+     *
+     * Candidate order is preserved for every key.
+     *
+     * @param map         Merged map as returned by DiacriticsDataLoader::loadMap().
+     * @param fingerprint Fingerprint of the data files @p map was loaded from.
+     */
+    static DiacriticsIndex build(const QHash<QString, QStringList> &map, quint64 fingerprint);
+
+    /**
+     * Memory-map a previously written index file.
+     *
+     * @return The mapped index, or an invalid index if the file cannot be
+     *         mapped or does not contain a well-formed index of the current
+     *         format version.
+     */
+    static DiacriticsIndex open(const QString &filePath);
+
+    /**
+     * Memory-map the index cached in @p filePath if it was built with
+     * @p fingerprint, otherwise build it and cache it there.
+     *
+     * @see MappedIndex::cached()
+     */
+    static DiacriticsIndex cached(const QString &filePath, quint64 fingerprint, const std::function<DiacriticsIndex()> &build);
+
+    /**
+     * Whether the index holds a well-formed table (which may still be empty).
+     */
+    bool isValid() const;
+
+    /**
+     * Fingerprint of the data files this index was built from.
+     */
+    quint64 fingerprint() const;
+
+    /**
+     * The raw index bytes, suitable for writing to a cache file.
+     */
+    QByteArray data() const;
+
+    /**
+     * Whether any candidates exist for @p key.
+     */
+    bool contains(QStringView key) const;
+
+    /**
+     * The ordered candidates for @p key, or an empty list.
+     */
+    QStringList candidates(QStringView key) const;
+
+    /**
+     * The ordered candidates for @p key as a view into the index, without
+     * copying any strings.
+     */
+    CandidateList candidateList(QStringView key) const;
+
+private:
+    explicit DiacriticsIndex(const MappedIndex &index);
+
+    static const MappedIndex::Format &format();
+    static bool validate(const QByteArray &data);
+
+    const Header *header() const;
+    const KeyEntry *keys() const;
+    const CandidateEntry *candidateEntries() const;
+    const char16_t *pool() const;
+    const KeyEntry *find(QStringView key) const;
+
+    MappedIndex m_index;
+};
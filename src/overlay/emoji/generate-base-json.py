@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+# SPDX-FileCopyrightText: 2026 KDE contributors
+# SPDX-License-Identifier: GPL-2.0-or-later
+
+"""
+Generate base.json, the emoji set searched by the emoji overlay, from
+Unicode data instead of maintaining it by hand.
+
+Every fully-qualified emoji of emoji-test.txt is included, in its order,
+except for skin tone variants and the components they are built from. The
+name is derived from the CLDR short name that emoji-test.txt carries. The
+keywords are the words of that name and, if given, the CLDR annotations
+(common/annotations/en.xml and common/annotationsDerived/en.xml), plus the
+hand-picked shortcodes and keywords of extra-keywords.json.
+
+    ./generate-base-json.py emoji-test.txt \\
+        --annotations cldr/common/annotations/en.xml \\
+        --annotations cldr/common/annotationsDerived/en.xml \\
+        --extra extra-keywords.json \\
+        --output base.json
+"""
+
+import argparse
+import json
+import re
+import sys
+import xml.etree.ElementTree as ElementTree
+
+SKIN_TONES = {chr(code_point) for code_point in range(0x1F3FB, 0x1F400)}
+VARIATION_SELECTOR = "\ufe0f"
+
+# Words that carry nothing on their own when searching.
+STOP_WORDS = {"a", "an", "and", "of", "on", "the", "with", "in", "for"}
+
+# Names that are only punctuation once turned into a shortcode.
+NAME_REPLACEMENTS = {"#": "hash", "*": "asterisk"}
+
+
+def words(text):
+    """Lower-case search words of @p text."""
+    text = text.lower().replace("’", "'")
+    return [word for word in re.split(r"[^\w']+", text) if word and word not in STOP_WORDS]
+
+
+def shortcode(name):
+    """Turn a CLDR short name into a shortcode, e.g. "flag: Germany" into "flag_germany"."""
+    for symbol, replacement in NAME_REPLACEMENTS.items():
+        name = name.replace(symbol, replacement)
+    return "_".join(re.split(r"[^\w]+", name.lower().replace("’", ""))).strip("_")
+
+
+def read_emoji_test(path):
+    """(emoji, CLDR short name) of every fully-qualified emoji worth offering."""
+    pattern = re.compile(r"^([0-9A-F ]+);\s*fully-qualified\s*#\s*\S+\s+E\d+\.\d+\s+(.+)$")
+    group = None
+    result = []
+    with open(path, encoding="utf-8") as file:
+        for line in file:
+            if line.startswith("# group:"):
+                group = line.split(":", 1)[1].strip()
+                continue
+            match = pattern.match(line.strip())
+            if not match or group == "Component":
+                continue
+            emoji = "".join(chr(int(code_point, 16)) for code_point in match.group(1).split())
+            if SKIN_TONES.intersection(emoji):
+                continue
+            result.append((emoji, match.group(2).strip()))
+    return result
+
+
+def read_annotations(paths):
+    """Keywords by emoji, without variation selectors, from CLDR annotation files."""
+    result = {}
+    for path in paths:
+        for annotation in ElementTree.parse(path).getroot().iter("annotation"):
+            if annotation.get("type") == "tts" or not annotation.text:
+                continue
+            keywords = result.setdefault(annotation.get("cp").replace(VARIATION_SELECTOR, ""), [])
+            for keyword in annotation.text.split("|"):
+                keywords.extend(words(keyword))
+    return result
+
+
+def read_extra(path):
+    """Hand-picked keywords by emoji, without variation selectors."""
+    if not path:
+        return {}
+    with open(path, encoding="utf-8") as file:
+        extra = json.load(file)["emoji"]
+    return {emoji.replace(VARIATION_SELECTOR, ""): keywords for emoji, keywords in extra.items()}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("emoji_test", help="emoji-test.txt of the Unicode emoji data")
+    parser.add_argument("--annotations", action="append", default=[], help="CLDR annotations XML, may be repeated")
+    parser.add_argument("--extra", help="JSON file of hand-picked keywords by emoji")
+    parser.add_argument("--output", default="-", help="output file, standard output by default")
+    args = parser.parse_args()
+
+    annotations = read_annotations(args.annotations)
+    extra = read_extra(args.extra)
+
+    entries = []
+    seen_names = set()
+    for emoji, cldr_name in read_emoji_test(args.emoji_test):
+        name = shortcode(cldr_name)
+        if name in seen_names:
+            print(f"Duplicate name {name} for {emoji}, skipping", file=sys.stderr)
+            continue
+        seen_names.add(name)
+
+        key = emoji.replace(VARIATION_SELECTOR, "")
+        keywords = []
+        for keyword in words(cldr_name) + annotations.get(key, []) + extra.pop(key, []):
+            if keyword != name and keyword not in keywords:
+                keywords.append(keyword)
+        entries.append({"emoji": emoji, "name": name, "keywords": keywords})
+
+    for emoji in extra:
+        print(f"Extra keywords for {emoji}, which is not in the set", file=sys.stderr)
+
+    output = open(args.output, "w", encoding="utf-8") if args.output != "-" else sys.stdout
+    with output:
+        output.write("{\n")
+        output.write('    "version": 1,\n')
+        output.write('    "description": "Base emoji set with shortcodes and English search keywords, generated by generate-base-json.py",\n')
+        output.write('    "emoji": [\n')
+        lines = [f"        {json.dumps(entry, ensure_ascii=False)}" for entry in entries]
+        output.write(",\n".join(lines))
+        output.write("\n    ]\n}\n")
+
+
+if __name__ == "__main__":
+    main()
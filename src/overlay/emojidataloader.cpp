@@ -0,0 +1,139 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "emojidataloader.h"
+
+#include "logging.h"
+
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QStandardPaths>
+
+using namespace Qt::StringLiterals;
+
+/// The only data-file format version this loader understands.
+static constexpr int kExpectedVersion = 1;
+
+/// Relative path beneath GenericDataLocation where the emoji JSON files are expected.
+static const QString kDataSubPath = u"plasma/keyboard/emoji/"_s;
+
+/// File name of the base emoji list, located under kDataSubPath.
+static const QString kBaseFileName = u"base.json"_s;
+
+/// Compiled-in fallback for base.json (populated by emoji.qrc).
+static const QString kResourceBasePath = u":/emoji/base.json"_s;
+
+/// Directory beneath CacheLocation where emoji indexes are cached.
+static const QString kCacheSubPath = u"/emoji/"_s;
+
+// ── Public API ───────────────────────────────────────────────────────────────
+
+EmojiIndex EmojiDataLoader::loadIndex(const QStringList &enabledLocales)
+{
+    const QString basePath = QStandardPaths::locate(QStandardPaths::GenericDataLocation, kDataSubPath + kBaseFileName);
+    const quint64 fingerprint = MappedIndex::sourceFingerprint(basePath.isEmpty() ? kResourceBasePath : basePath, kDataSubPath, enabledLocales);
+    return EmojiIndex::cached(MappedIndex::cachePath(kCacheSubPath, enabledLocales), fingerprint, [&enabledLocales, fingerprint] {
+        return EmojiIndex::build(loadEntries(enabledLocales), fingerprint);
+    });
+}
+
+QList<EmojiIndex::Entry> EmojiDataLoader::loadEntries(const QStringList &enabledLocales)
+{
+    QList<EmojiIndex::Entry> entries;
+
+    const QString basePath = QStandardPaths::locate(QStandardPaths::GenericDataLocation, kDataSubPath + kBaseFileName);
+    QFile baseFile(basePath.isEmpty() ? kResourceBasePath : basePath);
+    if (baseFile.open(QIODevice::ReadOnly)) {
+        entries = parseJsonContent(baseFile.readAll(), baseFile.fileName());
+    }
+    if (entries.isEmpty()) {
+        qCWarning(PlasmaKeyboard) << "EmojiDataLoader: Could not load base.json from filesystem or Qt resource;"
+                                     " emoji search will be unavailable until data files are installed.";
+    }
+
+    QHash<QString, qsizetype> positions;
+    positions.reserve(entries.size());
+    for (qsizetype i = 0; i < entries.size(); ++i) {
+        positions.insert(entries.at(i).emoji, i);
+    }
+
+    // Locale files add keywords to known emoji and may introduce new ones.
+    for (const QString &locale : enabledLocales) {
+        const QString path = QStandardPaths::locate(QStandardPaths::GenericDataLocation, kDataSubPath + locale + u".json"_s);
+        if (path.isEmpty()) {
+            continue;
+        }
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            qCWarning(PlasmaKeyboard) << "EmojiDataLoader: Cannot open file:" << path;
+            continue;
+        }
+
+        const QList<EmojiIndex::Entry> localeEntries = parseJsonContent(file.readAll(), path);
+        for (const EmojiIndex::Entry &localeEntry : localeEntries) {
+            const auto it = positions.constFind(localeEntry.emoji);
+            if (it == positions.cend()) {
+                positions.insert(localeEntry.emoji, entries.size());
+                entries.append(localeEntry);
+                continue;
+            }
+            EmojiIndex::Entry &entry = entries[it.value()];
+            entry.keywords.append(localeEntry.keywords);
+            if (!localeEntry.name.isEmpty() && localeEntry.name != entry.name) {
+                entry.keywords.append(localeEntry.name);
+            }
+        }
+        qCDebug(PlasmaKeyboard) << "EmojiDataLoader: Loaded locale keywords for" << locale << "from" << path;
+    }
+
+    return entries;
+}
+
+// ── Private helpers ───────────────────────────────────────────────────────────
+
+QList<EmojiIndex::Entry> EmojiDataLoader::parseJsonContent(const QByteArray &content, const QString &sourceName)
+{
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(content, &parseError);
+    if (doc.isNull() || parseError.error != QJsonParseError::NoError) {
+        qCWarning(PlasmaKeyboard) << "EmojiDataLoader: JSON parse error in" << sourceName << "at offset" << parseError.offset << ":" << parseError.errorString();
+        return {};
+    }
+
+    const QJsonObject root = doc.object();
+    const int version = root.value("version"_L1).toInt();
+    if (version != kExpectedVersion) {
+        qCWarning(PlasmaKeyboard) << "EmojiDataLoader: Unsupported version" << version << "in" << sourceName << "(expected" << kExpectedVersion << ")";
+        return {};
+    }
+
+    const QJsonArray emojiArray = root.value("emoji"_L1).toArray();
+    QList<EmojiIndex::Entry> result;
+    result.reserve(emojiArray.size());
+
+    for (const QJsonValue &value : emojiArray) {
+        const QJsonObject object = value.toObject();
+        EmojiIndex::Entry entry;
+        entry.emoji = object.value("emoji"_L1).toString();
+        if (entry.emoji.isEmpty()) {
+            qCWarning(PlasmaKeyboard) << "EmojiDataLoader: Entry without emoji in" << sourceName << "(skipping)";
+            continue;
+        }
+        entry.name = object.value("name"_L1).toString();
+        const QJsonArray keywords = object.value("keywords"_L1).toArray();
+        entry.keywords.reserve(keywords.size());
+        for (const QJsonValue &keyword : keywords) {
+            entry.keywords.append(keyword.toString());
+        }
+        result.append(std::move(entry));
+    }
+
+    return result;
+}
@@ -0,0 +1,63 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "emojiindex.h"
+
+#include <QList>
+#include <QStringList>
+
+/**
+ * @file
+ *
+ * Static utility class for loading the emoji search database.
+ *
+ * Data files are discovered via QStandardPaths under "plasma/keyboard/emoji/",
+ * with the same layout as the diacritics data:
+ * - "base.json" lists every emoji with its short name and English keywords,
+ *   in the order used to break ties between search results. A compiled-in
+ *   copy is used when the file is not installed.
+ * - Optional per-locale files (e.g. "de_DE.json") add localized keywords to
+ *   existing emoji, or new emoji, using the same format.
+ *
+ * The merged result for a given locale list is cached as an EmojiIndex under
+ * CacheLocation, so that only the first load after a data file or locale list
+ * change has to parse JSON.
+ */
+class EmojiDataLoader
+{
+public:
+    /**
+     * Load the emoji search index for the given enabled locales.
+     *
+     * Memory-maps a cached index when one exists for @p enabledLocales and its
+     * fingerprint still matches the data files. Otherwise the data files are
+     * parsed, converted to an index and written back to the cache.
+     *
+     * @param enabledLocales Ordered list of enabled locale codes.
+     * @return The emoji index; empty (but valid) if no data is available.
+     */
+    static EmojiIndex loadIndex(const QStringList &enabledLocales);
+
+    /**
+     * Load and merge the emoji entries of the base file and every locale
+     * file in @p enabledLocales.
+     */
+    static QList<EmojiIndex::Entry> loadEntries(const QStringList &enabledLocales);
+
+private:
+    /**
+     * Parse raw JSON bytes into emoji entries.
+     *
+     * Validates the "version" field (must equal 1) and reads the "emoji"
+     * array. Entries without an "emoji" string are logged and skipped.
+     *
+     * @param content    Raw JSON bytes.
+     * @param sourceName Descriptive label used in log messages.
+     */
+    static QList<EmojiIndex::Entry> parseJsonContent(const QByteArray &content, const QString &sourceName);
+};
@@ -0,0 +1,316 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "emojiindex.h"
+
+#include <QSet>
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+/// Identifies an emoji index file ("PKEI" in native byte order).
+static constexpr quint32 kMagic = 0x49454b50;
+
+/// Bumped whenever the on-disk layout changes; older files are rebuilt.
+static constexpr quint32 kFormatVersion = 1;
+
+/// Keyword entry flag: the keyword is the emoji's short name.
+static constexpr quint16 kNameFlag = 0x1;
+
+struct EmojiIndex::Header {
+    MappedIndex::Prefix prefix;
+    quint32 emojiCount;
+    quint32 keywordCount;
+    quint32 poolSize; ///< In UTF-16 code units.
+    quint32 reserved;
+};
+
+struct EmojiIndex::EmojiEntry {
+    quint32 textOffset; ///< Into the pool, in UTF-16 code units.
+    quint16 textLength; ///< In UTF-16 code units.
+    quint16 nameLength; ///< In UTF-16 code units.
+    quint32 nameOffset; ///< Into the pool, in UTF-16 code units.
+};
+
+struct EmojiIndex::KeywordEntry {
+    quint32 offset; ///< Into the pool, in UTF-16 code units.
+    quint16 length; ///< In UTF-16 code units.
+    quint16 flags;
+    quint32 emoji; ///< Index into the emoji entries.
+};
+
+static std::u16string_view toStringView(QStringView string)
+{
+    return std::u16string_view(string.utf16(), string.size());
+}
+
+// ── Construction ─────────────────────────────────────────────────────────────
+
+EmojiIndex EmojiIndex::build(const QList<Entry> &entries, quint64 fingerprint)
+{
+    struct Keyword {
+        QString text;
+        quint16 flags;
+        quint32 emoji;
+    };
+
+    QList<Keyword> keywords;
+    quint32 poolSize = 0;
+    for (qsizetype i = 0; i < entries.size(); ++i) {
+        const Entry &entry = entries.at(i);
+        poolSize += entry.emoji.size() + entry.name.size();
+
+        QSet<QString> seen;
+        const QString name = entry.name.toLower();
+        if (!name.isEmpty()) {
+            seen.insert(name);
+            keywords.append({name, kNameFlag, quint32(i)});
+        }
+        for (const QString &keyword : entry.keywords) {
+            const QString folded = keyword.toLower();
+            if (!folded.isEmpty() && !seen.contains(folded)) {
+                seen.insert(folded);
+                keywords.append({folded, 0, quint32(i)});
+            }
+        }
+    }
+
+    // Sorted by code units, the order search() scans in.
+    std::sort(keywords.begin(), keywords.end(), [](const Keyword &a, const Keyword &b) {
+        const std::u16string_view left = toStringView(a.text);
+        const std::u16string_view right = toStringView(b.text);
+        return left != right ? left < right : a.emoji < b.emoji;
+    });
+    for (const Keyword &keyword : std::as_const(keywords)) {
+        poolSize += keyword.text.size();
+    }
+
+    const qsizetype emojiOffset = sizeof(Header);
+    const qsizetype keywordsOffset = emojiOffset + entries.size() * sizeof(EmojiEntry);
+    const qsizetype poolOffset = keywordsOffset + keywords.size() * sizeof(KeywordEntry);
+
+    QByteArray data(poolOffset + poolSize * sizeof(char16_t), Qt::Uninitialized);
+    char *base = data.data();
+
+    Header header{{kMagic, kFormatVersion, fingerprint}, quint32(entries.size()), quint32(keywords.size()), poolSize, 0};
+    std::memcpy(base, &header, sizeof(Header));
+
+    auto *emojiEntries = reinterpret_cast<EmojiEntry *>(base + emojiOffset);
+    auto *keywordEntries = reinterpret_cast<KeywordEntry *>(base + keywordsOffset);
+    auto *poolData = reinterpret_cast<char16_t *>(base + poolOffset);
+
+    quint32 nextPoolOffset = 0;
+    const auto appendToPool = [&](const QString &text) {
+        const quint32 offset = nextPoolOffset;
+        std::memcpy(poolData + offset, text.utf16(), text.size() * sizeof(char16_t));
+        nextPoolOffset += text.size();
+        return offset;
+    };
+
+    for (const Entry &entry : entries) {
+        const quint32 textOffset = appendToPool(entry.emoji);
+        const quint32 nameOffset = appendToPool(entry.name);
+        *emojiEntries++ = EmojiEntry{textOffset, quint16(entry.emoji.size()), quint16(entry.name.size()), nameOffset};
+    }
+    for (const Keyword &keyword : std::as_const(keywords)) {
+        const quint32 offset = appendToPool(keyword.text);
+        *keywordEntries++ = KeywordEntry{offset, quint16(keyword.text.size()), keyword.flags, keyword.emoji};
+    }
+
+    return EmojiIndex(MappedIndex(data));
+}
+
+EmojiIndex::EmojiIndex(const MappedIndex &index)
+    : m_index(index)
+{
+}
+
+EmojiIndex EmojiIndex::open(const QString &filePath)
+{
+    return EmojiIndex(MappedIndex::open(filePath, format()));
+}
+
+EmojiIndex EmojiIndex::cached(const QString &filePath, quint64 fingerprint, const std::function<EmojiIndex()> &build)
+{
+    return EmojiIndex(MappedIndex::cached(filePath, format(), fingerprint, [&build] {
+        return build().m_index;
+    }));
+}
+
+const MappedIndex::Format &EmojiIndex::format()
+{
+    static const MappedIndex::Format format{kMagic, kFormatVersion, "emoji index", &EmojiIndex::validate};
+    return format;
+}
+
+bool EmojiIndex::validate(const QByteArray &data)
+{
+    if (data.size() < qsizetype(sizeof(Header))) {
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, data.constData(), sizeof(Header));
+
+    const qsizetype expectedSize =
+        sizeof(Header) + qsizetype(header.emojiCount) * sizeof(EmojiEntry) + qsizetype(header.keywordCount) * sizeof(KeywordEntry) + qsizetype(header.poolSize) * sizeof(char16_t);
+    if (data.size() != expectedSize) {
+        return false;
+    }
+
+    // Every reference must stay inside its table so lookups never need bounds checks.
+    const auto *emojiEntries = reinterpret_cast<const EmojiEntry *>(data.constData() + sizeof(Header));
+    const auto *keywordEntries = reinterpret_cast<const KeywordEntry *>(emojiEntries + header.emojiCount);
+    const auto *poolData = reinterpret_cast<const char16_t *>(keywordEntries + header.keywordCount);
+    for (quint32 i = 0; i < header.emojiCount; ++i) {
+        const EmojiEntry &entry = emojiEntries[i];
+        if (quint64(entry.textOffset) + entry.textLength > header.poolSize || quint64(entry.nameOffset) + entry.nameLength > header.poolSize) {
+            return false;
+        }
+    }
+    std::u16string_view previous;
+    for (quint32 i = 0; i < header.keywordCount; ++i) {
+        const KeywordEntry &entry = keywordEntries[i];
+        if (entry.emoji >= header.emojiCount || quint64(entry.offset) + entry.length > header.poolSize) {
+            return false;
+        }
+        const std::u16string_view keyword(poolData + entry.offset, entry.length);
+        if (keyword < previous) {
+            return false;
+        }
+        previous = keyword;
+    }
+    return true;
+}
+
+// ── Lookup ───────────────────────────────────────────────────────────────────
+
+bool EmojiIndex::isValid() const
+{
+    return m_index.isValid();
+}
+
+quint64 EmojiIndex::fingerprint() const
+{
+    return m_index.fingerprint();
+}
+
+QByteArray EmojiIndex::data() const
+{
+    return m_index.data();
+}
+
+qsizetype EmojiIndex::size() const
+{
+    return isValid() ? header()->emojiCount : 0;
+}
+
+QList<EmojiIndex::Match> EmojiIndex::search(QStringView prefix, qsizetype limit) const
+{
+    if (prefix.isEmpty()) {
+        return {};
+    }
+    const QString folded = prefix.toString().toLower();
+    return rank(narrow(fullRange(), folded), folded.size(), limit);
+}
+
+EmojiIndex::Range EmojiIndex::fullRange() const
+{
+    return isValid() ? Range{0, header()->keywordCount} : Range{};
+}
+
+EmojiIndex::Range EmojiIndex::narrow(Range within, QStringView foldedPrefix) const
+{
+    if (within.isEmpty()) {
+        return within;
+    }
+
+    const char16_t *poolData = pool();
+    const auto keywordOf = [poolData](const KeywordEntry &entry) {
+        return std::u16string_view(poolData + entry.offset, entry.length);
+    };
+    const std::u16string_view needle = toStringView(foldedPrefix);
+
+    // All keywords starting with the prefix form one contiguous run inside
+    // @p within, beginning at the first keyword not less than the prefix.
+    const KeywordEntry *entries = keywordEntries();
+    const KeywordEntry *first = std::lower_bound(entries + within.begin, entries + within.end, needle, [&keywordOf](const KeywordEntry &entry, std::u16string_view value) {
+        return keywordOf(entry) < value;
+    });
+    const KeywordEntry *last = std::partition_point(first, entries + within.end, [&keywordOf, needle](const KeywordEntry &entry) {
+        return keywordOf(entry).starts_with(needle);
+    });
+    return Range{quint32(first - entries), quint32(last - entries)};
+}
+
+QList<EmojiIndex::Match> EmojiIndex::rank(Range range, qsizetype queryLength, qsizetype limit) const
+{
+    if (range.isEmpty() || limit <= 0) {
+        return {};
+    }
+
+    struct Hit {
+        quint32 emoji;
+        /** Lower is better: exact name, name prefix, exact keyword, keyword prefix. */
+        int rank;
+    };
+    QVarLengthArray<Hit, 64> hits;
+    const KeywordEntry *keywords = keywordEntries();
+    for (quint32 i = range.begin; i < range.end; ++i) {
+        const KeywordEntry &entry = keywords[i];
+        const bool exact = entry.length == queryLength;
+        const bool isName = entry.flags & kNameFlag;
+        hits.append({entry.emoji, (isName ? 0 : 2) + (exact ? 0 : 1)});
+    }
+
+    // Keep the best rank per emoji, then order by rank and data file order.
+    std::sort(hits.begin(), hits.end(), [](const Hit &a, const Hit &b) {
+        return a.emoji != b.emoji ? a.emoji < b.emoji : a.rank < b.rank;
+    });
+    hits.erase(std::unique(hits.begin(),
+                           hits.end(),
+                           [](const Hit &a, const Hit &b) {
+                               return a.emoji == b.emoji;
+                           }),
+               hits.end());
+
+    const qsizetype count = std::min<qsizetype>(limit, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + count, hits.end(), [](const Hit &a, const Hit &b) {
+        return a.rank != b.rank ? a.rank < b.rank : a.emoji < b.emoji;
+    });
+
+    QList<Match> result;
+    result.reserve(count);
+    const char16_t *poolData = pool();
+    const EmojiEntry *entries = emojiEntries();
+    for (qsizetype i = 0; i < count; ++i) {
+        const EmojiEntry &entry = entries[hits.at(i).emoji];
+        result.append({QStringView(poolData + entry.textOffset, qsizetype(entry.textLength)), QStringView(poolData + entry.nameOffset, qsizetype(entry.nameLength))});
+    }
+    return result;
+}
+
+const EmojiIndex::Header *EmojiIndex::header() const
+{
+    return reinterpret_cast<const Header *>(m_index.constData());
+}
+
+const EmojiIndex::EmojiEntry *EmojiIndex::emojiEntries() const
+{
+    return reinterpret_cast<const EmojiEntry *>(m_index.constData() + sizeof(Header));
+}
+
+const EmojiIndex::KeywordEntry *EmojiIndex::keywordEntries() const
+{
+    return reinterpret_cast<const KeywordEntry *>(emojiEntries() + header()->emojiCount);
+}
+
+const char16_t *EmojiIndex::pool() const
+{
+    return reinterpret_cast<const char16_t *>(keywordEntries() + header()->keywordCount);
+}
@@ -0,0 +1,176 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "mappedindex.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QStringList>
+#include <QStringView>
+
+#include <functional>
+
+/**
+ * Read-only emoji search index.
+ *
+ * Like DiacriticsIndex, the index is one contiguous MappedIndex buffer that is
+ * written to disk and memory-mapped back, so the emoji database costs page
+ * cache rather than heap in the keyboard process. It contains:
+ *
+ * - a header with a magic, the format version, entry counts and the
+ *   fingerprint of the data files it was built from,
+ * - one entry per emoji (its text and short name), in data file order,
+ * - every search keyword of every emoji, including the short name, sorted by
+ *   UTF-16 code units,
+ * - a single UTF-16 pool holding all strings back to back.
+ *
+ * A prefix query is a binary search for the first keyword starting with the
+ * prefix followed by a scan over the contiguous range of matching keywords.
+ */
+class EmojiIndex
+{
+    struct Header;
+    struct EmojiEntry;
+    struct KeywordEntry;
+
+public:
+    /**
+     * Source data for one emoji, as loaded by EmojiDataLoader.
+     */
+    struct Entry {
+        QString emoji;
+        /** Short name, e.g. "whale" for 🐳, searched with the highest priority. */
+        QString name;
+        QStringList keywords;
+    };
+
+    /**
+     * One search result. The views point into the index and stay valid for
+     * as long as an EmojiIndex sharing the same buffer is alive.
+     */
+    struct Match {
+        QStringView emoji;
+        QStringView name;
+    };
+
+    /**
+     * The keywords starting with a given query, as a range of the sorted
+     * keyword table. Ranges only make sense for the index they came from.
+     */
+    struct Range {
+        quint32 begin = 0;
+        quint32 end = 0;
+
+        bool isEmpty() const
+        {
+            return begin == end;
+        }
+    };
+
+    EmojiIndex() = default;
+
+    /**
+     * Build an in-memory index.
+     *
+     * Keywords are lower-cased; the order of @p entries is used to break ties
+     * between equally ranked results.
+     *
+     * @param entries     The emoji to index.
+     * @param fingerprint Fingerprint of the data files @p entries were loaded from.
+     */
+    static EmojiIndex build(const QList<Entry> &entries, quint64 fingerprint);
+
+    /**
+     * Memory-map a previously written index file.
+     *
+     * @return The mapped index, or an invalid index if the file cannot be
+     *         mapped or does not contain a well-formed index of the current
+     *         format version.
+     */
+    static EmojiIndex open(const QString &filePath);
+
+    /**
+     * Memory-map the index cached in @p filePath if it was built with
+     * @p fingerprint, otherwise build it and cache it there.
+     *
+     * @see MappedIndex::cached()
+     */
+    static EmojiIndex cached(const QString &filePath, quint64 fingerprint, const std::function<EmojiIndex()> &build);
+
+    /**
+     * Whether the index holds a well-formed table (which may still be empty).
+     */
+    bool isValid() const;
+
+    /**
+     * Fingerprint of the data files this index was built from.
+     */
+    quint64 fingerprint() const;
+
+    /**
+     * The raw index bytes, suitable for writing to a cache file.
+     */
+    QByteArray data() const;
+
+    /**
+     * Number of emoji in the index.
+     */
+    qsizetype size() const;
+
+    /**
+     * Emoji with a short name or keyword starting with @p prefix.
+     *
+     * Matching is case-insensitive. Results are ranked by how well they match:
+     * exact short name, short name prefix, exact keyword, keyword prefix, and
+     * then by data file order.
+     *
+     * @param prefix The query, e.g. "wha".
+     * @param limit  Maximum number of results.
+     */
+    QList<Match> search(QStringView prefix, qsizetype limit) const;
+
+    /**
+     * The range of all keywords, i.e. the result for an empty query.
+     */
+    Range fullRange() const;
+
+    /**
+     * The keywords within @p within that start with @p foldedPrefix.
+     *
+     * When a query grows by a few characters, passing the range of the
+     * previous query narrows it instead of searching the whole table again.
+     *
+     * @param foldedPrefix The lower-cased query.
+     * @param within       A range whose keywords all start with a prefix of
+     *                     @p foldedPrefix, e.g. fullRange().
+     */
+    Range narrow(Range within, QStringView foldedPrefix) const;
+
+    /**
+     * Ranked results for the keywords in @p range, see search().
+     *
+     * @param range       Range returned by narrow().
+     * @param queryLength Length of the query @p range was narrowed to, used
+     *                    to tell exact matches from prefix matches.
+     * @param limit       Maximum number of results.
+     */
+    QList<Match> rank(Range range, qsizetype queryLength, qsizetype limit) const;
+
+private:
+    explicit EmojiIndex(const MappedIndex &index);
+
+    static const MappedIndex::Format &format();
+    static bool validate(const QByteArray &data);
+
+    const Header *header() const;
+    const EmojiEntry *emojiEntries() const;
+    const KeywordEntry *keywordEntries() const;
+    const char16_t *pool() const;
+
+    MappedIndex m_index;
+};
@@ -0,0 +1,79 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "keyholdstatistics.h"
+
+#include <algorithm>
+
+/// Holds longer than this are deliberate (long-press, key repeat) rather than
+/// typing, and would only skew the distribution.
+static constexpr qint64 kMaxTypingHoldMs = 1500;
+
+KeyHoldStatistics::KeyHoldStatistics()
+{
+    m_clock.start();
+}
+
+void KeyHoldStatistics::keyPressed(quint32 nativeScanCode)
+{
+    discard(nativeScanCode);
+    m_pressed.append({nativeScanCode, m_clock.elapsed()});
+}
+
+void KeyHoldStatistics::keyReleased(quint32 nativeScanCode)
+{
+    const auto it = std::find_if(m_pressed.begin(), m_pressed.end(), [nativeScanCode](const Press &press) {
+        return press.nativeScanCode == nativeScanCode;
+    });
+    if (it == m_pressed.end()) {
+        return;
+    }
+    const qint64 durationMs = m_clock.elapsed() - it->startMs;
+    m_pressed.erase(it);
+    recordHold(durationMs);
+}
+
+void KeyHoldStatistics::discard(quint32 nativeScanCode)
+{
+    m_pressed.removeIf([nativeScanCode](const Press &press) {
+        return press.nativeScanCode == nativeScanCode;
+    });
+}
+
+void KeyHoldStatistics::recordHold(qint64 durationMs)
+{
+    if (durationMs < 0 || durationMs > kMaxTypingHoldMs) {
+        return;
+    }
+    m_samples[m_nextSample] = quint16(durationMs);
+    m_nextSample = (m_nextSample + 1) % kSampleCount;
+    m_sampleCount = std::min(m_sampleCount + 1, kSampleCount);
+    m_cachedPercent = -1;
+}
+
+int KeyHoldStatistics::sampleCount() const
+{
+    return m_sampleCount;
+}
+
+int KeyHoldStatistics::percentile(int percent) const
+{
+    if (m_sampleCount < kMinSampleCount) {
+        return -1;
+    }
+    if (percent == m_cachedPercent) {
+        return m_cachedValue;
+    }
+
+    // A partial selection over a few hundred values; cheap enough per key press.
+    QVarLengthArray<quint16, kSampleCount> sorted(m_samples.cbegin(), m_samples.cbegin() + m_sampleCount);
+    const qsizetype rank = std::clamp<qsizetype>((qsizetype(percent) * m_sampleCount + 99) / 100 - 1, 0, m_sampleCount - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+
+    m_cachedPercent = percent;
+    m_cachedValue = sorted.at(rank);
+    return m_cachedValue;
+}
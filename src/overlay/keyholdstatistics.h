@@ -0,0 +1,79 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QVarLengthArray>
+
+#include <array>
+
+/**
+ * Rolling distribution of how long keys are held while typing.
+ *
+ * OverlayController reports every physical press and release; the time in
+ * between is kept for the most recent kSampleCount keystrokes. Holds that
+ * were meant as long-presses (the hold timer expired) are discarded, so the
+ * distribution describes ordinary typing only and LongPressTrigger can place
+ * its threshold just above it.
+ */
+class KeyHoldStatistics
+{
+public:
+    /** Number of recent keystrokes the distribution covers. */
+    static constexpr int kSampleCount = 256;
+
+    /** Percentiles are only reported once this many keystrokes were seen. */
+    static constexpr int kMinSampleCount = 32;
+
+    KeyHoldStatistics();
+
+    void keyPressed(quint32 nativeScanCode);
+    void keyReleased(quint32 nativeScanCode);
+
+    /**
+     * Forget the running press of @p nativeScanCode without recording it,
+     * e.g. because the hold opened an overlay.
+     */
+    void discard(quint32 nativeScanCode);
+
+    /**
+     * Add a hold of @p durationMs to the distribution, unless it is too long
+     * to be ordinary typing. keyReleased() calls this for every completed hold.
+     */
+    void recordHold(qint64 durationMs);
+
+    /**
+     * Number of holds currently in the distribution.
+     */
+    int sampleCount() const;
+
+    /**
+     * The hold duration in milliseconds that @p percent percent of recent
+     * keystrokes did not exceed, or -1 while there are too few samples.
+     */
+    int percentile(int percent) const;
+
+private:
+    struct Press {
+        quint32 nativeScanCode;
+        qint64 startMs;
+    };
+
+    QElapsedTimer m_clock;
+
+    /** Keys currently held; more than a few only with heavy rollover. */
+    QVarLengthArray<Press, 8> m_pressed;
+
+    /** Ring buffer of hold durations in milliseconds. */
+    std::array<quint16, kSampleCount> m_samples{};
+    int m_sampleCount = 0;
+    int m_nextSample = 0;
+
+    /** The last computed percentile, valid until the next sample. */
+    mutable int m_cachedPercent = -1;
+    mutable int m_cachedValue = -1;
+};
@@ -6,18 +6,25 @@
 
 #include "longpresstrigger.h"
 
+#include "candidatemodel.h"
+
 #include "diacriticsdataloader.h"
 #include "logging.h"
 #include "plasmakeyboardsettings.h"
 
 #include <KLocalizedString>
 
+#include <algorithm>
+
 using namespace Qt::StringLiterals;
 
 LongPressTrigger::LongPressTrigger(QObject *parent)
     : OverlayTrigger(parent)
+    , m_usage(new CandidateUsageStore(triggerId(), this))
 {
-    m_diacriticsMap = DiacriticsDataLoader::loadMap(PlasmaKeyboardSettings::self()->enabledLocales());
+    connect(PlasmaKeyboardSettings::self(), &PlasmaKeyboardSettings::diacriticsPopupEnabledChanged, this, &OverlayTrigger::subscriptionsChanged);
+
+    m_diacritics = DiacriticsDataLoader::loadIndex(PlasmaKeyboardSettings::self()->enabledLocales());
 
     // Reload the diacritics map whenever the user changes the enabled locales
     // in the KCM, so the keyboard reflects the new locale ordering without
@@ -42,24 +49,22 @@ QString LongPressTrigger::displayName() const
 
 void LongPressTrigger::reloadMap()
 {
-    m_diacriticsMap = DiacriticsDataLoader::loadMap(PlasmaKeyboardSettings::self()->enabledLocales());
+    m_diacritics = DiacriticsDataLoader::loadIndex(PlasmaKeyboardSettings::self()->enabledLocales());
     qCDebug(PlasmaKeyboard) << "LongPressTrigger: Diacritics map reloaded for locales" << PlasmaKeyboardSettings::self()->enabledLocales();
 }
 
 // clang-format off
 OverlayTriggerResult LongPressTrigger::processEvent(OverlayInputEvent eventType,
-                                                          const QKeyEvent *keyEvent,
+                                                          const KeyRecord *key,
                                                           const QString &text,
                                                           OverlayController *controller)
 // clang-format on
 {
-    Q_UNUSED(controller)
-
     OverlayTriggerResult result;
 
     switch (eventType) {
     case OverlayInputEvent::KeyPress: {
-        if (!keyEvent || !shouldHandleKey(keyEvent)) {
+        if (!key || !shouldHandleKey(*key)) {
             return result;
         }
 
@@ -71,11 +76,11 @@ OverlayTriggerResult LongPressTrigger::processEvent(OverlayInputEvent eventType,
         m_timerStarted = true;
         result.action = OverlayAction::StartTimer;
         result.consumeEvent = true;
-        result.pendingText = keyEvent->text();
-        result.pendingNativeScanCode = keyEvent->nativeScanCode();
-        result.timerDurationMs = m_holdThresholdMs;
+        result.pendingText = key->text();
+        result.pendingNativeScanCode = key->scancode;
+        result.timerDurationMs = holdThresholdMs(controller);
 
-        // qCDebug(PlasmaKeyboard) << "LongPressTrigger: Requesting timer for" << text << "duration" << m_holdThresholdMs << "ms";
+        // qCDebug(PlasmaKeyboard) << "LongPressTrigger: Requesting timer for" << text << "duration" << result.timerDurationMs << "ms";
         break;
     }
 
@@ -85,8 +90,7 @@ OverlayTriggerResult LongPressTrigger::processEvent(OverlayInputEvent eventType,
         }
 
         // Timer expired, request overlay
-        const auto candidateList = this->candidates(text);
-        if (!candidateList.isEmpty()) {
+        if (m_diacritics.contains(text.toLower())) {
             result.action = OverlayAction::OpenOverlay;
             // qCDebug(PlasmaKeyboard) << "LongPressTrigger: Timer expired, opening overlay for" << text;
         }
@@ -114,22 +118,21 @@ bool LongPressTrigger::isEnabled() const
     return PlasmaKeyboardSettings::self()->diacriticsPopupEnabled();
 }
 
-QStringList LongPressTrigger::candidates(const QString &baseText) const
+QList<OverlayInputEvent> LongPressTrigger::subscribedEvents() const
 {
-    if (baseText.isEmpty()) {
-        return {};
-    }
+    return {OverlayInputEvent::KeyPress, OverlayInputEvent::TimerExpired};
+}
 
-    const QChar baseChar = baseText.at(0).toLower();
-    const auto it = m_diacriticsMap.find(baseChar);
-    if (it == m_diacriticsMap.end()) {
+QStringList LongPressTrigger::candidates(const QString &baseText) const
+{
+    const QString baseKey = baseText.toLower();
+    QStringList result = m_diacritics.candidates(baseKey);
+    if (result.isEmpty()) {
         return {};
     }
 
-    QStringList result = it.value();
-
     // Preserve case
-    if (baseText.at(0).isUpper()) {
+    if (baseKey != baseText) {
         for (auto &s : result) {
             s = s.toUpper();
         }
@@ -138,35 +141,97 @@ QStringList LongPressTrigger::candidates(const QString &baseText) const
     return result;
 }
 
-bool LongPressTrigger::shouldHandleKey(const QKeyEvent *event) const
+void LongPressTrigger::populateCandidates(const QString &baseText, CandidateModel *model) const
 {
-    if (!event) {
-        return false;
+    // The model reads straight from the index, so nothing is copied here.
+    const QString baseKey = baseText.toLower();
+    const DiacriticsIndex::CandidateList list = m_diacritics.candidateList(baseKey);
+
+    // Most picked first; ties keep the locale order from the index.
+    model->setCandidates(m_diacritics, list, baseKey != baseText, m_usage->order(baseKey, list));
+}
+
+void LongPressTrigger::candidateCommitted(const QString &baseText, const QString &candidate)
+{
+    // Count the candidate as stored in the index, whatever case it was shown in.
+    const QString baseKey = baseText.toLower();
+    const bool upperCase = baseKey != baseText;
+    const DiacriticsIndex::CandidateList list = m_diacritics.candidateList(baseKey);
+    for (qsizetype i = 0; i < list.size(); ++i) {
+        const QStringView stored = list.at(i);
+        if (upperCase ? stored.toString().toUpper() == candidate : stored == candidate) {
+            m_usage->record(baseKey, stored.toString());
+            return;
+        }
+    }
+}
+
+int LongPressTrigger::holdThresholdMs(const OverlayController *controller) const
+{
+    // Margin above the typical hold, so that a hold at exactly the percentile
+    // does not open the overlay.
+    static constexpr int kAdaptiveMarginMs = 50;
+    // Never adapt below this; shorter holds are too easy to hit by accident.
+    static constexpr int kMinAdaptiveThresholdMs = 150;
+    static constexpr int kMaxAdaptiveThresholdMs = 1500;
+
+    const PlasmaKeyboardSettings *settings = PlasmaKeyboardSettings::self();
+    if (!controller || !settings->diacriticsAdaptiveThresholdEnabled()) {
+        return m_holdThresholdMs;
     }
 
+    const int typicalHoldMs = controller->keyHoldStatistics().percentile(settings->diacriticsAdaptiveThresholdPercentile());
+    if (typicalHoldMs < 0) {
+        // Not enough typing seen yet.
+        return m_holdThresholdMs;
+    }
+    return std::clamp(typicalHoldMs + kAdaptiveMarginMs, kMinAdaptiveThresholdMs, kMaxAdaptiveThresholdMs);
+}
+
+bool LongPressTrigger::shouldHandleKey(const KeyRecord &key) const
+{
     // Never treat backspace/delete as diacritics candidates
-    if (event->key() == Qt::Key_Backspace || event->key() == Qt::Key_Delete) {
+    if (key.qtKey == Qt::Key_Backspace || key.qtKey == Qt::Key_Delete) {
         return false;
     }
 
-    if (event->text().isEmpty()) {
+    if (key.textLength == 0) {
         return false;
     }
 
-    if (event->isAutoRepeat()) {
+    if (key.isRepeat()) {
         return false;
     }
 
     // Only handle simple textual keys without control/meta modifiers
-    const Qt::KeyboardModifiers mods = event->modifiers();
+    const Qt::KeyboardModifiers mods = key.modifiers;
     const bool modifierAllowed = mods == Qt::NoModifier || mods == Qt::ShiftModifier;
     if (!modifierAllowed) {
         return false;
     }
 
-    // Check if we have diacritics for this character
-    const QChar baseChar = event->text().at(0).toLower();
-    return m_diacriticsMap.contains(baseChar);
+    // Check if we have diacritics for the key's text, which may be a grapheme
+    // cluster. It is lower-cased into a buffer on the stack since this runs
+    // for every key typed; lower-casing a code point never takes more than
+    // two code units.
+    char16_t lower[2 * KeyRecord::kMaxTextLength];
+    qsizetype lowerLength = 0;
+    const QStringView text = key.textView();
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        char32_t codePoint = text[i].unicode();
+        if (QChar::isHighSurrogate(codePoint) && i + 1 < text.size() && text[i + 1].isLowSurrogate()) {
+            codePoint = QChar::surrogateToUcs4(text[i], text[i + 1]);
+            ++i;
+        }
+        codePoint = QChar::toLower(codePoint);
+        if (QChar::requiresSurrogates(codePoint)) {
+            lower[lowerLength++] = QChar::highSurrogate(codePoint);
+            lower[lowerLength++] = QChar::lowSurrogate(codePoint);
+        } else {
+            lower[lowerLength++] = char16_t(codePoint);
+        }
+    }
+    return m_diacritics.contains(QStringView(lower, lowerLength));
 }
 
 #include "moc_longpresstrigger.cpp"
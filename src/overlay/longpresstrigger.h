@@ -6,10 +6,11 @@
 
 #pragma once
 
+#include "candidateusagestore.h"
+#include "diacriticsindex.h"
 #include "overlaycontroller.h"
 #include "overlaytrigger.h"
 
-#include <QHash>
 #include <QTimer>
 
 /**
@@ -31,14 +32,17 @@ public:
 
     // clang-format off
     OverlayTriggerResult processEvent(OverlayInputEvent eventType,
-                                            const QKeyEvent *keyEvent,
+                                            const KeyRecord *key,
                                             const QString &text,
                                             OverlayController *controller) override;
     // clang-format on
 
     void reset() override;
     bool isEnabled() const override;
+    QList<OverlayInputEvent> subscribedEvents() const override;
     QStringList candidates(const QString &baseText) const override;
+    void populateCandidates(const QString &baseText, CandidateModel *model) const override;
+    void candidateCommitted(const QString &baseText, const QString &candidate) override;
 
     /**
      * Reload the diacritics map from data files using the currently enabled
@@ -53,10 +57,19 @@ private:
     /**
      * Checks if the key event should be considered for long-press diacritics.
      */
-    bool shouldHandleKey(const QKeyEvent *event) const;
+    bool shouldHandleKey(const KeyRecord &key) const;
 
-    /** Map of base characters to their diacritic variants. */
-    QHash<QChar, QStringList> m_diacriticsMap;
+    /**
+     * The hold delay to use: the configured one, or in adaptive mode one just
+     * above the configured percentile of typing holds seen by @p controller.
+     */
+    int holdThresholdMs(const OverlayController *controller) const;
+
+    /** Base characters and their diacritic variants. */
+    DiacriticsIndex m_diacritics;
+
+    /** How often each alternate was picked, used to put favourites first. */
+    CandidateUsageStore *m_usage = nullptr;
 
     int m_holdThresholdMs = 500;
     bool m_timerStarted = false;
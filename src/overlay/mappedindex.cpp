@@ -0,0 +1,134 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "mappedindex.h"
+
+#include "logging.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+
+using namespace Qt::StringLiterals;
+
+MappedIndex::MappedIndex(const QByteArray &data)
+    : m_data(data)
+{
+}
+
+MappedIndex MappedIndex::open(const QString &filePath, const Format &format)
+{
+    auto file = std::make_shared<QFile>(filePath);
+    if (!file->open(QIODevice::ReadOnly)) {
+        return {};
+    }
+
+    const qint64 size = file->size();
+    uchar *mapped = file->map(0, size);
+    if (!mapped) {
+        return {};
+    }
+
+    const QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), size);
+    Prefix prefix{};
+    if (data.size() >= qsizetype(sizeof(Prefix))) {
+        std::memcpy(&prefix, data.constData(), sizeof(Prefix));
+    }
+    if (prefix.magic != format.magic || prefix.version != format.version || !format.validate(data)) {
+        qCWarning(PlasmaKeyboard) << "MappedIndex: Ignoring malformed or outdated" << format.name << filePath;
+        return {};
+    }
+
+    MappedIndex index;
+    index.m_data = data;
+    index.m_file = std::move(file);
+    return index;
+}
+
+MappedIndex MappedIndex::cached(const QString &filePath, const Format &format, quint64 fingerprint, const std::function<MappedIndex()> &build)
+{
+    if (QFile::exists(filePath)) {
+        const MappedIndex cached = open(filePath, format);
+        if (cached.isValid() && cached.fingerprint() == fingerprint) {
+            qCDebug(PlasmaKeyboard) << "MappedIndex: Using cached" << format.name << filePath;
+            return cached;
+        }
+    }
+
+    const MappedIndex index = build();
+
+    // Failing to write the cache only costs parsing the data files again on the next start.
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile cacheFile(filePath);
+    if (cacheFile.open(QIODevice::WriteOnly) && cacheFile.write(index.m_data) == index.m_data.size() && cacheFile.commit()) {
+        qCDebug(PlasmaKeyboard) << "MappedIndex: Wrote" << format.name << "cache" << filePath;
+    } else {
+        qCDebug(PlasmaKeyboard) << "MappedIndex: Could not write" << format.name << "cache" << filePath << cacheFile.errorString();
+    }
+
+    // Serve lookups from the mapping rather than the freshly built heap copy.
+    const MappedIndex mapped = open(filePath, format);
+    return mapped.isValid() ? mapped : index;
+}
+
+quint64 MappedIndex::sourceFingerprint(const QString &baseFilePath, const QString &dataSubPath, const QStringList &enabledLocales)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+
+    const auto addSource = [&hash](const QString &path) {
+        const QFileInfo info(path);
+        hash.addData(path.toUtf8());
+        hash.addData(QByteArray::number(info.exists() ? info.size() : -1));
+        hash.addData(QByteArray::number(info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1));
+    };
+
+    addSource(baseFilePath);
+
+    for (const QString &locale : enabledLocales) {
+        hash.addData(locale.toUtf8());
+        const QString path = QStandardPaths::locate(QStandardPaths::GenericDataLocation, dataSubPath + locale + u".json"_s);
+        if (!path.isEmpty()) {
+            addSource(path);
+        }
+    }
+
+    quint64 fingerprint = 0;
+    std::memcpy(&fingerprint, hash.resultView().constData(), sizeof(fingerprint));
+    return fingerprint;
+}
+
+QString MappedIndex::cachePath(const QString &cacheSubPath, const QStringList &enabledLocales)
+{
+    const QByteArray localeKey = enabledLocales.isEmpty() ? QByteArrayLiteral("base") : enabledLocales.join(u',').toUtf8();
+    const QByteArray name = QCryptographicHash::hash(localeKey, QCryptographicHash::Sha1).toHex().left(16);
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + cacheSubPath + QString::fromLatin1(name) + u".idx"_s;
+}
+
+bool MappedIndex::isValid() const
+{
+    return !m_data.isEmpty();
+}
+
+quint64 MappedIndex::fingerprint() const
+{
+    return isValid() ? reinterpret_cast<const Prefix *>(m_data.constData())->fingerprint : 0;
+}
+
+QByteArray MappedIndex::data() const
+{
+    return m_data;
+}
+
+const char *MappedIndex::constData() const
+{
+    return m_data.constData();
+}
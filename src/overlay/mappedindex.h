@@ -0,0 +1,124 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <memory>
+
+class QFile;
+
+/**
+ * The buffer behind a read-only lookup table such as DiacriticsIndex or
+ * EmojiIndex.
+ *
+ * An index is one contiguous buffer that is either built in memory or
+ * memory-mapped from a cache file without any parsing, so that the data
+ * costs page cache rather than heap. Every index starts with a Prefix; the
+ * rest of the layout is up to the index, which checks it through its
+ * Format::validate before a mapped file is used.
+ *
+ * Copies share the underlying buffer or mapping.
+ */
+class MappedIndex
+{
+public:
+    /**
+     * The start of every index header.
+     */
+    struct Prefix {
+        quint32 magic;
+        /** Bumped whenever the layout changes; older files are rebuilt. */
+        quint32 version;
+        /** Fingerprint of the data files the index was built from. */
+        quint64 fingerprint;
+    };
+
+    /**
+     * Describes one kind of index.
+     */
+    struct Format {
+        quint32 magic;
+        quint32 version;
+        /** Used in log messages. */
+        const char *name;
+        /**
+         * Whether @p data, whose prefix has been checked already, is a
+         * well-formed index, such that lookups need no bounds checks.
+         */
+        bool (*validate)(const QByteArray &data);
+    };
+
+    MappedIndex() = default;
+
+    /**
+     * An index built in memory.
+     */
+    explicit MappedIndex(const QByteArray &data);
+
+    /**
+     * Memory-map a previously written index file.
+     *
+     * @return The mapped index, or an invalid index if the file cannot be
+     *         mapped or does not contain a well-formed index of @p format.
+     */
+    static MappedIndex open(const QString &filePath, const Format &format);
+
+    /**
+     * Memory-map the index cached in @p filePath if it was built from data
+     * with @p fingerprint. Otherwise build it, write it to @p filePath for the
+     * next start and map it back from there.
+     *
+     * @param build Builds the index in memory, with @p fingerprint.
+     */
+    static MappedIndex cached(const QString &filePath, const Format &format, quint64 fingerprint, const std::function<MappedIndex()> &build);
+
+    /**
+     * Fingerprint of the data files an index for @p enabledLocales is built
+     * from: @p baseFilePath and, for every locale, \c{<locale>.json} beneath
+     * @p dataSubPath in GenericDataLocation.
+     *
+     * Covers the locale list itself and the path, size and modification time
+     * of every file that exists.
+     */
+    static quint64 sourceFingerprint(const QString &baseFilePath, const QString &dataSubPath, const QStringList &enabledLocales);
+
+    /**
+     * Path of the cached index for @p enabledLocales, in @p cacheSubPath
+     * beneath CacheLocation.
+     */
+    static QString cachePath(const QString &cacheSubPath, const QStringList &enabledLocales);
+
+    /**
+     * Whether the index holds a well-formed table (which may still be empty).
+     */
+    bool isValid() const;
+
+    /**
+     * Fingerprint of the data files this index was built from.
+     */
+    quint64 fingerprint() const;
+
+    /**
+     * The raw index bytes, suitable for writing to a cache file.
+     */
+    QByteArray data() const;
+
+    /**
+     * The index bytes, starting with the header.
+     */
+    const char *constData() const;
+
+private:
+    QByteArray m_data;
+
+    /** Keeps the mapping behind m_data alive for indexes returned by open(). */
+    std::shared_ptr<QFile> m_file;
+};
@@ -7,9 +7,12 @@
 #include "overlaycontroller.h"
 
 #include "inputplugin.h"
+#include "latencytracer.h"
 #include "logging.h"
 #include "overlaytrigger.h"
 
+#include <algorithm>
+
 OverlayController::OverlayController(InputPlugin *inputPlugin, QObject *parent)
     : QObject(parent)
     , m_inputPlugin(inputPlugin)
@@ -21,36 +24,55 @@ OverlayController::OverlayController(InputPlugin *inputPlugin, QObject *parent)
     m_overlayGraceTimer.setSingleShot(true);
     connect(&m_overlayGraceTimer, &QTimer::timeout, this, &OverlayController::handleOverlayGraceTimer);
 
-    // The settle timer is a single-shot guard that absorbs extra surrounding_text
-    // echoes from clients that send more than one event per commit_string.
-    // 100 ms is well above any realistic Wayland roundtrip but well below the
-    // long-press threshold, so genuine external cursor moves are not masked.
-    static constexpr int SURROUNDING_TEXT_SETTLE_DELAY_MS = 100;
-    m_surroundingTextSettleTimer.setSingleShot(true);
-    m_surroundingTextSettleTimer.setInterval(SURROUNDING_TEXT_SETTLE_DELAY_MS);
+    // An open overlay is operated with keys, whichever trigger opened it.
+    connect(this, &OverlayController::overlayVisibleChanged, this, &OverlayController::needsKeyboardGrabChanged);
 
-    // Initialize XKB compose state machine using the system locale.
-    m_xkbContext = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-    if (m_xkbContext) {
-        const char *locale = setlocale(LC_CTYPE, nullptr);
-        if (!locale || locale[0] == '\0') {
-            locale = "C";
-        }
-        m_xkbComposeTable = xkb_compose_table_new_from_locale(m_xkbContext, locale, XKB_COMPOSE_COMPILE_NO_FLAGS);
-        if (m_xkbComposeTable) {
-            m_xkbComposeState = xkb_compose_state_new(m_xkbComposeTable, XKB_COMPOSE_STATE_NO_FLAGS);
-        }
+    // Echoes from a previous text field say nothing about the new one, and
+    // the locale may have changed since the compose table was set up.
+    if (m_inputPlugin) {
+        connect(m_inputPlugin, &InputPlugin::contextChanged, this, [this] {
+            m_reconciler.reset();
+            m_textWindow.reset();
+            m_preedit.clear();
+            updateComposeTable();
+            rebuildDispatchTables();
+        });
+        connect(m_inputPlugin, &InputPlugin::contentTypeChanged, this, &OverlayController::rebuildDispatchTables);
     }
+
+    // Initialize XKB compose state machine using the system locale.
+    updateComposeTable();
 }
 
 OverlayController::~OverlayController()
 {
     if (m_xkbComposeState)
         xkb_compose_state_unref(m_xkbComposeState);
-    if (m_xkbComposeTable)
-        xkb_compose_table_unref(m_xkbComposeTable);
-    if (m_xkbContext)
-        xkb_context_unref(m_xkbContext);
+}
+
+void OverlayController::updateComposeTable()
+{
+    const QByteArray locale = XkbCache::composeLocale();
+    if (locale == m_composeLocale) {
+        return;
+    }
+    m_composeLocale = locale;
+
+    // The table is normally precompiled at startup. If it is still being
+    // compiled, keys typed meanwhile are simply not composed.
+    XkbCache::composeTable(locale).then(this, [this, locale](const ComposeTablePtr &table) {
+        if (locale != m_composeLocale) {
+            return; // Superseded by another locale change.
+        }
+        if (m_xkbComposeState) {
+            xkb_compose_state_unref(m_xkbComposeState);
+            m_xkbComposeState = nullptr;
+        }
+        m_xkbComposeTable = table;
+        if (m_xkbComposeTable) {
+            m_xkbComposeState = xkb_compose_state_new(m_xkbComposeTable.get(), XKB_COMPOSE_STATE_NO_FLAGS);
+        }
+    });
 }
 
 void OverlayController::registerTrigger(OverlayTrigger *trigger)
@@ -60,21 +82,77 @@ void OverlayController::registerTrigger(OverlayTrigger *trigger)
     }
     trigger->setParent(this);
     m_triggers.append(trigger);
+    connect(trigger, &OverlayTrigger::subscriptionsChanged, this, &OverlayController::rebuildDispatchTables);
+    rebuildDispatchTables();
 }
 
-bool OverlayController::processKeyPress(QKeyEvent *event)
+void OverlayController::rebuildDispatchTables()
 {
-    if (!event) {
-        return false;
+    const InputPlugin::ContentPurpose contentPurpose = m_inputPlugin ? m_inputPlugin->contentPurpose() : InputPlugin::content_purpose_normal;
+    // Don't trigger overlays in terminal input fields, since they don't usually offer
+    // us surrounding_text information. This can be revisited with text-input v3.2,
+    // which will support styling preedits again, and switching to preedit-based flow
+    // will work for terminals.
+    m_overlaysSuppressed = contentPurpose == InputPlugin::content_purpose_terminal;
+
+    const bool neededKeyboardGrab = needsKeyboardGrab();
+    for (auto &subscribers : m_subscribers) {
+        subscribers.clear();
+    }
+    for (OverlayTrigger *trigger : std::as_const(m_triggers)) {
+        if (!trigger->isEnabled()) {
+            continue;
+        }
+        const QList<OverlayInputEvent> events = trigger->subscribedEvents();
+        for (const OverlayInputEvent event : events) {
+            m_subscribers[size_t(event)].append(trigger);
+        }
     }
 
-    const InputPlugin::ContentPurpose contentPurpose = m_inputPlugin ? m_inputPlugin->contentPurpose() : InputPlugin::content_purpose_normal;
-    // qCDebug(PlasmaKeyboard) << "Content purpose:" << contentPurpose;
-    if (contentPurpose == InputPlugin::content_purpose_terminal) {
-        // Don't trigger overlays in terminal input fields, since they don't usually offer
-        // us surrounding_text information. This can be revisited with text-input v3.2,
-        // which will support styling preedits again, and switching to preedit-based flow
-        // will work for terminals.
+    if (needsKeyboardGrab() != neededKeyboardGrab) {
+        Q_EMIT needsKeyboardGrabChanged();
+    }
+}
+
+bool OverlayController::needsKeyboardGrab() const
+{
+    if (m_overlayVisible) {
+        return true;
+    }
+    return std::any_of(m_subscribers.cbegin(), m_subscribers.cend(), [](const auto &subscribers) {
+        return !subscribers.isEmpty();
+    });
+}
+
+bool OverlayController::wantsTextlessKeys() const
+{
+    if (m_overlayVisible || m_holdTimer.isActive() || m_overlayGraceTimer.isActive() || !m_pendingText.isEmpty()) {
+        return true;
+    }
+    if (m_repeatNativeScanCode != 0 || m_swallowNextRelease) {
+        return true;
+    }
+    if (m_xkbComposeState && xkb_compose_state_get_status(m_xkbComposeState) != XKB_COMPOSE_NOTHING) {
+        return true;
+    }
+    for (const auto event : {OverlayInputEvent::KeyPress, OverlayInputEvent::KeyRelease}) {
+        for (const OverlayTrigger *trigger : m_subscribers[size_t(event)]) {
+            if (trigger->wantsTextlessKeys()) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool OverlayController::processKeyPress(const KeyRecord &key)
+{
+    // Only keys that type something tell how long the user holds keys while typing.
+    if (!key.isRepeat() && key.hasText) {
+        m_keyHoldStatistics.keyPressed(key.scancode);
+    }
+
+    if (m_overlaysSuppressed) {
         return false;
     }
 
@@ -84,22 +162,22 @@ bool OverlayController::processKeyPress(QKeyEvent *event)
     // Compare by native scan code (physical key) rather than Qt key code, because
     // the Qt key code can change if the modifier is released before the repeat fires
     // (e.g. Shift+/ produces Key_Question on press but Key_Slash on repeat).
-    if (event->isAutoRepeat() && (event->nativeScanCode() == m_pendingNativeScanCode || event->nativeScanCode() == m_repeatNativeScanCode)) {
+    if (key.isRepeat() && (key.scancode == m_pendingNativeScanCode || key.scancode == m_repeatNativeScanCode)) {
         // qCDebug(PlasmaKeyboard) << "Suppressing repeat press of pending overlay key" << m_pendingText;
         return true;
     }
 
     // If overlay is visible, handle Esc to cancel
     if (m_overlayVisible) {
-        if (event->key() == Qt::Key_Escape) {
+        if (key.qtKey == Qt::Key_Escape) {
             qCDebug(PlasmaKeyboard) << "Esc pressed while overlay open; cancelling";
             cancelOverlay();
             return true;
         }
 
         // Handle number keys 1-9 for candidate selection
-        if (event->key() >= Qt::Key_1 && event->key() <= Qt::Key_9) {
-            int index = event->key() - Qt::Key_1;
+        if (key.qtKey >= Qt::Key_1 && key.qtKey <= Qt::Key_9) {
+            int index = key.qtKey - Qt::Key_1;
             if (index < m_candidateModel->rowCount()) {
                 qCDebug(PlasmaKeyboard) << "Number key" << (index + 1) << "pressed; committing candidate" << index;
                 commitCandidate(index);
@@ -109,17 +187,23 @@ bool OverlayController::processKeyPress(QKeyEvent *event)
         }
 
         // Handle arrow/Enter keys for overlay navigation
-        switch (event->key()) {
+        switch (key.qtKey) {
         case Qt::Key_Left:
         case Qt::Key_Right:
         case Qt::Key_Up:
         case Qt::Key_Down:
         case Qt::Key_Return:
-            // qCDebug(PlasmaKeyboard) << "Navigation key" << event->key() << "pressed while overlay open; forwarding to overlay";
-            Q_EMIT overlayNavigationKeyPressed(event->key());
+            // qCDebug(PlasmaKeyboard) << "Navigation key" << key.qtKey << "pressed while overlay open; forwarding to overlay";
+            Q_EMIT overlayNavigationKeyPressed(key.qtKey);
             return true;
         }
 
+        // Typing into an open query goes to the client; the trigger updates
+        // or closes the overlay once the text arrives.
+        if (key.textLength > 0 && key.textView().front().isPrint() && activeTriggerFollowsTypedText()) {
+            return false;
+        }
+
         // Any other key cancels the overlay
         cancelOverlay();
         // Fall through to process the new key
@@ -129,9 +213,10 @@ bool OverlayController::processKeyPress(QKeyEvent *event)
     // Keys that are part of a sequence are consumed here; the composed result
     // is committed via commit_string so it never reaches the trigger pipeline.
     if (m_xkbComposeState) {
-        const xkb_keysym_t keysym = static_cast<xkb_keysym_t>(event->nativeVirtualKey());
+        const xkb_keysym_t keysym = key.keysym;
         if (keysym != XKB_KEY_NoSymbol) {
             const xkb_compose_feed_result feedResult = xkb_compose_state_feed(m_xkbComposeState, keysym);
+            LatencyTracer::mark(LatencyTracer::Stage::Compose);
             if (feedResult == XKB_COMPOSE_FEED_ACCEPTED) {
                 const xkb_compose_status status = xkb_compose_state_get_status(m_xkbComposeState);
                 switch (status) {
@@ -148,11 +233,14 @@ bool OverlayController::processKeyPress(QKeyEvent *event)
                     }
                     char buf[64] = {};
                     if (xkb_compose_state_get_utf8(m_xkbComposeState, buf, sizeof(buf)) > 0 && m_inputPlugin) {
-                        ++m_pendingSurroundingTextUpdates;
-                        m_surroundingTextSettleTimer.start();
-                        m_inputPlugin->commit(QString::fromUtf8(buf));
+                        const QString composed = QString::fromUtf8(buf);
+                        m_reconciler.expectEdit(m_inputPlugin->serial(), 0, composed);
+                        m_textWindow.edit(0, composed);
+                        m_inputPlugin->commit(composed);
                     }
                     xkb_compose_state_reset(m_xkbComposeState);
+                    // The composed character was typed like any other.
+                    dispatchTextCommitted();
                     return true; // Consume the completing key.
                 }
                 case XKB_COMPOSE_CANCELLED:
@@ -169,30 +257,26 @@ bool OverlayController::processKeyPress(QKeyEvent *event)
     }
 
     // Dispatch to triggers in order
-    for (auto *trigger : m_triggers) {
-        if (!trigger->isEnabled()) {
-            continue;
-        }
-
-        auto result = trigger->processEvent(OverlayInputEvent::KeyPress, event, event->text(), this);
+    for (auto *trigger : m_subscribers[size_t(OverlayInputEvent::KeyPress)]) {
+        auto result = trigger->processEvent(OverlayInputEvent::KeyPress, &key, QString(), this);
         if (result.action != OverlayAction::None || result.consumeEvent) {
+            LatencyTracer::mark(LatencyTracer::Stage::Triggers);
             executeAction(result, trigger);
             return result.consumeEvent;
         }
     }
+    LatencyTracer::mark(LatencyTracer::Stage::Triggers);
 
     return false;
 }
 
-bool OverlayController::processKeyRelease(QKeyEvent *event)
+bool OverlayController::processKeyRelease(const KeyRecord &key)
 {
-    if (!event) {
-        return false;
-    }
+    m_keyHoldStatistics.keyReleased(key.scancode);
 
     // Compare by native scan code (physical key) so that modifier changes
     // between press and release don't prevent the match.
-    bool keyMatchesPending = (event->nativeScanCode() == m_pendingNativeScanCode);
+    bool keyMatchesPending = (key.scancode == m_pendingNativeScanCode);
 
     // If the overlay grace timer is running and the held key is released,
     // stop the grace timer — the overlay stays visible waiting for selection
@@ -202,7 +286,7 @@ bool OverlayController::processKeyRelease(QKeyEvent *event)
         m_overlayGraceTimer.stop();
     }
 
-    bool keyRepeatActive = (m_repeatNativeScanCode != 0 && event->nativeScanCode() == m_repeatNativeScanCode);
+    bool keyRepeatActive = (m_repeatNativeScanCode != 0 && key.scancode == m_repeatNativeScanCode);
     if (keyRepeatActive) {
         // If key repeat is active, it means we sent a synthetic key(Pressed) to the
         // client after the grace timer expired so that the client would do auto-repeat.
@@ -210,17 +294,15 @@ bool OverlayController::processKeyRelease(QKeyEvent *event)
         // Now that the physical key is released, we will simply not handle the release
         // event, so it gets forwarded and the client sees the release and stops repeating.
         // qCDebug(PlasmaKeyboard) << "Stopping repeat for" << m_repeatNativeScanCode;
-        resetState();
+        finishPendingKey();
         return false;
     }
 
     // Swallow release of a discarded/committed pending key.
-    if (m_swallowNextRelease && event->nativeScanCode() == m_ignoreReleaseNativeScanCode) {
-        if (!event->isAutoRepeat()) {
-            // qCDebug(PlasmaKeyboard) << "Swallowing release for discarded overlay key" << m_ignoreReleaseNativeScanCode;
-            m_swallowNextRelease = false;
-            m_ignoreReleaseNativeScanCode = 0;
-        }
+    if (m_swallowNextRelease && key.scancode == m_ignoreReleaseNativeScanCode) {
+        // qCDebug(PlasmaKeyboard) << "Swallowing release for discarded overlay key" << m_ignoreReleaseNativeScanCode;
+        m_swallowNextRelease = false;
+        m_ignoreReleaseNativeScanCode = 0;
         return true;
     }
 
@@ -240,34 +322,40 @@ bool OverlayController::processKeyRelease(QKeyEvent *event)
         // The client was already sent a synthetic key press and release, so we just need
         // to clear pending state and consume the release (which would be extra as far as the client is concerned).
         qCDebug(PlasmaKeyboard) << "Releasing before overlay; key released";
-        resetState();
+        finishPendingKey();
+        // Only now the base character is known to be typed rather than replaced.
+        dispatchTextCommitted();
         return true;
     }
 
     // Dispatch to triggers for release handling
-    for (auto *trigger : m_triggers) {
-        if (!trigger->isEnabled()) {
-            continue;
-        }
-
-        auto result = trigger->processEvent(OverlayInputEvent::KeyRelease, event, event->text(), this);
+    for (auto *trigger : m_subscribers[size_t(OverlayInputEvent::KeyRelease)]) {
+        auto result = trigger->processEvent(OverlayInputEvent::KeyRelease, &key, QString(), this);
         if (result.action != OverlayAction::None || result.consumeEvent) {
+            LatencyTracer::mark(LatencyTracer::Stage::Triggers);
             executeAction(result, trigger);
             return result.consumeEvent;
         }
     }
+    LatencyTracer::mark(LatencyTracer::Stage::Triggers);
 
     return false;
 }
 
 bool OverlayController::processPreeditChanged(const QString &preedit)
 {
-    for (auto *trigger : m_triggers) {
-        if (!trigger->isEnabled()) {
-            continue;
-        }
+    if (preedit == m_preedit) {
+        return false;
+    }
+    m_preedit = preedit;
 
-        auto result = trigger->processEvent(OverlayInputEvent::PreeditChanged, nullptr, preedit, this);
+    const auto &subscribers = m_subscribers[size_t(OverlayInputEvent::PreeditChanged)];
+    if (subscribers.isEmpty()) {
+        return false;
+    }
+    const QString text = m_textWindow.beforeCursor() + preedit;
+    for (auto *trigger : subscribers) {
+        auto result = trigger->processEvent(OverlayInputEvent::PreeditChanged, nullptr, text, this);
         if (result.action != OverlayAction::None) {
             executeAction(result, trigger);
             return true;
@@ -276,14 +364,20 @@ bool OverlayController::processPreeditChanged(const QString &preedit)
     return false;
 }
 
-bool OverlayController::processTextCommitted(const QString &text)
+bool OverlayController::processTextCommitted(const QString &text, int deleteBeforeCursor)
 {
-    for (auto *trigger : m_triggers) {
-        if (!trigger->isEnabled()) {
-            continue;
-        }
+    // Registered so that the client's echo is not taken for an external change.
+    if (m_inputPlugin) {
+        m_reconciler.expectEdit(m_inputPlugin->serial(), deleteBeforeCursor, text);
+    }
+    m_textWindow.edit(deleteBeforeCursor, text);
+    return dispatchTextCommitted();
+}
 
-        auto result = trigger->processEvent(OverlayInputEvent::TextCommitted, nullptr, text, this);
+bool OverlayController::dispatchTextCommitted()
+{
+    for (auto *trigger : m_subscribers[size_t(OverlayInputEvent::TextCommitted)]) {
+        auto result = trigger->processEvent(OverlayInputEvent::TextCommitted, nullptr, m_textWindow.beforeCursor(), this);
         if (result.action != OverlayAction::None) {
             executeAction(result, trigger);
             return true;
@@ -292,6 +386,19 @@ bool OverlayController::processTextCommitted(const QString &text)
     return false;
 }
 
+bool OverlayController::activeTriggerFollowsTypedText() const
+{
+    if (m_activeTriggerId.isEmpty()) {
+        return false;
+    }
+    for (auto *trigger : std::as_const(m_triggers)) {
+        if (trigger->triggerId() == m_activeTriggerId) {
+            return trigger->followsTypedText();
+        }
+    }
+    return false;
+}
+
 bool OverlayController::overlayVisible() const
 {
     return m_overlayVisible;
@@ -322,12 +429,25 @@ InputPlugin *OverlayController::inputPlugin() const
     return m_inputPlugin;
 }
 
+const KeyHoldStatistics &OverlayController::keyHoldStatistics() const
+{
+    return m_keyHoldStatistics;
+}
+
 void OverlayController::commitCandidate(int index)
 {
     const QString text = m_candidateModel->insertTextAt(index);
     if (text.isEmpty()) {
         return;
     }
+
+    for (auto *trigger : std::as_const(m_triggers)) {
+        if (trigger->triggerId() == m_activeTriggerId) {
+            trigger->candidateCommitted(m_pendingText, text);
+            break;
+        }
+    }
+
     commitText(text);
 }
 
@@ -340,14 +460,17 @@ void OverlayController::commitText(const QString &text)
     qCDebug(PlasmaKeyboard) << "Committing overlay selection:" << text;
 
     if (m_inputPlugin) {
+        InputPlugin::Batch batch(m_inputPlugin);
         // The base character (m_pendingText) is still present in the text field —
         // it was committed on key-press and never retracted. Delete it now and
         // replace it with the selected candidate in one atomic operation:
         //   delete_surrounding_text is deferred by the compositor until the
         //   following commit_string, so sending both requests back-to-back
         //   guarantees they are applied together at the current cursor position.
-        if (!m_pendingText.isEmpty()) {
-            const int charCount = m_pendingText.length();
+        const int charCount = m_pendingText.length();
+        m_reconciler.expectEdit(m_inputPlugin->serial(), charCount, text);
+        m_textWindow.edit(charCount, text);
+        if (charCount > 0) {
             m_inputPlugin->deleteSurroundingText(-charCount, charCount);
         }
         m_inputPlugin->commit(text);
@@ -356,12 +479,10 @@ void OverlayController::commitText(const QString &text)
     setOverlayVisible(false);
 
     // Only swallow the next release if the key is still physically held
-    if (!m_pendingKeyReleased) {
-        m_ignoreReleaseNativeScanCode = m_pendingNativeScanCode;
-        m_swallowNextRelease = true;
-    }
+    const quint32 heldNativeScanCode = m_pendingKeyReleased ? 0 : m_pendingNativeScanCode;
 
-    resetState();
+    finishPendingKey();
+    swallowReleaseOf(heldNativeScanCode);
 }
 
 void OverlayController::cancelOverlay()
@@ -373,56 +494,74 @@ void OverlayController::cancelOverlay()
 
     setOverlayVisible(false);
 
-    if (!m_pendingText.isEmpty() && !m_pendingKeyReleased) {
-        m_ignoreReleaseNativeScanCode = m_pendingNativeScanCode;
-        m_swallowNextRelease = true;
-    }
+    const quint32 heldNativeScanCode = !m_pendingText.isEmpty() && !m_pendingKeyReleased ? m_pendingNativeScanCode : 0;
 
     // Reset all triggers
     for (auto *trigger : m_triggers) {
         trigger->reset();
     }
 
-    resetState();
+    finishPendingKey();
+    swallowReleaseOf(heldNativeScanCode);
 }
 
 void OverlayController::handleSurroundingTextChanged()
 {
-    // If we are expecting a surrounding-text update from one of our own
-    // commit/delete-surrounding-text operations, consume that credit and return.
-    if (m_pendingSurroundingTextUpdates > 0) {
-        qCDebug(PlasmaKeyboard) << "Ignoring self-caused surrounding-text update (" << m_pendingSurroundingTextUpdates << " remaining)";
-        --m_pendingSurroundingTextUpdates;
+    if (!m_inputPlugin) {
         return;
     }
 
-    // Counter exhausted — fall back to the settle timer.
-    //
-    // Some client apps (Firefox, Chromium, VS Code, …) send two or more
-    // surrounding_text events for a single commit_string. The credit counter
-    // above covers the first echo; the settle timer absorbs any remaining
-    // echoes without a cursor-position comparison (which is unreliable when
-    // the client reports a shifted surrounding-text window after insertion).
-    if (m_surroundingTextSettleTimer.isActive()) {
-        // qCDebug(PlasmaKeyboard) << "Ignoring extra surrounding-text echo (within settle window)";
+    // Echoes of our own edits, and repeated reports of a state we already
+    // know (some clients send several per commit), leave the overlay alone.
+    const QString text = m_inputPlugin->surroundingText();
+    const int cursor = m_inputPlugin->cursorCharPos();
+    const int anchor = m_inputPlugin->anchorCharPos();
+    const SurroundingTextReconciler::Result result = m_reconciler.reconcile(m_inputPlugin->serial(), text, cursor, anchor);
+    if (result != SurroundingTextReconciler::Result::External) {
+        // qCDebug(PlasmaKeyboard) << "Ignoring self-caused surrounding-text update" << int(result) << m_reconciler.pendingEdits() << "edits pending";
         return;
     }
 
+    const CursorTextWindow::Change change = m_textWindow.update(text, cursor, anchor);
+
     // An external event changed the cursor (e.g. user tapped elsewhere in the
-    // text field). Cancel any pending overlay state.
-    if (m_holdTimer.isActive() || m_overlayVisible) {
+    // text field). Cancel any pending overlay state, unless the text was just
+    // typed into a query the overlay follows.
+    const bool typedIntoQuery = change == CursorTextWindow::Change::Inserted && m_overlayVisible && activeTriggerFollowsTypedText();
+    if ((m_holdTimer.isActive() || m_overlayVisible) && !typedIntoQuery) {
         qCDebug(PlasmaKeyboard) << "External cursor move detected while overlay active; cancelling overlay";
         cancelOverlay();
     }
+
+    switch (change) {
+    case CursorTextWindow::Change::Inserted:
+        // Typed into the client, e.g. through keys forwarded to it.
+        dispatchTextCommitted();
+        break;
+    case CursorTextWindow::Change::Replaced:
+        // Whatever the triggers saw before the cursor is gone.
+        for (auto *trigger : std::as_const(m_triggers)) {
+            trigger->reset();
+        }
+        break;
+    case CursorTextWindow::Change::None:
+        break;
+    }
 }
 
 void OverlayController::openOverlay(const QString &triggerId, const QString &baseText, const QStringList &candidates)
 {
-    if (candidates.isEmpty()) {
+    m_candidateModel->setCandidates(candidates);
+    showOverlay(triggerId, baseText);
+}
+
+void OverlayController::showOverlay(const QString &triggerId, const QString &baseText)
+{
+    if (m_candidateModel->rowCount() == 0) {
         // No candidates: the base character was already committed on key-press
         // and is present in the text field, so no further commit is needed.
         // Simply reset state and leave the text as-is.
-        resetState();
+        finishPendingKey();
         return;
     }
 
@@ -430,7 +569,6 @@ void OverlayController::openOverlay(const QString &triggerId, const QString &bas
     m_pendingText = baseText;
 
     m_candidateModel->setTriggerId(triggerId);
-    m_candidateModel->setCandidates(candidates);
 
     setOverlayVisible(true);
 
@@ -455,6 +593,9 @@ void OverlayController::handleTimerExpired()
         return;
     }
 
+    // This hold was a deliberate long-press, not typing.
+    m_keyHoldStatistics.discard(m_pendingNativeScanCode);
+
     auto result = m_pendingTrigger->processEvent(OverlayInputEvent::TimerExpired, nullptr, m_pendingText, this);
 
     // If opening the overlay, the base character that was committed on key-press
@@ -471,8 +612,9 @@ void OverlayController::executeAction(const OverlayTriggerResult &result, Overla
 {
     switch (result.action) {
     case OverlayAction::OpenOverlay: {
-        const auto candidates = trigger->candidates(m_pendingText);
-        openOverlay(trigger->triggerId(), m_pendingText, candidates);
+        const QString baseText = result.pendingText.isEmpty() ? m_pendingText : result.pendingText;
+        trigger->populateCandidates(baseText, m_candidateModel);
+        showOverlay(trigger->triggerId(), baseText);
         break;
     }
     case OverlayAction::CloseOverlay:
@@ -489,16 +631,19 @@ void OverlayController::executeAction(const OverlayTriggerResult &result, Overla
         // For text expansion: delete chars before cursor, then commit.
         // Both operations are sent back-to-back; delete_surrounding_text is
         // deferred by the compositor until the following commit_string, so
-        // they are applied atomically. No counter increment is needed —
-        // resetState() is called immediately below before the compositor's
-        // surrounding_text echo can arrive, so the echo is harmless.
-        if (m_inputPlugin && result.deleteBeforeCursor > 0) {
-            m_inputPlugin->deleteSurroundingText(-result.deleteBeforeCursor, result.deleteBeforeCursor);
-        }
-        if (!result.commitText.isEmpty() && m_inputPlugin) {
-            m_inputPlugin->commit(result.commitText);
+        // they are applied atomically.
+        if (m_inputPlugin) {
+            m_reconciler.expectEdit(m_inputPlugin->serial(), result.deleteBeforeCursor, result.commitText);
+            m_textWindow.edit(result.deleteBeforeCursor, result.commitText);
+            InputPlugin::Batch batch(m_inputPlugin);
+            if (result.deleteBeforeCursor > 0) {
+                m_inputPlugin->deleteSurroundingText(-result.deleteBeforeCursor, result.deleteBeforeCursor);
+            }
+            if (!result.commitText.isEmpty()) {
+                m_inputPlugin->commit(result.commitText);
+            }
         }
-        resetState();
+        finishPendingKey();
         break;
     case OverlayAction::StartTimer:
         // Flush any previous pending state to prevent character drops during
@@ -508,8 +653,7 @@ void OverlayController::executeAction(const OverlayTriggerResult &result, Overla
             if (m_holdTimer.isActive()) {
                 m_holdTimer.stop();
             }
-            m_ignoreReleaseNativeScanCode = m_pendingNativeScanCode;
-            m_swallowNextRelease = true;
+            swallowReleaseOf(m_pendingNativeScanCode);
         }
 
         // Set new pending state and start the hold timer
@@ -527,15 +671,13 @@ void OverlayController::executeAction(const OverlayTriggerResult &result, Overla
         // The client will respond by inserting text and sending surrounding_text
         // back through the text-input protocol.
         //
-        // Increment the echo counter and start the settle timer to prevent this
-        // echo from being misidentified as an external cursor move (which would cancel the overlay).
+        // Record the expected result so that this echo is not misidentified as
+        // an external cursor move (which would cancel the overlay).
         if (m_inputPlugin && !m_pendingText.isEmpty()) {
             // qCDebug(PlasmaKeyboard) << "Forwarding key press for" << m_pendingText;
-            // The primary credit counter absorbs the first echo. The settle
-            // timer absorbs any additional echoes from clients that send
-            // multiple surrounding_text events per commit_string.
-            ++m_pendingSurroundingTextUpdates;
-            m_surroundingTextSettleTimer.start();
+            m_reconciler.expectEdit(m_inputPlugin->serial(), 0, m_pendingText);
+            m_textWindow.edit(0, m_pendingText);
+            InputPlugin::Batch batch(m_inputPlugin);
             m_inputPlugin->key(InputPlugin::Pressed, m_pendingNativeScanCode);
             // We need to simulate a key release to prevent the client from doing
             // auto-repeat on the key. We will swallow the next release event for this
@@ -583,11 +725,11 @@ void OverlayController::resetState()
     m_pendingText.clear();
     m_pendingNativeScanCode = 0;
     m_pendingKeyReleased = false;
+    m_swallowNextRelease = false;
+    m_ignoreReleaseNativeScanCode = 0;
     m_activeTriggerId.clear();
     m_pendingTrigger = nullptr;
     m_candidateModel->clear();
-    m_pendingSurroundingTextUpdates = 0;
-    m_surroundingTextSettleTimer.stop();
     if (m_xkbComposeState) {
         xkb_compose_state_reset(m_xkbComposeState);
     }
@@ -603,6 +745,26 @@ void OverlayController::resetState()
     }
 }
 
+void OverlayController::finishPendingKey()
+{
+    // A key flushed during rollover may still be held; its release was already
+    // sent to the client.
+    const quint32 swallowedNativeScanCode = m_swallowNextRelease ? m_ignoreReleaseNativeScanCode : 0;
+    resetState();
+    swallowReleaseOf(swallowedNativeScanCode);
+}
+
+void OverlayController::swallowReleaseOf(quint32 nativeScanCode)
+{
+    // Overlays opened without a held key (e.g. the emoji overlay) have no
+    // release to wait for; a swallow armed for them would never be cleared.
+    if (nativeScanCode == 0) {
+        return;
+    }
+    m_ignoreReleaseNativeScanCode = nativeScanCode;
+    m_swallowNextRelease = true;
+}
+
 void OverlayController::setOverlayVisible(bool visible)
 {
     if (m_overlayVisible == visible) {
@@ -7,15 +7,22 @@
 #pragma once
 
 #include "candidatemodel.h"
+#include "cursortextwindow.h"
+#include "keyholdstatistics.h"
+#include "keyrecord.h"
 #include "overlaytrigger.h"
+#include "surroundingtextreconciler.h"
+#include "xkbcache.h"
 
-#include <QKeyEvent>
 #include <QObject>
 #include <QTimer>
+#include <QVarLengthArray>
 #include <qqmlintegration.h>
 
 #include <xkbcommon/xkbcommon-compose.h>
 
+#include <array>
+
 class InputPlugin;
 
 /**
@@ -71,36 +78,43 @@ public:
     void registerTrigger(OverlayTrigger *trigger);
 
     /**
-     * Process a key press event.
+     * Process a key press.
+     *
+     * Keys no overlay or trigger acts on are processed without heap allocations.
      *
-     * @param event The key event.
-     * @return True if the event was consumed.
+     * @param key The pressed key.
+     * @return True if the key was consumed.
      */
-    bool processKeyPress(QKeyEvent *event);
+    bool processKeyPress(const KeyRecord &key);
 
     /**
-     * Process a key release event.
+     * Process a key release.
      *
-     * @param event The key event.
-     * @return True if the event was consumed.
+     * @param key The released key.
+     * @return True if the key was consumed.
      */
-    bool processKeyRelease(QKeyEvent *event);
+    bool processKeyRelease(const KeyRecord &key);
 
     /**
      * Process a preedit text change.
      *
+     * Triggers see the preedit after the text before the cursor.
+     *
      * @param preedit The new preedit text.
      * @return True if an overlay action was triggered.
      */
     bool processPreeditChanged(const QString &preedit);
 
     /**
-     * Process committed text.
+     * Process text committed at the cursor by the virtual keyboard.
+     *
+     * Triggers see the text before the cursor, ending with the commit.
      *
      * @param text The committed text.
+     * @param deleteBeforeCursor Number of UTF-16 code units deleted before the cursor first.
      * @return True if an overlay action was triggered.
      */
-    bool processTextCommitted(const QString &text);
+    bool processTextCommitted(const QString &text, int deleteBeforeCursor = 0);
 
     bool overlayVisible() const;
     QString activeTriggerId() const;
@@ -117,6 +131,26 @@ public:
      */
     InputPlugin *inputPlugin() const;
 
+    /**
+     * How long keys are held during ordinary typing.
+     */
+    const KeyHoldStatistics &keyHoldStatistics() const;
+
+    /**
+     * Whether the physical keyboard needs to be grabbed: while any trigger is
+     * enabled, since even triggers that only look at text open overlays that
+     * are closed, picked from and navigated with keys, and while an overlay
+     * is visible.
+     */
+    bool needsKeyboardGrab() const;
+
+    /**
+     * Whether key events that type no text could currently be consumed or
+     * change any state, e.g. because an overlay, a hold timer or a compose
+     * sequence is active, or a trigger wants them.
+     */
+    bool wantsTextlessKeys() const;
+
 public Q_SLOTS:
     /**
      * Commit the candidate at the given index.
@@ -150,6 +184,9 @@ public Q_SLOTS:
      * text field). If an external cursor movement is detected while an overlay or hold
      * timer is active, the overlay/timer is cancelled since it is no longer relevant to
      * the new cursor position.
+     *
+     * Text typed at the cursor by the client, e.g. for keys forwarded to it, is
+     * dispatched to the triggers like committed text.
      */
     void handleSurroundingTextChanged();
 
@@ -173,6 +210,7 @@ Q_SIGNALS:
 
     void overlayVisibleChanged();
     void activeTriggerIdChanged();
+    void needsKeyboardGrabChanged();
     void pendingTextChanged();
 
     /**
@@ -188,11 +226,30 @@ private Q_SLOTS:
 
 private:
     void executeAction(const OverlayTriggerResult &result, OverlayTrigger *trigger);
+    bool dispatchTextCommitted();
+    bool activeTriggerFollowsTypedText() const;
+    void updateComposeTable();
+    void rebuildDispatchTables();
+    void showOverlay(const QString &triggerId, const QString &baseText);
     void resetState();
+    /** resetState() once a key was handled, still swallowing the release of an earlier key. */
+    void finishPendingKey();
+    /** Consume the next release of @p nativeScanCode, if it is a physical key. */
+    void swallowReleaseOf(quint32 nativeScanCode);
     void setOverlayVisible(bool visible);
 
     InputPlugin *m_inputPlugin = nullptr;
     QList<OverlayTrigger *> m_triggers;
+
+    /**
+     * Enabled triggers subscribed to each OverlayInputEvent, in registration
+     * order. Rebuilt when a trigger's subscriptions or the content purpose
+     * change, so that dispatching an event nobody wants costs nothing.
+     */
+    std::array<QVarLengthArray<OverlayTrigger *, 4>, kOverlayInputEventCount> m_subscribers;
+
+    /** Overlays are disabled for the current content purpose. */
+    bool m_overlaysSuppressed = false;
     CandidateModel *m_candidateModel = nullptr;
 
     QTimer m_holdTimer;
@@ -221,59 +278,50 @@ private:
     quint32 m_repeatNativeScanCode = 0;
 
     /**
-     * Number of compositor surrounding-text echo events the controller is still
-     * waiting to receive as a consequence of its own commit_string operations.
-     *
-     * Only commit_string causes the compositor to send a surrounding_text
-     * event back to the input method. delete_surrounding_text does not.
+     * Classifies surrounding-text updates as echoes of our own edits or
+     * external changes.
      *
-     * While this counter is non-zero the next incoming surrounding_text event
-     * is treated as self-caused and the counter is decremented rather than
-     * cancelling the active overlay.
-     *
-     * When the counter reaches zero, m_surroundingTextSettleTimer is used as
-     * a fallback: any surrounding_text event that arrives while the timer is
-     * still running is also treated as a self-caused echo. This handles clients
-     * that send more than one update per commit_string (e.g. Firefox, Chromium,
-     * VS Code), where a cursor-position comparison is unreliable because those
-     * clients report a shifted surrounding-text window after text insertion.
+     * Every key press, commit_string and delete_surrounding_text sent by the
+     * controller is registered with the text it should produce around the
+     * cursor. Echoes, including the repeated reports some clients (Firefox,
+     * Chromium, VS Code, …) send per commit, are recognised by that content
+     * regardless of how late they arrive; anything else is treated as an
+     * external cursor move.
      */
-    int m_pendingSurroundingTextUpdates = 0;
+    SurroundingTextReconciler m_reconciler;
 
     /**
-     * Single-shot timer that suppresses spurious surrounding_text echoes after
-     * a commit_string.
-     *
-     * Some clients (Firefox, Chromium, VS Code, …) send two or more
-     * surrounding_text events in response to a single commit_string. Once the
-     * primary credit counter (m_pendingSurroundingTextUpdates) is exhausted,
-     * events arriving while this timer is still active are treated as
-     * self-caused echoes rather than external cursor moves.
-     *
-     * The interval (see SURROUNDING_TEXT_SETTLE_DELAY_MS) is chosen to be:
-     *   - long enough for all compositor echoes to arrive (Wayland roundtrips
-     *     on a local session are typically < 5 ms)
-     *   - short enough not to mask genuine user interactions (well under
-     *     the long-press threshold)
+     * The text before the cursor that TextCommitted and PreeditChanged
+     * triggers see: updated by every edit sent to the client, and by text
+     * typed at the cursor as reported through surrounding text.
      */
-    QTimer m_surroundingTextSettleTimer;
+    CursorTextWindow m_textWindow;
+
+    /** The preedit last dispatched to PreeditChanged triggers. */
+    QString m_preedit;
+
+    /** Hold durations of physical keys, for the adaptive long-press threshold. */
+    KeyHoldStatistics m_keyHoldStatistics;
 
     /**
-     * XKB compose state machine for handling client-side compose sequences (e.g.
-     * Multi_key + t + m → ™). The controller processes compose sequences locally so that
-     * the intermediate keys (e.g. Multi_key, t) can be consumed and not forwarded to the
-     * client, while only the final composed result (e.g. ™) is sent via commit_string.
+     * Locale the compose table was requested for.
      */
-    xkb_context *m_xkbContext = nullptr;
+    QByteArray m_composeLocale;
 
     /**
-     * XKB compose table compiled from the system locale, used to initialize the compose state.
+     * XKB compose table for m_composeLocale, shared through XkbCache and used to
+     * initialize the compose state.
      */
-    xkb_compose_table *m_xkbComposeTable = nullptr;
+    ComposeTablePtr m_xkbComposeTable;
 
     /**
-     * XKB compose state initialized from the compose table, used to track the current
-     * compose sequence and produce the final composed result.
+     * XKB compose state machine for handling client-side compose sequences (e.g.
+     * Multi_key + t + m → ™). The controller processes compose sequences locally so that
+     * the intermediate keys (e.g. Multi_key, t) can be consumed and not forwarded to the
+     * client, while only the final composed result (e.g. ™) is sent via commit_string.
+     *
+     * Initialized from the compose table, it tracks the current compose sequence and
+     * produces the final composed result.
      */
     xkb_compose_state *m_xkbComposeState = nullptr;
 };
@@ -6,9 +6,43 @@
 
 #include "overlaytrigger.h"
 
+#include "candidatemodel.h"
+
 OverlayTrigger::OverlayTrigger(QObject *parent)
     : QObject(parent)
 {
 }
 
+QList<OverlayInputEvent> OverlayTrigger::subscribedEvents() const
+{
+    return {
+        OverlayInputEvent::KeyPress,
+        OverlayInputEvent::KeyRelease,
+        OverlayInputEvent::PreeditChanged,
+        OverlayInputEvent::TextCommitted,
+        OverlayInputEvent::TimerExpired,
+    };
+}
+
+bool OverlayTrigger::wantsTextlessKeys() const
+{
+    return false;
+}
+
+bool OverlayTrigger::followsTypedText() const
+{
+    return false;
+}
+
+void OverlayTrigger::populateCandidates(const QString &baseText, CandidateModel *model) const
+{
+    model->setCandidates(candidates(baseText));
+}
+
+void OverlayTrigger::candidateCommitted(const QString &baseText, const QString &candidate)
+{
+    Q_UNUSED(baseText)
+    Q_UNUSED(candidate)
+}
+
 #include "moc_overlaytrigger.cpp"
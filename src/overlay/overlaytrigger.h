@@ -6,11 +6,14 @@
 
 #pragma once
 
-#include <QKeyEvent>
+#include "keyrecord.h"
+
+#include <QList>
 #include <QObject>
 #include <QString>
 #include <QStringList>
 
+class CandidateModel;
 class OverlayController;
 
 /**
@@ -31,6 +34,9 @@ enum class OverlayInputEvent {
     TimerExpired,
 };
 
+/** Number of OverlayInputEvent values. */
+constexpr int kOverlayInputEventCount = int(OverlayInputEvent::TimerExpired) + 1;
+
 /**
  * Actions a trigger can request from the controller.
  */
@@ -74,7 +80,11 @@ struct OverlayTriggerResult {
     /** For StartTimer: the native scan code of the physical key (for release matching). */
     quint32 pendingNativeScanCode = 0;
 
-    /** For StartTimer: the pending text to be committed or shown in overlay. */
+    /**
+     * For StartTimer: the pending text to be committed or shown in overlay.
+     * For OpenOverlay: the text before the cursor that a picked candidate
+     * replaces, if not the pending text.
+     */
     QString pendingText;
 };
 
@@ -112,13 +122,17 @@ public:
      * Process an input event and return the resulting action.
      *
      * @param eventType The type of input event.
-     * @param keyEvent The key event (may be null for non-key events).
-     * @param text Associated text (preedit, committed, or pending).
+     * @param key The key (null for non-key events).
+     * @param text Associated text; empty for key events, whose text is in
+     *             @p key. For TextCommitted the text before the cursor,
+     *             for PreeditChanged followed by the preedit, cut to a
+     *             window of a few dozen characters; for TimerExpired the
+     *             pending text.
      * @param controller The controller, for querying state.
      * @return The action to take.
      */
     virtual OverlayTriggerResult processEvent(OverlayInputEvent eventType,
-                                                    const QKeyEvent *keyEvent,
+                                                    const KeyRecord *key,
                                                     const QString &text,
                                                     OverlayController *controller) = 0;
     // clang-format on
@@ -132,9 +146,38 @@ public:
 
     /**
      * Whether this trigger is currently enabled.
+     *
+     * Triggers emit subscriptionsChanged() when this changes.
      */
     virtual bool isEnabled() const = 0;
 
+    /**
+     * The input events processEvent() does something with.
+     *
+     * The controller only dispatches these events to the trigger. The default
+     * implementation subscribes to all of them.
+     */
+    virtual QList<OverlayInputEvent> subscribedEvents() const;
+
+    /**
+     * Whether processEvent() currently needs to see key events that type no
+     * text, such as arrow keys.
+     *
+     * While no trigger does and no overlay is active, such keys may reach the
+     * client without being dispatched at all. The default is false.
+     */
+    virtual bool wantsTextlessKeys() const;
+
+    /**
+     * Whether the overlay this trigger opened follows the text typed at the
+     * cursor, e.g. a search query.
+     *
+     * While it does, typing into the client keeps the overlay open; the
+     * trigger updates or closes it from the TextCommitted and PreeditChanged
+     * events that follow. The default is false, so any typed key closes it.
+     */
+    virtual bool followsTypedText() const;
+
     /**
      * Candidate options for the current trigger state.
      *
@@ -142,4 +185,34 @@ public:
      * @return List of candidate strings to display.
      */
     virtual QStringList candidates(const QString &baseText) const = 0;
+
+    /**
+     * Fill @p model with the candidates for @p baseText.
+     *
+     * The default implementation copies candidates() into the model. Triggers
+     * backed by a shared table override this to let the model reference the
+     * table directly instead.
+     *
+     * @param baseText The base text that triggered the overlay.
+     * @param model The model to populate; left empty if there are no candidates.
+     */
+    virtual void populateCandidates(const QString &baseText, CandidateModel *model) const;
+
+    /**
+     * Called when the user picked @p candidate from this trigger's overlay.
+     *
+     * The default implementation does nothing; triggers can use it to learn
+     * which candidates to offer first.
+     *
+     * @param baseText The base text the overlay was opened for.
+     * @param candidate The text that was committed.
+     */
+    virtual void candidateCommitted(const QString &baseText, const QString &candidate);
+
+Q_SIGNALS:
+    /**
+     * Emitted when isEnabled() or subscribedEvents() changed, so that the
+     * controller updates which events it dispatches to this trigger.
+     */
+    void subscriptionsChanged();
 };
@@ -6,13 +6,27 @@
 
 #include "prefixquerytrigger.h"
 
+#include "emojidataloader.h"
 #include "logging.h"
+#include "plasmakeyboardsettings.h"
 
 #include <KLocalizedString>
 
+/// Maximum number of emoji offered for one query.
+static constexpr qsizetype kMaxResults = 32;
+
 PrefixQueryTrigger::PrefixQueryTrigger(QObject *parent)
     : OverlayTrigger(parent)
 {
+    connect(PlasmaKeyboardSettings::self(), &PlasmaKeyboardSettings::emojiPopupEnabledChanged, this, &OverlayTrigger::subscriptionsChanged);
+
+    // Localized keywords depend on the enabled locales; reload on next use.
+    connect(PlasmaKeyboardSettings::self(), &PlasmaKeyboardSettings::enabledLocalesChanged, this, [this]() {
+        m_emoji = EmojiIndex();
+        // Ranges of the old index are meaningless; rescan on the next event.
+        clearQuery();
+        m_lastText.clear();
+    });
 }
 
 QString PrefixQueryTrigger::triggerId() const
@@ -27,12 +41,12 @@ QString PrefixQueryTrigger::displayName() const
 
 // clang-format off
 OverlayTriggerResult PrefixQueryTrigger::processEvent(OverlayInputEvent eventType,
-                                                            const QKeyEvent *keyEvent,
+                                                            const KeyRecord *key,
                                                             const QString &text,
                                                             OverlayController *controller)
 // clang-format on
 {
-    Q_UNUSED(keyEvent)
+    Q_UNUSED(key)
     Q_UNUSED(controller)
 
     OverlayTriggerResult result;
@@ -41,17 +55,17 @@ OverlayTriggerResult PrefixQueryTrigger::processEvent(OverlayInputEvent eventTyp
     case OverlayInputEvent::PreeditChanged:
     case OverlayInputEvent::TextCommitted: {
         // Look for prefix pattern in text
-        const QString query = extractQuery(text);
-        if (!query.isEmpty() && query.length() >= m_minQueryLength) {
-            m_currentQuery = query;
+        updateQuery(text);
+        if (!m_currentQuery.isEmpty() && m_currentQuery.length() >= m_minQueryLength) {
             m_active = true;
             result.action = OverlayAction::OpenOverlay;
-            result.query = query;
-            // qCDebug(PlasmaKeyboard) << "PrefixQueryTrigger: Detected query" << query;
-        } else if (m_active && query.isEmpty()) {
+            result.query = m_currentQuery;
+            // A picked emoji replaces the prefix and the query.
+            result.pendingText = m_prefix + m_currentQuery;
+            // qCDebug(PlasmaKeyboard) << "PrefixQueryTrigger: Detected query" << m_currentQuery;
+        } else if (m_active && m_currentQuery.isEmpty()) {
             // Prefix was removed, close overlay
             m_active = false;
-            m_currentQuery.clear();
             result.action = OverlayAction::CloseOverlay;
         }
         break;
@@ -70,27 +84,43 @@ OverlayTriggerResult PrefixQueryTrigger::processEvent(OverlayInputEvent eventTyp
 void PrefixQueryTrigger::reset()
 {
     m_active = false;
-    m_currentQuery.clear();
+    clearQuery();
+    m_lastText.clear();
 }
 
 bool PrefixQueryTrigger::isEnabled() const
 {
-    // TODO: Add setting for emoji popup
-    // return PlasmaKeyboardSettings::self()->emojiPopupEnabled();
-    return false; // Disabled until emoji data is implemented
+    return PlasmaKeyboardSettings::self()->emojiPopupEnabled();
+}
+
+QList<OverlayInputEvent> PrefixQueryTrigger::subscribedEvents() const
+{
+    return {OverlayInputEvent::PreeditChanged, OverlayInputEvent::TextCommitted};
+}
+
+bool PrefixQueryTrigger::followsTypedText() const
+{
+    return m_active && m_inQuery;
 }
 
 QStringList PrefixQueryTrigger::candidates(const QString &baseText) const
 {
     Q_UNUSED(baseText)
-    // TODO: Implement emoji search
-    // This will query an emoji database filtered by m_currentQuery
-    return {};
+
+    const QList<EmojiIndex::Match> matches = m_emoji.rank(m_queryRange, m_foldedQuery.size(), kMaxResults);
+    QStringList result;
+    result.reserve(matches.size());
+    for (const EmojiIndex::Match &match : matches) {
+        result.append(match.emoji.toString());
+    }
+    return result;
 }
 
 void PrefixQueryTrigger::setPrefix(QChar prefix)
 {
     m_prefix = prefix;
+    clearQuery();
+    m_lastText.clear();
 }
 
 QChar PrefixQueryTrigger::prefix() const
@@ -108,30 +138,64 @@ int PrefixQueryTrigger::minQueryLength() const
     return m_minQueryLength;
 }
 
-QString PrefixQueryTrigger::extractQuery(const QString &text) const
+void PrefixQueryTrigger::updateQuery(const QString &text)
 {
-    // Find the last occurrence of the prefix
-    const int prefixPos = text.lastIndexOf(m_prefix);
-    if (prefixPos < 0) {
-        return {};
-    }
-
-    // Extract everything after the prefix until space or end
-    const int queryStart = prefixPos + 1;
-    if (queryStart >= text.length()) {
-        return {};
+    const QStringView view(text);
+    if (!m_lastText.isEmpty() && view.size() > m_lastText.size() && view.startsWith(m_lastText)) {
+        // Typing usually only appends; everything before is already accounted for.
+        scanAppended(view.sliced(m_lastText.size()));
+    } else if (text != m_lastText) {
+        clearQuery();
+        scanAppended(view);
     }
+    m_lastText = text;
+}
 
-    QString query;
-    for (int i = queryStart; i < text.length(); ++i) {
-        const QChar c = text.at(i);
+void PrefixQueryTrigger::scanAppended(QStringView appended)
+{
+    // Only what follows the last prefix or whitespace can belong to the query.
+    for (qsizetype i = appended.size(); i > 0; --i) {
+        const QChar c = appended.at(i - 1);
+        if (c == m_prefix) {
+            startQuery(appended.sliced(i));
+            return;
+        }
         if (c.isSpace()) {
-            break;
+            clearQuery();
+            return;
         }
-        query += c;
     }
 
-    return query;
+    if (m_inQuery) {
+        extendQuery(appended);
+    }
+}
+
+void PrefixQueryTrigger::startQuery(QStringView query)
+{
+    if (!m_emoji.isValid()) {
+        m_emoji = EmojiDataLoader::loadIndex(PlasmaKeyboardSettings::self()->enabledLocales());
+    }
+
+    m_inQuery = true;
+    m_currentQuery = query.toString();
+    m_foldedQuery = m_currentQuery.toLower();
+    m_queryRange = m_emoji.narrow(m_emoji.fullRange(), m_foldedQuery);
+}
+
+void PrefixQueryTrigger::extendQuery(QStringView appended)
+{
+    m_currentQuery.append(appended);
+    m_foldedQuery.append(appended.toString().toLower());
+    m_queryRange = m_emoji.narrow(m_queryRange, m_foldedQuery);
+}
+
+void PrefixQueryTrigger::clearQuery()
+{
+    m_inQuery = false;
+    m_currentQuery.clear();
+    m_foldedQuery.clear();
+    m_queryRange = {};
 }
 
 #include "moc_prefixquerytrigger.cpp"
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "emojiindex.h"
 #include "overlaytrigger.h"
 
 /**
@@ -14,7 +15,8 @@
  * Detects patterns like ":whale" or ":smile" in committed/preedit text
  * and opens an emoji picker filtered by the query after the colon.
  *
- * This is a stub implementation; full emoji search will be added later.
+ * Candidates come from an EmojiIndex, which is memory-mapped the first time a
+ * query is detected.
  */
 class PrefixQueryTrigger : public OverlayTrigger
 {
@@ -29,13 +31,15 @@ public:
 
     // clang-format off
     OverlayTriggerResult processEvent(OverlayInputEvent eventType,
-                                            const QKeyEvent *keyEvent,
+                                            const KeyRecord *key,
                                             const QString &text,
                                             OverlayController *controller) override;
     // clang-format on
 
     void reset() override;
     bool isEnabled() const override;
+    QList<OverlayInputEvent> subscribedEvents() const override;
+    bool followsTypedText() const override;
     QStringList candidates(const QString &baseText) const override;
 
     /**
@@ -52,12 +56,42 @@ public:
 
 private:
     /**
-     * Extract query from text (characters after the prefix).
+     * Bring the query up to date with @p text.
+     *
+     * When @p text extends the text of the previous event, only the appended
+     * characters are scanned and the keyword range of the current query is
+     * narrowed. Any other change rescans @p text from the start.
      */
-    QString extractQuery(const QString &text) const;
+    void updateQuery(const QString &text);
+
+    /**
+     * Apply characters typed after the previously seen text.
+     */
+    void scanAppended(QStringView appended);
+
+    void startQuery(QStringView query);
+    void extendQuery(QStringView appended);
+    void clearQuery();
+
+    /** Emoji search index; invalid until the first query needs it. */
+    EmojiIndex m_emoji;
 
     QChar m_prefix = u':';
     int m_minQueryLength = 2;
-    QString m_currentQuery;
     bool m_active = false;
+
+    /** Text of the previous event, to detect appended characters. */
+    QString m_lastText;
+
+    /** Whether the text currently ends in a prefix followed by a (possibly empty) query. */
+    bool m_inQuery = false;
+
+    /** The query as typed, after the prefix. */
+    QString m_currentQuery;
+
+    /** m_currentQuery lower-cased, as matched against the index. */
+    QString m_foldedQuery;
+
+    /** Index keywords matching m_foldedQuery. */
+    EmojiIndex::Range m_queryRange;
 };
@@ -0,0 +1,147 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "surroundingtextreconciler.h"
+
+#include <algorithm>
+
+/// UTF-16 code units kept on either side of the cursor for comparisons.
+static constexpr qsizetype kContextLength = 32;
+
+/// Windows of different lengths only match if they overlap by at least this
+/// much; shorter overlaps say too little about where the cursor is.
+static constexpr qsizetype kMinOverlap = 8;
+
+/// An edit whose echo has not arrived after this many commit_state serials is
+/// assumed to never be echoed.
+static constexpr quint32 kMaxSerialAge = 8;
+
+/// Upper bound on outstanding edits, for clients that never echo at all.
+static constexpr qsizetype kMaxPendingEdits = 16;
+
+/// Whether two context windows show the same text. Windows of different
+/// lengths are compared over their overlap: @p alignEnd for text before the
+/// cursor, which is cut at its start, otherwise for text after it.
+static bool windowsMatch(const QString &a, const QString &b, bool alignEnd)
+{
+    if (a.size() == b.size()) {
+        return a == b;
+    }
+    const QString &shorter = a.size() < b.size() ? a : b;
+    const QString &longer = a.size() < b.size() ? b : a;
+    if (shorter.size() < kMinOverlap) {
+        return false;
+    }
+    return alignEnd ? longer.endsWith(shorter) : longer.startsWith(shorter);
+}
+
+void SurroundingTextReconciler::expectEdit(quint32 serial, qsizetype deleteBeforeCursor, const QString &insert)
+{
+    Expectation expectation;
+    expectation.serial = serial;
+
+    // Edits sent before the previous one was echoed apply on top of it.
+    if (!m_pending.isEmpty()) {
+        expectation.baseKnown = m_pending.constLast().baseKnown;
+        expectation.base = m_pending.constLast().expected;
+    } else {
+        expectation.baseKnown = m_hasKnown;
+        expectation.base = m_known;
+    }
+    if (!expectation.baseKnown && insert.isEmpty()) {
+        // Nothing to recognise the echo by.
+        return;
+    }
+
+    QString before = expectation.base.before;
+    before.chop(std::min(deleteBeforeCursor, before.size()));
+    before += insert;
+    expectation.expected.before = before.right(kContextLength);
+    expectation.expected.after = expectation.base.after;
+
+    if (m_pending.size() >= kMaxPendingEdits) {
+        m_pending.removeFirst();
+    }
+    m_pending.append(expectation);
+}
+
+SurroundingTextReconciler::Result SurroundingTextReconciler::reconcile(quint32 serial, const QString &text, qsizetype cursor, qsizetype anchor)
+{
+    expire(serial);
+    const State state = stateAround(text, cursor, anchor);
+
+    // The newest matching edit settles all edits sent before it.
+    for (qsizetype i = m_pending.size() - 1; i >= 0; --i) {
+        if (matchesExpected(m_pending.at(i), state)) {
+            m_pending.remove(0, i + 1);
+            m_known = state;
+            m_hasKnown = true;
+            return Result::Echo;
+        }
+    }
+
+    if (m_hasKnown && matches(m_known, state)) {
+        return Result::Stale;
+    }
+    for (const Expectation &expectation : std::as_const(m_pending)) {
+        if (expectation.baseKnown && matches(expectation.base, state)) {
+            return Result::Stale;
+        }
+    }
+
+    // The text changed in a way we did not cause; outstanding edits can no
+    // longer be recognised against it.
+    m_pending.clear();
+    m_known = state;
+    m_hasKnown = true;
+    return Result::External;
+}
+
+void SurroundingTextReconciler::reset()
+{
+    m_known = {};
+    m_hasKnown = false;
+    m_pending.clear();
+}
+
+qsizetype SurroundingTextReconciler::pendingEdits() const
+{
+    return m_pending.size();
+}
+
+SurroundingTextReconciler::State SurroundingTextReconciler::stateAround(const QString &text, qsizetype cursor, qsizetype anchor)
+{
+    cursor = std::clamp<qsizetype>(cursor, 0, text.size());
+    anchor = std::clamp<qsizetype>(anchor, 0, text.size());
+    const qsizetype start = std::min(cursor, anchor);
+    const qsizetype end = std::max(cursor, anchor);
+
+    // A selection is replaced by the next insertion, so it belongs to neither side.
+    const qsizetype beforeLength = std::min(start, kContextLength);
+    return State{text.mid(start - beforeLength, beforeLength), text.mid(end, kContextLength)};
+}
+
+bool SurroundingTextReconciler::matches(const State &a, const State &b)
+{
+    return windowsMatch(a.before, b.before, true) && windowsMatch(a.after, b.after, false);
+}
+
+bool SurroundingTextReconciler::matchesExpected(const Expectation &expectation, const State &state)
+{
+    if (!expectation.baseKnown) {
+        // Only the inserted text is known; it must end right at the cursor.
+        return state.before.endsWith(expectation.expected.before);
+    }
+    return matches(expectation.expected, state);
+}
+
+void SurroundingTextReconciler::expire(quint32 serial)
+{
+    // Serials may wrap around; the unsigned difference is the age either way.
+    while (!m_pending.isEmpty() && quint32(serial - m_pending.constFirst().serial) > kMaxSerialAge) {
+        m_pending.removeFirst();
+    }
+}
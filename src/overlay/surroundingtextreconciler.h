@@ -0,0 +1,98 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QList>
+#include <QString>
+
+/**
+ * Tells the client's echoes of our own edits apart from external changes.
+ *
+ * Every edit the overlay controller sends (a forwarded key, a commit_string,
+ * a delete_surrounding_text + commit_string pair) is recorded with the
+ * text expected around the cursor once the client has applied it, and the
+ * commit_state serial it was sent with. Incoming surrounding text is then
+ * classified by content rather than by timing:
+ *
+ * - Echo: matches the expected state of an outstanding edit. That edit and
+ *   all older ones are settled.
+ * - Stale: repeats the last known state or the state an outstanding edit was
+ *   based on. Clients such as Firefox, Chromium or VS Code send such reports
+ *   around a commit; they carry no new information.
+ * - External: anything else, e.g. the user moved the cursor.
+ *
+ * Only a short window of text on either side of the cursor is compared, and
+ * windows of different lengths are compared over their overlap, so clients
+ * reporting a shifted surrounding-text window after an insertion still
+ * match. Edits the client never echoes expire after a few commit_state
+ * serials instead of after a fixed delay.
+ */
+class SurroundingTextReconciler
+{
+public:
+    enum class Result {
+        Echo,
+        Stale,
+        External,
+    };
+
+    /**
+     * Record an edit that is about to be sent to the client.
+     *
+     * @param serial             The commit_state serial the edit is sent with.
+     * @param deleteBeforeCursor Number of UTF-16 code units deleted before the cursor.
+     * @param insert             Text inserted at the cursor.
+     */
+    void expectEdit(quint32 serial, qsizetype deleteBeforeCursor, const QString &insert);
+
+    /**
+     * Classify a surrounding-text update and update the known state.
+     *
+     * @param serial The latest commit_state serial.
+     * @param text   The surrounding text.
+     * @param cursor Cursor position in UTF-16 code units.
+     * @param anchor Anchor position in UTF-16 code units.
+     */
+    Result reconcile(quint32 serial, const QString &text, qsizetype cursor, qsizetype anchor);
+
+    /**
+     * Forget all state, e.g. when the input context changes.
+     */
+    void reset();
+
+    /**
+     * Number of edits still waiting for their echo.
+     */
+    qsizetype pendingEdits() const;
+
+private:
+    /** Text on either side of the cursor (or selection), cut to the context window. */
+    struct State {
+        QString before;
+        QString after;
+    };
+
+    struct Expectation {
+        quint32 serial;
+        /** Whether the state the edit applies to is known; if not, only the inserted text is compared. */
+        bool baseKnown;
+        State base;
+        State expected;
+    };
+
+    static State stateAround(const QString &text, qsizetype cursor, qsizetype anchor);
+    static bool matches(const State &a, const State &b);
+    static bool matchesExpected(const Expectation &expectation, const State &state);
+
+    void expire(quint32 serial);
+
+    State m_known;
+    bool m_hasKnown = false;
+
+    /** Outstanding edits, oldest first. */
+    QList<Expectation> m_pending;
+};
@@ -0,0 +1,435 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "textexpansionstore.h"
+
+#include "logging.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFuture>
+#include <QHash>
+#include <QPromise>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include <sys/file.h>
+#include <sys/stat.h>
+
+using namespace Qt::StringLiterals;
+
+/// Location of the store beneath GenericDataLocation.
+static const QString kStoreSubPath = u"plasma/keyboard/textexpansions"_s;
+
+/// Maximum number of records handed out per event loop iteration.
+static constexpr qsizetype kDeliveryBatchSize = 1000;
+
+/// A store is only compacted once it holds this many records or bytes...
+static constexpr qsizetype kCompactMinRecords = 4096;
+static constexpr qint64 kCompactMinBytes = 1024 * 1024;
+
+/// ...and at least this share of them (1/n) is superseded by later records.
+static constexpr qsizetype kCompactSupersededDivisor = 4;
+
+static QString unescape(QByteArrayView field)
+{
+    const QString text = QString::fromUtf8(field);
+    if (!text.contains(u'\\')) {
+        return text;
+    }
+
+    QString result;
+    result.reserve(text.size());
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const QChar c = text.at(i);
+        if (c != u'\\' || i + 1 == text.size()) {
+            result.append(c);
+            continue;
+        }
+        const QChar escaped = text.at(++i);
+        if (escaped == u't') {
+            result.append(u'\t');
+        } else if (escaped == u'n') {
+            result.append(u'\n');
+        } else {
+            result.append(escaped);
+        }
+    }
+    return result;
+}
+
+static QByteArray escape(const QString &text)
+{
+    QString result = text;
+    result.replace(u"\\"_s, u"\\\\"_s);
+    result.replace(u"\t"_s, u"\\t"_s);
+    result.replace(u"\n"_s, u"\\n"_s);
+    return result.toUtf8();
+}
+
+static QByteArray addRecord(const QString &abbreviation, const QString &expansion)
+{
+    return '+' + escape(abbreviation) + '\t' + escape(expansion) + '\n';
+}
+
+/// The snippets left after applying @p changes in order, each as the record
+/// that last added it, in file order.
+static QList<TextExpansionStore::Change> liveChanges(const QList<TextExpansionStore::Change> &changes)
+{
+    QHash<QString, qsizetype> lastAdded;
+    lastAdded.reserve(changes.size());
+    for (qsizetype i = 0; i < changes.size(); ++i) {
+        if (changes.at(i).removed) {
+            lastAdded.remove(changes.at(i).abbreviation);
+        } else {
+            lastAdded.insert(changes.at(i).abbreviation, i);
+        }
+    }
+
+    QList<qsizetype> indexes(lastAdded.cbegin(), lastAdded.cend());
+    std::sort(indexes.begin(), indexes.end());
+
+    QList<TextExpansionStore::Change> result;
+    result.reserve(indexes.size());
+    for (qsizetype index : std::as_const(indexes)) {
+        result.append(changes.at(index));
+    }
+    return result;
+}
+
+/// Whether compacting @p changes, read from @p size bytes, saves enough to rewrite the store.
+static bool isWorthCompacting(const QList<TextExpansionStore::Change> &changes, qint64 size)
+{
+    if (changes.size() < kCompactMinRecords && size < kCompactMinBytes) {
+        return false;
+    }
+    const qsizetype superseded = changes.size() - liveChanges(changes).size();
+    return superseded > 0 && superseded >= changes.size() / kCompactSupersededDivisor;
+}
+
+namespace
+{
+
+/// Advisory lock serializing the writers of a store. It is held on a separate
+/// file so that it stays valid while the store itself is replaced.
+class StoreLock
+{
+public:
+    explicit StoreLock(const QString &filePath)
+        : m_file(filePath + u".lock"_s)
+    {
+        m_locked = m_file.open(QIODevice::ReadWrite) && flock(m_file.handle(), LOCK_EX) == 0;
+    }
+
+    ~StoreLock()
+    {
+        if (m_locked) {
+            flock(m_file.handle(), LOCK_UN);
+        }
+    }
+
+    bool isLocked() const
+    {
+        return m_locked;
+    }
+
+private:
+    QFile m_file;
+    bool m_locked = false;
+};
+
+} // namespace
+
+TextExpansionStore::TextExpansionStore(const QString &filePath, QObject *parent)
+    : QObject(parent)
+    , m_filePath(filePath)
+{
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &TextExpansionStore::handleFileChanged);
+    connect(&m_watcher, &QFileSystemWatcher::directoryChanged, this, &TextExpansionStore::handleDirectoryChanged);
+}
+
+QString TextExpansionStore::defaultFilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + u'/' + kStoreSubPath;
+}
+
+QString TextExpansionStore::filePath() const
+{
+    return m_filePath;
+}
+
+void TextExpansionStore::ensureLoaded()
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+
+    // Watch the directory too, so that a store created or atomically replaced
+    // later on is noticed.
+    const QString directory = QFileInfo(m_filePath).absolutePath();
+    QDir().mkpath(directory);
+    m_watcher.addPath(directory);
+    if (QFile::exists(m_filePath)) {
+        m_watcher.addPath(m_filePath);
+    }
+
+    scheduleRead(true);
+}
+
+bool TextExpansionStore::addExpansion(const QString &abbreviation, const QString &expansion)
+{
+    if (abbreviation.isEmpty()) {
+        return false;
+    }
+    return appendRecord(m_filePath, addRecord(abbreviation, expansion));
+}
+
+bool TextExpansionStore::removeExpansion(const QString &abbreviation)
+{
+    if (abbreviation.isEmpty()) {
+        return false;
+    }
+    return appendRecord(m_filePath, '-' + escape(abbreviation) + '\n');
+}
+
+TextExpansionStore::FileIdentity TextExpansionStore::identityOf(const QFile &file)
+{
+    struct stat info;
+    if (fstat(file.handle(), &info) != 0) {
+        return {};
+    }
+    return {quint64(info.st_dev), quint64(info.st_ino)};
+}
+
+TextExpansionStore::ReadResult TextExpansionStore::readRecords(const QString &filePath, qint64 offset, const FileIdentity &identity)
+{
+    ReadResult result;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        // A missing store is simply empty.
+        result.fromStart = true;
+        return result;
+    }
+    result.identity = identityOf(file);
+
+    // A store that was replaced or shrank was rewritten rather than appended to.
+    if (offset > 0 && (result.identity != identity || file.size() < offset)) {
+        offset = 0;
+    }
+    result.fromStart = offset == 0;
+    file.seek(offset);
+    const QByteArray data = file.readAll();
+
+    // Leave a partially written last line for the next read.
+    const qsizetype end = data.lastIndexOf('\n') + 1;
+    result.endOffset = offset + end;
+    parseRecords(QByteArrayView(data).first(end), filePath, result.changes);
+
+    result.worthCompacting = result.fromStart && isWorthCompacting(result.changes, result.endOffset);
+    return result;
+}
+
+void TextExpansionStore::parseRecords(QByteArrayView lines, const QString &filePath, QList<Change> &changes)
+{
+    qsizetype lineStart = 0;
+    while (lineStart < lines.size()) {
+        const qsizetype lineEnd = lines.indexOf('\n', lineStart);
+        QByteArrayView line = lines.sliced(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        if (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        if (line.isEmpty() || line.front() == '#') {
+            continue;
+        }
+
+        Change change;
+        if (line.front() == '+') {
+            const qsizetype separator = line.indexOf('\t');
+            if (separator < 0) {
+                qCWarning(PlasmaKeyboard) << "TextExpansionStore: Ignoring record without expansion in" << filePath;
+                continue;
+            }
+            change.abbreviation = unescape(line.sliced(1, separator - 1));
+            change.expansion = unescape(line.sliced(separator + 1));
+        } else if (line.front() == '-') {
+            change.abbreviation = unescape(line.sliced(1));
+            change.removed = true;
+        } else {
+            qCWarning(PlasmaKeyboard) << "TextExpansionStore: Ignoring malformed record in" << filePath;
+            continue;
+        }
+
+        if (!change.abbreviation.isEmpty()) {
+            changes.append(std::move(change));
+        }
+    }
+}
+
+void TextExpansionStore::compact()
+{
+    QThreadPool::globalInstance()->start([filePath = m_filePath] {
+        compactFile(filePath);
+    });
+}
+
+void TextExpansionStore::compactFile(const QString &filePath)
+{
+    const StoreLock lock(filePath);
+    if (!lock.isLocked()) {
+        qCWarning(PlasmaKeyboard) << "TextExpansionStore: Not compacting" << filePath << "without the store lock";
+        return;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QByteArray data = file.readAll();
+    file.close();
+
+    // A record still being written by a tool that does not take the lock.
+    if (!data.isEmpty() && !data.endsWith('\n')) {
+        return;
+    }
+
+    QList<Change> changes;
+    parseRecords(data, filePath, changes);
+    if (!isWorthCompacting(changes, data.size())) {
+        // Already compacted, e.g. by a compaction requested earlier.
+        return;
+    }
+
+    const QList<Change> live = liveChanges(changes);
+    QByteArray compacted;
+    compacted.reserve(data.size());
+    for (const Change &change : live) {
+        compacted += addRecord(change.abbreviation, change.expansion);
+    }
+
+    QSaveFile saveFile(filePath);
+    if (!saveFile.open(QIODevice::WriteOnly) || saveFile.write(compacted) != compacted.size() || !saveFile.commit()) {
+        qCWarning(PlasmaKeyboard) << "TextExpansionStore: Could not compact" << filePath << saveFile.errorString();
+        return;
+    }
+
+    qCDebug(PlasmaKeyboard) << "TextExpansionStore: Compacted" << changes.size() << "records into" << live.size() << "in" << filePath;
+}
+
+bool TextExpansionStore::appendRecord(const QString &filePath, const QByteArray &record)
+{
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+
+    // Without the lock the record is still appended; only a concurrent
+    // compaction could then drop it.
+    const StoreLock lock(filePath);
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append) || file.write(record) != record.size()) {
+        qCWarning(PlasmaKeyboard) << "TextExpansionStore: Could not write to" << filePath << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void TextExpansionStore::scheduleRead(bool fromStart)
+{
+    if (m_readInFlight) {
+        m_readPending = true;
+        m_pendingReadFromStart = m_pendingReadFromStart || fromStart;
+        return;
+    }
+    m_readInFlight = true;
+
+    // Parse on a worker thread; the continuation runs back on this object's
+    // thread and is dropped if the store is destroyed in the meantime.
+    auto promise = std::make_shared<QPromise<ReadResult>>();
+    QFuture<ReadResult> future = promise->future();
+    promise->start();
+    QThreadPool::globalInstance()->start([promise, filePath = m_filePath, offset = fromStart ? 0 : m_readOffset, identity = m_readIdentity] {
+        promise->addResult(readRecords(filePath, offset, identity));
+        promise->finish();
+    });
+    future.then(this, [this](const ReadResult &result) {
+        handleReadFinished(result);
+    });
+}
+
+void TextExpansionStore::handleReadFinished(const ReadResult &result)
+{
+    m_readInFlight = false;
+
+    if (result.fromStart) {
+        m_pendingChanges.clear();
+        m_pendingChangesOffset = 0;
+        Q_EMIT reset();
+    }
+    m_readOffset = result.endOffset;
+    m_readIdentity = result.identity;
+    m_pendingChanges.append(result.changes);
+
+    qCDebug(PlasmaKeyboard) << "TextExpansionStore: Read" << result.changes.size() << "records from" << m_filePath << (result.fromStart ? "(full)" : "(appended)");
+    deliverPendingChanges();
+
+    if (result.worthCompacting) {
+        compact();
+    }
+
+    if (m_readPending) {
+        m_readPending = false;
+        scheduleRead(std::exchange(m_pendingReadFromStart, false));
+    }
+}
+
+void TextExpansionStore::deliverPendingChanges()
+{
+    if (m_pendingChangesOffset >= m_pendingChanges.size()) {
+        return;
+    }
+
+    const qsizetype count = std::min(kDeliveryBatchSize, m_pendingChanges.size() - m_pendingChangesOffset);
+    const QList<Change> batch = m_pendingChanges.mid(m_pendingChangesOffset, count);
+    m_pendingChangesOffset += count;
+    if (m_pendingChangesOffset == m_pendingChanges.size()) {
+        m_pendingChanges.clear();
+        m_pendingChangesOffset = 0;
+    } else {
+        // Yield to the event loop between batches so that large stores never
+        // hold up key handling.
+        QTimer::singleShot(0, this, &TextExpansionStore::deliverPendingChanges);
+    }
+
+    Q_EMIT changesLoaded(batch);
+}
+
+void TextExpansionStore::handleFileChanged()
+{
+    // Writers replacing the file atomically drop it from the watcher. Whether
+    // the file was replaced is up to readRecords(), which compares inodes.
+    if (!m_watcher.files().contains(m_filePath) && QFile::exists(m_filePath)) {
+        m_watcher.addPath(m_filePath);
+    }
+    scheduleRead(false);
+}
+
+void TextExpansionStore::handleDirectoryChanged()
+{
+    if (!m_watcher.files().contains(m_filePath) && QFile::exists(m_filePath)) {
+        m_watcher.addPath(m_filePath);
+        scheduleRead(false);
+    }
+}
+
+#include "moc_textexpansionstore.cpp"
@@ -0,0 +1,166 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QFileSystemWatcher>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+class QFile;
+
+/**
+ * On-disk store of text expansion snippets.
+ *
+ * Snippets live in an append-only UTF-8 file, by default
+ * "plasma/keyboard/textexpansions" under GenericDataLocation, with one record
+ * per line:
+ *
+ *     +<abbreviation>\t<expansion>
+ *     -<abbreviation>
+ *
+ * where "+" adds or replaces a snippet and "-" removes one. Backslash escapes
+ * (\\, \t, \n) may be used in both fields, and lines starting with "#" are
+ * ignored. Later records win, so editing a snippet is a matter of appending a
+ * line; tools that want to compact the file rewrite it atomically.
+ *
+ * Nothing is read until ensureLoaded() is called. Files are parsed on a worker
+ * thread and the resulting changes are handed out in bounded batches from the
+ * event loop, so even very large stores never stall key handling. Once loaded
+ * the file is watched: appended records are read incrementally from the last
+ * consumed offset, and only a replaced (different inode) or truncated file is
+ * reparsed from the start.
+ *
+ * Writers serialize on an advisory flock() of "<store>.lock", which survives
+ * the store itself being replaced. Once a full read finds a large store in
+ * which many records were superseded by later ones, compact() rewrites it
+ * under that lock.
+ */
+class TextExpansionStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * One record of the store.
+     */
+    struct Change {
+        QString abbreviation;
+        /** The expansion; unused for removals. */
+        QString expansion;
+        bool removed = false;
+    };
+
+    explicit TextExpansionStore(const QString &filePath, QObject *parent = nullptr);
+    ~TextExpansionStore() override = default;
+
+    /**
+     * Default location of the store under GenericDataLocation.
+     */
+    static QString defaultFilePath();
+
+    QString filePath() const;
+
+    /**
+     * Start loading the store and watching it for changes, unless already done.
+     *
+     * Returns immediately; snippets arrive through changesLoaded().
+     */
+    void ensureLoaded();
+
+    /**
+     * Append a record adding or replacing @p abbreviation.
+     *
+     * The change is picked up through the file watcher like any other append.
+     *
+     * @return Whether the record was written.
+     */
+    bool addExpansion(const QString &abbreviation, const QString &expansion);
+
+    /**
+     * Append a record removing @p abbreviation.
+     *
+     * @return Whether the record was written.
+     */
+    bool removeExpansion(const QString &abbreviation);
+
+    /**
+     * Atomically rewrite the store in the background with one "+" record per
+     * snippet, dropping superseded records and comments.
+     *
+     * The rewrite holds the store lock from reading the file until it is
+     * replaced, so records appended by addExpansion(), removeExpansion() or
+     * other writers taking the lock are never lost. The new file is picked up
+     * through the file watcher.
+     */
+    void compact();
+
+Q_SIGNALS:
+    /**
+     * Previously delivered snippets are no longer valid because the file is
+     * being reparsed from the start. The current contents follow through
+     * changesLoaded().
+     */
+    void reset();
+
+    /**
+     * A batch of records, in file order.
+     */
+    void changesLoaded(const QList<TextExpansionStore::Change> &changes);
+
+private:
+    /** Tells a file apart from one that replaced it at the same path. */
+    struct FileIdentity {
+        quint64 device = 0;
+        quint64 inode = 0;
+
+        bool operator==(const FileIdentity &other) const = default;
+    };
+
+    struct ReadResult {
+        QList<Change> changes;
+        /** Offset just past the last complete line that was consumed. */
+        qint64 endOffset = 0;
+        /** The file the offset refers to. */
+        FileIdentity identity;
+        bool fromStart = false;
+        /** A full read found enough superseded records to compact the store. */
+        bool worthCompacting = false;
+    };
+
+    /**
+     * Read the records from @p offset on, or from the start if the file is no
+     * longer the one identified by @p identity or shrank below @p offset.
+     */
+    static ReadResult readRecords(const QString &filePath, qint64 offset, const FileIdentity &identity);
+    static void parseRecords(QByteArrayView lines, const QString &filePath, QList<Change> &changes);
+    static FileIdentity identityOf(const QFile &file);
+    static void compactFile(const QString &filePath);
+    static bool appendRecord(const QString &filePath, const QByteArray &record);
+
+    void scheduleRead(bool fromStart);
+    void handleReadFinished(const ReadResult &result);
+    void deliverPendingChanges();
+    void handleFileChanged();
+    void handleDirectoryChanged();
+
+    QString m_filePath;
+    QFileSystemWatcher m_watcher;
+    bool m_loaded = false;
+
+    /** Offset up to which the file identified by m_readIdentity has been consumed. */
+    qint64 m_readOffset = 0;
+    FileIdentity m_readIdentity;
+    bool m_readInFlight = false;
+    /** Another read was requested while one was in flight. */
+    bool m_readPending = false;
+    bool m_pendingReadFromStart = false;
+
+    /** Changes read but not delivered yet, starting at m_pendingChangesOffset. */
+    QList<Change> m_pendingChanges;
+    qsizetype m_pendingChangesOffset = 0;
+};
@@ -8,13 +8,18 @@
 
 #include "logging.h"
 #include "overlaycontroller.h"
+#include "plasmakeyboardsettings.h"
 
 #include <KLocalizedString>
 
 TextExpansionTrigger::TextExpansionTrigger(QObject *parent)
     : OverlayTrigger(parent)
+    , m_store(new TextExpansionStore(TextExpansionStore::defaultFilePath(), this))
 {
-    // TODO: Load expansions from settings
+    connect(PlasmaKeyboardSettings::self(), &PlasmaKeyboardSettings::textExpansionEnabledChanged, this, &OverlayTrigger::subscriptionsChanged);
+
+    connect(m_store, &TextExpansionStore::reset, this, &TextExpansionTrigger::clearExpansions);
+    connect(m_store, &TextExpansionStore::changesLoaded, this, &TextExpansionTrigger::applyStoreChanges);
 }
 
 QString TextExpansionTrigger::triggerId() const
@@ -29,13 +34,16 @@ QString TextExpansionTrigger::displayName() const
 
 // clang-format off
 OverlayTriggerResult TextExpansionTrigger::processEvent(OverlayInputEvent eventType,
-                                                              const QKeyEvent *keyEvent,
+                                                              const KeyRecord *key,
                                                               const QString &text,
                                                               OverlayController *controller)
 // clang-format on
 {
     Q_UNUSED(controller)
 
+    // Snippets are only read once the trigger is actually in use.
+    m_store->ensureLoaded();
+
     OverlayTriggerResult result;
 
     switch (eventType) {
@@ -59,7 +67,7 @@ OverlayTriggerResult TextExpansionTrigger::processEvent(OverlayInputEvent eventT
     }
 
     case OverlayInputEvent::KeyPress: {
-        if (!m_pendingAbbreviation.isEmpty() && keyEvent && keyEvent->key() == m_triggerKey) {
+        if (!m_pendingAbbreviation.isEmpty() && key && key->qtKey == m_triggerKey) {
             // Trigger key pressed, expand
             result.action = OverlayAction::ReplaceText;
             result.deleteBeforeCursor = m_pendingAbbreviation.length();
@@ -91,9 +99,19 @@ void TextExpansionTrigger::reset()
 
 bool TextExpansionTrigger::isEnabled() const
 {
-    // TODO: Add setting for text expansion
-    // return PlasmaKeyboardSettings::self()->textExpansionEnabled();
-    return false; // Disabled until expansion data is implemented
+    return PlasmaKeyboardSettings::self()->textExpansionEnabled();
+}
+
+QList<OverlayInputEvent> TextExpansionTrigger::subscribedEvents() const
+{
+    return {OverlayInputEvent::KeyPress, OverlayInputEvent::TextCommitted};
+}
+
+bool TextExpansionTrigger::wantsTextlessKeys() const
+{
+    // Any other key cancels a pending expansion, and the trigger key may be
+    // one without text.
+    return !m_pendingAbbreviation.isEmpty();
 }
 
 QStringList TextExpansionTrigger::candidates(const QString &baseText) const
@@ -104,14 +122,42 @@ QStringList TextExpansionTrigger::candidates(const QString &baseText) const
     return {};
 }
 
+TextExpansionStore *TextExpansionTrigger::store() const
+{
+    return m_store;
+}
+
 void TextExpansionTrigger::addExpansion(const QString &abbreviation, const QString &expansion)
 {
     m_expansions.insert(abbreviation, expansion);
+    m_abbreviations.insert(abbreviation);
 }
 
 void TextExpansionTrigger::removeExpansion(const QString &abbreviation)
 {
     m_expansions.remove(abbreviation);
+    m_abbreviations.remove(abbreviation);
+    if (m_pendingAbbreviation == abbreviation) {
+        m_pendingAbbreviation.clear();
+    }
+}
+
+void TextExpansionTrigger::clearExpansions()
+{
+    m_expansions.clear();
+    m_abbreviations.clear();
+    m_pendingAbbreviation.clear();
+}
+
+void TextExpansionTrigger::applyStoreChanges(const QList<TextExpansionStore::Change> &changes)
+{
+    for (const TextExpansionStore::Change &change : changes) {
+        if (change.removed) {
+            removeExpansion(change.abbreviation);
+        } else {
+            addExpansion(change.abbreviation, change.expansion);
+        }
+    }
 }
 
 void TextExpansionTrigger::setRequiresTriggerKey(bool value)
@@ -136,24 +182,13 @@ Qt::Key TextExpansionTrigger::triggerKey() const
 
 QString TextExpansionTrigger::findMatchingAbbreviation(const QString &text) const
 {
-    // Check if text ends with any known abbreviation
-    // We check longest matches first for proper precedence
-    QList<QString> abbrevs = m_expansions.keys();
-    std::sort(abbrevs.begin(), abbrevs.end(), [](const QString &a, const QString &b) {
-        return a.length() > b.length();
-    });
-
-    for (const auto &abbrev : abbrevs) {
-        if (text.endsWith(abbrev)) {
-            // Ensure it's a word boundary (start of string or preceded by space)
-            const int pos = text.length() - abbrev.length();
-            if (pos == 0 || text.at(pos - 1).isSpace()) {
-                return abbrev;
-            }
-        }
+    // The trie walks the text backwards once, so the cost depends on the
+    // abbreviation length rather than on the number of expansions.
+    const qsizetype length = m_abbreviations.longestMatch(text);
+    if (length == 0) {
+        return {};
     }
-
-    return {};
+    return text.right(length);
 }
 
 #include "moc_textexpansiontrigger.cpp"
@@ -6,7 +6,9 @@
 
 #pragma once
 
+#include "abbreviationtrie.h"
 #include "overlaytrigger.h"
+#include "textexpansionstore.h"
 
 #include <QHash>
 
@@ -17,7 +19,8 @@
  * with expansion text. Optionally requires a trigger character (e.g., Tab)
  * to confirm expansion.
  *
- * This is a stub implementation; snippet storage will be added later.
+ * Snippets come from a TextExpansionStore, which is loaded on the first event
+ * the trigger sees and kept in sync with the file afterwards.
  */
 class TextExpansionTrigger : public OverlayTrigger
 {
@@ -32,15 +35,22 @@ public:
 
     // clang-format off
     OverlayTriggerResult processEvent(OverlayInputEvent eventType,
-                                            const QKeyEvent *keyEvent,
+                                            const KeyRecord *key,
                                             const QString &text,
                                             OverlayController *controller) override;
     // clang-format on
 
     void reset() override;
     bool isEnabled() const override;
+    QList<OverlayInputEvent> subscribedEvents() const override;
+    bool wantsTextlessKeys() const override;
     QStringList candidates(const QString &baseText) const override;
 
+    /**
+     * The snippet store backing this trigger.
+     */
+    TextExpansionStore *store() const;
+
     /**
      * Add an expansion rule.
      *
@@ -54,6 +64,11 @@ public:
      */
     void removeExpansion(const QString &abbreviation);
 
+    /**
+     * Remove all expansion rules.
+     */
+    void clearExpansions();
+
     /**
      * Set whether a trigger key is required to confirm expansion.
      */
@@ -69,10 +84,19 @@ public:
 private:
     /**
      * Check if the text ends with any known abbreviation.
+     *
+     * Returns the longest abbreviation that starts on a word boundary.
      */
     QString findMatchingAbbreviation(const QString &text) const;
 
+    void applyStoreChanges(const QList<TextExpansionStore::Change> &changes);
+
+    TextExpansionStore *m_store = nullptr;
+
     QHash<QString, QString> m_expansions;
+
+    /** The keys of m_expansions, indexed for suffix matching. */
+    AbbreviationTrie m_abbreviations;
     bool m_requiresTriggerKey = true;
     Qt::Key m_triggerKey = Qt::Key_Tab;
     QString m_pendingAbbreviation;
@@ -0,0 +1,177 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+pragma ComponentBehavior: Bound
+
+import QtQuick
+
+import org.kde.kirigami as Kirigami
+import org.kde.plasma.components as PlasmaComponents
+
+/*!
+The contents of an overlay that lists the emoji matching the query typed after the prefix.
+*/
+Item {
+    id: root
+
+    /*!
+    The candidates to list, usually the overlay controller's candidate model.
+    */
+    property alias model: list.model
+
+    /*!
+    The typed prefix and query the candidates match, shown in front of them.
+    */
+    property string typedText: ""
+
+    property int selectedIndex: -1
+
+    signal candidateSelected(int index)
+
+    // Handle arrow keys to navigate candidates and Enter to select, as in DiacriticsOverlay.
+    //
+    // The first key press after the overlay opens selects the first candidate. Enter without
+    // a selection picks the first candidate, which is the best match.
+    function handleNavigationKey(key) {
+        switch (key) {
+        case Qt.Key_Right:
+            if (root.selectedIndex === -1) {
+                root.selectedIndex = 0;
+            } else if (root.selectedIndex < list.count - 1) {
+                root.selectedIndex++;
+            }
+            break;
+        case Qt.Key_Left:
+            if (root.selectedIndex === -1) {
+                root.selectedIndex = 0;
+            } else if (root.selectedIndex > 0) {
+                root.selectedIndex--;
+            }
+            break;
+        case Qt.Key_Up:
+            root.selectedIndex = 0;
+            break;
+        case Qt.Key_Down:
+            root.selectedIndex = list.count - 1;
+            break;
+        case Qt.Key_Return:
+            if (list.count > 0) {
+                root.candidateSelected(Math.max(root.selectedIndex, 0));
+            }
+            break;
+        }
+    }
+
+    implicitWidth: background.implicitWidth
+    implicitHeight: background.implicitHeight
+
+    // The candidates change with every character typed into the query.
+    Connections {
+        target: root.model
+        function onModelReset() {
+            root.selectedIndex = -1;
+        }
+    }
+
+    Rectangle {
+        id: background
+        anchors.centerIn: parent
+        radius: Kirigami.Units.smallSpacing
+        color: Kirigami.Theme.backgroundColor
+        border.color: Kirigami.Theme.activeBackgroundColor
+        border.width: 1
+
+        property int inset: Kirigami.Units.smallSpacing
+
+        implicitWidth: queryLabel.implicitWidth + list.implicitWidth + inset * 3
+        implicitHeight: Math.max(queryLabel.implicitHeight, list.implicitHeight) + inset * 2
+
+        Text {
+            id: queryLabel
+            anchors {
+                left: parent.left
+                leftMargin: background.inset
+                verticalCenter: parent.verticalCenter
+            }
+            text: root.typedText
+            color: Kirigami.Theme.disabledTextColor
+        }
+
+        ListView {
+            id: list
+            anchors {
+                left: queryLabel.right
+                leftMargin: background.inset
+                verticalCenter: parent.verticalCenter
+            }
+
+            // Show up to nine candidates, the ones with a number key, and scroll to the rest.
+            readonly property int visibleCount: Math.min(count, 9)
+            readonly property real delegateWidth: Kirigami.Units.gridUnit * 2 + Kirigami.Units.smallSpacing * 2
+
+            implicitWidth: Math.max(visibleCount, 1) * delegateWidth + Math.max(visibleCount - 1, 0) * spacing
+            implicitHeight: Kirigami.Units.gridUnit * 3
+            width: implicitWidth
+            height: implicitHeight
+
+            orientation: ListView.Horizontal
+            spacing: Kirigami.Units.smallSpacing
+            clip: true
+            boundsBehavior: Flickable.StopAtBounds
+            currentIndex: root.selectedIndex
+            highlightFollowsCurrentItem: false
+
+            onCurrentIndexChanged: {
+                if (currentIndex >= 0) {
+                    positionViewAtIndex(currentIndex, ListView.Contain);
+                }
+            }
+
+            delegate: PlasmaComponents.Button {
+                id: delegate
+
+                required property string display
+                required property string description
+                required property int index
+
+                width: list.delegateWidth
+                height: list.height
+                flat: true
+                padding: Kirigami.Units.smallSpacing
+
+                // Highlight the selected index (if any) to provide visual feedback when
+                // navigating with arrow keys.
+                down: delegate.index === root.selectedIndex
+
+                PlasmaComponents.ToolTip.text: delegate.description
+                PlasmaComponents.ToolTip.visible: delegate.hovered && delegate.description.length > 0
+
+                onClicked: root.candidateSelected(delegate.index)
+
+                contentItem: Column {
+                    spacing: Kirigami.Units.smallSpacing
+
+                    Text {
+                        text: delegate.display
+                        font.pointSize: Kirigami.Theme.defaultFont.pointSize * 1.4
+                        anchors.horizontalCenter: parent.horizontalCenter
+                        color: Kirigami.Theme.textColor
+                    }
+
+                    Text {
+                        // Only the first 9 candidates have a number key (1–9); the others keep
+                        // the same layout.
+                        opacity: delegate.index < 9 ? 1 : 0
+                        text: delegate.index + 1
+                        font.pointSize: Kirigami.Theme.smallFont.pointSize
+                        color: Kirigami.Theme.disabledTextColor
+                        anchors.horizontalCenter: parent.horizontalCenter
+                    }
+                }
+            }
+        }
+    }
+}
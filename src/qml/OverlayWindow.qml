@@ -136,17 +136,14 @@ InputPanelWindow {
         }
     }
 
-    // Emoji view component (stub)
+    // Emoji view component
     Component {
         id: emojiViewComponent
-        Item {
-            implicitWidth: 200
-            implicitHeight: 200
-            // TODO: Implement emoji list view
-            Text {
-                anchors.centerIn: parent
-                text: "Emoji picker (not implemented)"
-            }
+        EmojiOverlay {
+            model: root.controller.candidateModel
+            typedText: root.controller.pendingText
+
+            onCandidateSelected: index => root.candidateSelected(index)
         }
     }
 
@@ -20,34 +20,41 @@ InputPanelWindow {
     width: Screen.width
     color: 'transparent'
 
+    // With lazyPanelEnabled, the keyboard panel is only created once it is
+    // first asked to show. It is kept from then on, as it is asked to show
+    // again on every activation.
+    property bool panelRequested: false
+
     onVisibleChanged: {
-        if (!visible) {
+        if (!visible && panelLoader.item) {
             // Reset keyboard navigation when hidden
             // Note: keyboard property is internal Qt API
-            if (inputPanel.keyboard.navigationModeActive) {
-                inputPanel.keyboard.navigationModeActive = false;
+            if (panelLoader.item.keyboard.navigationModeActive) {
+                panelLoader.item.keyboard.navigationModeActive = false;
             }
 
             // Close language dialog
-            languageDialog.close();
+            panelLoader.item.closeLanguageDialog();
         }
     }
 
     InputListenerItem {
         id: thing
         focus: true
-        engine: inputPanel.InputContext.inputEngine
+        engine: InputContext.inputEngine
+
+        keyboardNavigationActive: panelLoader.item ? panelLoader.item.keyboard.navigationModeActive : false
 
-        keyboardNavigationActive: inputPanel.keyboard.navigationModeActive
+        onInputPanelRequested: root.panelRequested = true
 
         onKeyNavigationPressed: (key) => {
             // HACK: invoke the Qt VirtualKeyboard keyboard navigation feature ourselves
             // See https://github.com/qt/qtvirtualkeyboard/blob/6d810ac41df96f1ad984f56e17f16860bec2abbf/src/virtualkeyboard/qvirtualkeyboardinputcontext_p.h#L110
-            inputPanel.InputContext.priv.navigationKeyPressed(key, false);
+            InputContext.priv.navigationKeyPressed(key, false);
         }
         onKeyNavigationReleased: (key) => {
             // HACK: invoke the Qt VirtualKeyboard keyboard navigation feature ourselves
-            inputPanel.InputContext.priv.navigationKeyReleased(key, false);
+            InputContext.priv.navigationKeyReleased(key, false);
         }
     }
 
@@ -63,17 +70,10 @@ InputPanelWindow {
     Kirigami.ShadowedRectangle {
         id: panelWrapper
 
-        LanguagePopup {
-            id: languageDialog
-            style: inputPanel.keyboard.style
-            keyboardPanel: inputPanel
-
-            onShowSettings: root.showSettings()
-        }
-
         // Whether the panel takes the full width of the screen
         readonly property bool isFullScreenWidth: PlasmaKeyboardSettings.panelFillScreenWidth
 
+        visible: panelLoader.item !== null
         color: PlasmaKeyboard.BreezeConstants.keyboardBackgroundColor
 
         // Provide shadow and radius when the keyboard is detached from edges
@@ -97,11 +97,11 @@ InputPanelWindow {
         readonly property real padding: isFullScreenWidth ? 0 : Kirigami.Units.largeSpacing
 
         // Never let width & height to be 0, otherwise it can cause problems for setting interactiveRegion
-        width: inputPanel.width > 0 ? (inputPanel.width + padding * 2) : 100
-        height: inputPanel.height > 0 ? (inputPanel.height + padding * 2) : 100
+        width: panelLoader.width > 0 ? (panelLoader.width + padding * 2) : 100
+        height: panelLoader.height > 0 ? (panelLoader.height + padding * 2) : 100
 
-        InputPanel {
-            id: inputPanel
+        Loader {
+            id: panelLoader
             anchors {
                 top: parent.top
                 topMargin: parent.padding
@@ -109,46 +109,76 @@ InputPanelWindow {
                 leftMargin: parent.padding
             }
 
-            // height is calculated by InputPanel
-            width: inputPanel.keyboard.style ? inputPanel.keyboard.style.aspectRatio * inputPanel.keyboard.style.targetKeyboardHeight : 0
+            active: !PlasmaKeyboardSettings.lazyPanelEnabled || root.panelRequested
 
-            focusPolicy: Qt.NoFocus
-            externalLanguageSwitchEnabled: true
-            onExternalLanguageSwitch: (localeList, currentIndex) => {
-                languageDialog.show(inputPanel.keyboard.activeKey, localeList, currentIndex)
-            }
+            sourceComponent: Item {
+                // Note: keyboard property is internal Qt API
+                readonly property alias keyboard: inputPanel.keyboard
 
-            function updateLocales() {
-                if (PlasmaKeyboardSettings.enabledLocales.length === 0) {
-                    // If there are no enabled locales, set it to the current locale
-                    // NOTE: If Qt.locale().name is not valid, then all keyboard layouts will be shown.
-                    let locale = Qt.locale().name;
-                    if (locale === "C") {
-                        locale = "en_US";
-                    }
-                    VirtualKeyboardSettings.activeLocales = [locale];
-                } else {
-                    VirtualKeyboardSettings.activeLocales = PlasmaKeyboardSettings.enabledLocales;
+                function closeLanguageDialog() {
+                    languageDialog.close();
                 }
-            }
 
-            Connections {
-                target: VirtualKeyboardSettings
-                function onAvailableLocalesChanged() {
-                    inputPanel.updateLocales();
-                }
-            }
+                width: inputPanel.width
+                height: inputPanel.height
 
-            Connections {
-                target: PlasmaKeyboardSettings
-                function onEnabledLocalesChanged() {
-                    inputPanel.updateLocales();
+                LanguagePopup {
+                    id: languageDialog
+                    style: inputPanel.keyboard.style
+                    keyboardPanel: inputPanel
+
+                    onShowSettings: root.showSettings()
                 }
-            }
 
-            Component.onCompleted: {
-                VirtualKeyboardSettings.styleName = "Breeze";
-                inputPanel.updateLocales();
+                InputPanel {
+                    id: inputPanel
+                    anchors {
+                        top: parent.top
+                        left: parent.left
+                    }
+
+                    // height is calculated by InputPanel
+                    width: inputPanel.keyboard.style ? inputPanel.keyboard.style.aspectRatio * inputPanel.keyboard.style.targetKeyboardHeight : 0
+
+                    focusPolicy: Qt.NoFocus
+                    externalLanguageSwitchEnabled: true
+                    onExternalLanguageSwitch: (localeList, currentIndex) => {
+                        languageDialog.show(inputPanel.keyboard.activeKey, localeList, currentIndex)
+                    }
+
+                    function updateLocales() {
+                        if (PlasmaKeyboardSettings.enabledLocales.length === 0) {
+                            // If there are no enabled locales, set it to the current locale
+                            // NOTE: If Qt.locale().name is not valid, then all keyboard layouts will be shown.
+                            let locale = Qt.locale().name;
+                            if (locale === "C") {
+                                locale = "en_US";
+                            }
+                            VirtualKeyboardSettings.activeLocales = [locale];
+                        } else {
+                            VirtualKeyboardSettings.activeLocales = PlasmaKeyboardSettings.enabledLocales;
+                        }
+                    }
+
+                    Connections {
+                        target: VirtualKeyboardSettings
+                        function onAvailableLocalesChanged() {
+                            inputPanel.updateLocales();
+                        }
+                    }
+
+                    Connections {
+                        target: PlasmaKeyboardSettings
+                        function onEnabledLocalesChanged() {
+                            inputPanel.updateLocales();
+                        }
+                    }
+
+                    Component.onCompleted: {
+                        VirtualKeyboardSettings.styleName = "Breeze";
+                        inputPanel.updateLocales();
+                    }
+                }
             }
         }
     }
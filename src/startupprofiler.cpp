@@ -0,0 +1,108 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "startupprofiler.h"
+
+#include "startuplogging.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+
+#include <cstring>
+
+namespace
+{
+
+struct Entry {
+    const char *name;
+    qint64 startNs;
+    /** -1 for milestones. */
+    qint64 durationNs;
+};
+
+struct State {
+    QMutex mutex;
+    QElapsedTimer clock;
+    QList<Entry> entries;
+    bool enabled = false;
+};
+
+Q_GLOBAL_STATIC(State, s_state)
+
+void logEntry(const Entry &entry)
+{
+    if (entry.durationNs < 0) {
+        qCInfo(PlasmaKeyboardStartup).nospace() << entry.name << " reached at " << entry.startNs / 1000 / 1000.0 << " ms";
+    } else {
+        qCInfo(PlasmaKeyboardStartup).nospace() << entry.name << ": " << entry.durationNs / 1000 / 1000.0 << " ms (from " << entry.startNs / 1000 / 1000.0
+                                                << " ms)";
+    }
+}
+
+qint64 elapsedNs(const State &state)
+{
+    return state.clock.isValid() ? state.clock.nsecsElapsed() : 0;
+}
+
+/// Called with the mutex held.
+void append(State &state, const Entry &entry)
+{
+    state.entries.append(entry);
+    if (state.enabled) {
+        logEntry(entry);
+    }
+}
+
+} // namespace
+
+void StartupProfiler::start()
+{
+    QMutexLocker locker(&s_state->mutex);
+    s_state->clock.start();
+}
+
+void StartupProfiler::setEnabled(bool enabled)
+{
+    State &state = *s_state;
+    QMutexLocker locker(&state.mutex);
+    if (state.enabled == enabled) {
+        return;
+    }
+    state.enabled = enabled;
+    if (enabled) {
+        qCInfo(PlasmaKeyboardStartup) << "Startup profiling enabled";
+        for (const Entry &entry : std::as_const(state.entries)) {
+            logEntry(entry);
+        }
+    }
+}
+
+void StartupProfiler::mark(const char *milestone)
+{
+    State &state = *s_state;
+    QMutexLocker locker(&state.mutex);
+    for (const Entry &entry : std::as_const(state.entries)) {
+        if (entry.durationNs < 0 && std::strcmp(entry.name, milestone) == 0) {
+            return;
+        }
+    }
+    append(state, {milestone, elapsedNs(state), -1});
+}
+
+StartupProfiler::Scope::Scope(const char *step)
+    : m_step(step)
+    , m_startNs(elapsedNs(*s_state))
+{
+}
+
+StartupProfiler::Scope::~Scope()
+{
+    State &state = *s_state;
+    const qint64 endNs = elapsedNs(state);
+    QMutexLocker locker(&state.mutex);
+    append(state, {m_step, m_startNs, endNs - m_startNs});
+}
@@ -0,0 +1,73 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QtGlobal>
+
+/**
+ * @file
+ *
+ * Wall-clock profile of the startup sequence.
+ *
+ * The expensive startup steps (layout path lookup, QML loading, input panel
+ * integration, diacritics and compose table loading) are timed with
+ * StartupProfiler::Scope, and milestones such as the first input method
+ * activation with StartupProfiler::mark(). Times are relative to the start of
+ * main().
+ *
+ * Steps are always recorded, since some of them run before the command line
+ * is parsed; they are only logged to the "org.kde.plasma.keyboard.startup"
+ * category once profiling is enabled with --profile-startup or
+ * PLASMA_KEYBOARD_PROFILE_STARTUP=1.
+ *
+ * Steps may be recorded from worker threads.
+ */
+class StartupProfiler
+{
+public:
+    /**
+     * Start the clock. Called first thing in main().
+     */
+    static void start();
+
+    /**
+     * Enable logging, including the steps recorded so far.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * Record that @p milestone was reached. Only the first time is kept.
+     *
+     * @param milestone A string literal naming the milestone.
+     */
+    static void mark(const char *milestone);
+
+    /**
+     * Times the step @p step from construction to destruction.
+     *
+     * @code
+     * {
+     *     StartupProfiler::Scope scope("QML engine load");
+     *     engine.load(url);
+     * }
+     * @endcode
+     */
+    class Scope
+    {
+    public:
+        /**
+         * @param step A string literal naming the step.
+         */
+        explicit Scope(const char *step);
+        ~Scope();
+
+    private:
+        Q_DISABLE_COPY_MOVE(Scope)
+        const char *m_step;
+        qint64 m_startNs;
+    };
+};
@@ -0,0 +1,120 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "surroundingtext.h"
+
+#include <algorithm>
+#include <utility>
+
+/// Distance between index checkpoints, in UTF-16 code units. Conversions walk
+/// at most this many characters past a checkpoint.
+static constexpr qsizetype kCheckpointStride = 64;
+
+/// UTF-16 code units and UTF-8 bytes taken by the character starting at @p i.
+static std::pair<qsizetype, qsizetype> characterAt(const QString &text, qsizetype i)
+{
+    const char16_t c = text.at(i).unicode();
+    if (c < 0x80) {
+        return {1, 1};
+    }
+    if (c < 0x800) {
+        return {1, 2};
+    }
+    if (QChar::isHighSurrogate(c) && i + 1 < text.size() && QChar::isLowSurrogate(text.at(i + 1).unicode())) {
+        return {2, 4};
+    }
+    // Everything else in the BMP; lone surrogates are encoded as U+FFFD.
+    return {1, 3};
+}
+
+void SurroundingText::setText(const QString &text)
+{
+    m_text = text;
+    m_checkpoints.clear();
+    m_indexed = false;
+    m_ascii = true;
+}
+
+qsizetype SurroundingText::toUtf16Offset(qsizetype utf8Offset) const
+{
+    ensureIndexed();
+    if (m_ascii) {
+        return std::clamp<qsizetype>(utf8Offset, 0, m_text.size());
+    }
+
+    const auto it = std::upper_bound(m_checkpoints.cbegin(), m_checkpoints.cend(), utf8Offset, [](qsizetype value, const Checkpoint &checkpoint) {
+        return value < qsizetype(checkpoint.utf8);
+    });
+    if (it == m_checkpoints.cbegin()) {
+        return 0;
+    }
+
+    qsizetype utf16 = std::prev(it)->utf16;
+    qsizetype utf8 = std::prev(it)->utf8;
+    while (utf16 < m_text.size()) {
+        const auto [units, bytes] = characterAt(m_text, utf16);
+        if (utf8 + bytes > utf8Offset) {
+            break;
+        }
+        utf16 += units;
+        utf8 += bytes;
+    }
+    return utf16;
+}
+
+qsizetype SurroundingText::toUtf8Offset(qsizetype utf16Offset) const
+{
+    ensureIndexed();
+    utf16Offset = std::clamp<qsizetype>(utf16Offset, 0, m_text.size());
+    if (m_ascii) {
+        return utf16Offset;
+    }
+
+    const auto it = std::upper_bound(m_checkpoints.cbegin(), m_checkpoints.cend(), utf16Offset, [](qsizetype value, const Checkpoint &checkpoint) {
+        return value < qsizetype(checkpoint.utf16);
+    });
+    Q_ASSERT(it != m_checkpoints.cbegin());
+
+    qsizetype utf16 = std::prev(it)->utf16;
+    qsizetype utf8 = std::prev(it)->utf8;
+    while (utf16 < utf16Offset) {
+        const auto [units, bytes] = characterAt(m_text, utf16);
+        if (utf16 + units > utf16Offset) {
+            break;
+        }
+        utf16 += units;
+        utf8 += bytes;
+    }
+    return utf8;
+}
+
+void SurroundingText::ensureIndexed() const
+{
+    if (m_indexed) {
+        return;
+    }
+    m_indexed = true;
+
+    m_ascii = std::all_of(m_text.cbegin(), m_text.cend(), [](QChar c) {
+        return c.unicode() < 0x80;
+    });
+    if (m_ascii) {
+        return;
+    }
+
+    m_checkpoints.reserve(m_text.size() / kCheckpointStride + 1);
+    qsizetype utf16 = 0;
+    qsizetype utf8 = 0;
+    while (utf16 < m_text.size()) {
+        // Checkpoints always sit on a character boundary, never inside a pair.
+        if (utf16 >= m_checkpoints.size() * kCheckpointStride) {
+            m_checkpoints.append({quint32(utf16), quint32(utf8)});
+        }
+        const auto [units, bytes] = characterAt(m_text, utf16);
+        utf16 += units;
+        utf8 += bytes;
+    }
+}
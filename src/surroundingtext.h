@@ -0,0 +1,68 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QList>
+#include <QString>
+
+/**
+ * Surrounding text of the focused text input, with UTF-8 offset conversion.
+ *
+ * The input-method protocol expresses every position as a UTF-8 byte offset,
+ * while Qt works in UTF-16 code units. Instead of re-encoding the text for
+ * each conversion, a sparse index of positions in both encodings is built
+ * once, on first use, and kept until the compositor sends a new text. A
+ * conversion then only walks the few characters after the nearest checkpoint.
+ *
+ * For pure ASCII text both encodings line up and the index stays empty.
+ */
+class SurroundingText
+{
+public:
+    /**
+     * Replace the text, dropping the offset index.
+     */
+    void setText(const QString &text);
+
+    const QString &text() const
+    {
+        return m_text;
+    }
+
+    /**
+     * Convert a UTF-8 byte offset to a UTF-16 offset into text().
+     *
+     * Offsets are clamped to the text; offsets inside a multi-byte sequence
+     * are rounded down to the start of that character.
+     */
+    qsizetype toUtf16Offset(qsizetype utf8Offset) const;
+
+    /**
+     * Convert a UTF-16 offset into text() to a UTF-8 byte offset.
+     *
+     * Offsets are clamped to the text; offsets between the two halves of a
+     * surrogate pair are rounded down to the start of the pair.
+     */
+    qsizetype toUtf8Offset(qsizetype utf16Offset) const;
+
+private:
+    /** A position on a character boundary, in both encodings. */
+    struct Checkpoint {
+        quint32 utf16;
+        quint32 utf8;
+    };
+
+    void ensureIndexed() const;
+
+    QString m_text;
+
+    /** One checkpoint about every kCheckpointStride UTF-16 code units. */
+    mutable QList<Checkpoint> m_checkpoints;
+    mutable bool m_indexed = false;
+    /** Every character is ASCII, so both encodings share offsets. */
+    mutable bool m_ascii = true;
+};
@@ -0,0 +1,147 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "xkbcache.h"
+
+#include "logging.h"
+#include "startupprofiler.h"
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QPromise>
+#include <QThreadPool>
+
+#include <QtGui/private/qxkbcommon_p.h>
+
+#include <clocale>
+
+/// Compiled or compiling compose tables, keyed by locale.
+using ComposeTableMap = QHash<QByteArray, QFuture<ComposeTablePtr>>;
+Q_GLOBAL_STATIC(ComposeTableMap, s_composeTables)
+
+/// Number of compiled keymaps kept around, enough for switching between a
+/// few layouts without recompiling.
+static constexpr qsizetype kMaxCachedKeymaps = 4;
+
+struct CachedKeymap {
+    /// SHA-1 of the keymap text, so that distinct keymaps never share an entry.
+    QByteArray digest;
+    KeymapPtr keymap;
+};
+
+struct KeymapCache {
+    KeymapCache()
+        : context(xkb_context_new(XKB_CONTEXT_NO_FLAGS), xkb_context_unref)
+    {
+    }
+
+    std::unique_ptr<xkb_context, decltype(&xkb_context_unref)> context;
+
+    /// Most recently used first.
+    QList<CachedKeymap> keymaps;
+
+    /// The grabbed keyboard may be dispatched on the input thread.
+    QMutex mutex;
+};
+
+/// Compiled keymaps.
+Q_GLOBAL_STATIC(KeymapCache, s_keymapCache)
+
+static ComposeTablePtr compileComposeTable(const QByteArray &locale)
+{
+    StartupProfiler::Scope scope("XKB compose table compilation");
+    QElapsedTimer timer;
+    timer.start();
+
+    // xkb_context is not thread-safe, so every compilation gets its own; the
+    // table keeps a reference to it for as long as it lives.
+    xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+    if (!context) {
+        return {};
+    }
+    xkb_compose_table *table = xkb_compose_table_new_from_locale(context, locale.constData(), XKB_COMPOSE_COMPILE_NO_FLAGS);
+    xkb_context_unref(context);
+
+    if (!table) {
+        qCDebug(PlasmaKeyboard) << "XkbCache: No compose table for locale" << locale;
+        return {};
+    }
+    qCDebug(PlasmaKeyboard) << "XkbCache: Compiled compose table for locale" << locale << "in" << timer.elapsed() << "ms";
+    return ComposeTablePtr(table, xkb_compose_table_unref);
+}
+
+QByteArray XkbCache::composeLocale()
+{
+    const char *locale = setlocale(LC_CTYPE, nullptr);
+    if (!locale || locale[0] == '\0') {
+        return QByteArrayLiteral("C");
+    }
+    return QByteArray(locale);
+}
+
+void XkbCache::precompileComposeTable(const QByteArray &locale)
+{
+    composeTable(locale);
+}
+
+QFuture<ComposeTablePtr> XkbCache::composeTable(const QByteArray &locale)
+{
+    const auto it = s_composeTables->constFind(locale);
+    if (it != s_composeTables->cend()) {
+        return it.value();
+    }
+
+    auto promise = std::make_shared<QPromise<ComposeTablePtr>>();
+    QFuture<ComposeTablePtr> future = promise->future();
+    promise->start();
+    QThreadPool::globalInstance()->start([promise, locale] {
+        promise->addResult(compileComposeTable(locale));
+        promise->finish();
+    });
+
+    s_composeTables->insert(locale, future);
+    return future;
+}
+
+KeymapPtr XkbCache::keymap(QByteArrayView text)
+{
+    if (text.endsWith('\0')) {
+        text.chop(1);
+    }
+    const QByteArray digest = QCryptographicHash::hash(text, QCryptographicHash::Sha1);
+
+    QMutexLocker locker(&s_keymapCache->mutex);
+    QList<CachedKeymap> &keymaps = s_keymapCache->keymaps;
+    for (qsizetype i = 0; i < keymaps.size(); ++i) {
+        if (keymaps.at(i).digest == digest) {
+            keymaps.move(i, 0);
+            return keymaps.constFirst().keymap;
+        }
+    }
+
+    if (!s_keymapCache->context) {
+        return {};
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    xkb_keymap *keymap = xkb_keymap_new_from_string(s_keymapCache->context.get(), text.data(), XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    if (!keymap) {
+        qCWarning(PlasmaKeyboard) << "XkbCache: Failed to compile keymap of" << text.size() << "bytes";
+        return {};
+    }
+    QXkbCommon::verifyHasLatinLayout(keymap);
+    qCDebug(PlasmaKeyboard) << "XkbCache: Compiled keymap of" << text.size() << "bytes in" << timer.elapsed() << "ms";
+
+    if (keymaps.size() >= kMaxCachedKeymaps) {
+        keymaps.removeLast();
+    }
+    keymaps.prepend({digest, KeymapPtr(keymap, xkb_keymap_unref)});
+    return keymaps.constFirst().keymap;
+}
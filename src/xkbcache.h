@@ -0,0 +1,68 @@
+/*
+    SPDX-FileCopyrightText: 2026 KDE contributors
+
+    SPDX-License-Identifier: GPL-2.0-only OR GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFuture>
+
+#include <memory>
+
+#include <xkbcommon/xkbcommon-compose.h>
+#include <xkbcommon/xkbcommon.h>
+
+using ComposeTablePtr = std::shared_ptr<xkb_compose_table>;
+using KeymapPtr = std::shared_ptr<xkb_keymap>;
+
+/**
+ * Process-wide cache of compiled XKB data.
+ *
+ * Compiling a compose table parses the locale's Compose file and its includes,
+ * which takes tens of milliseconds for large locales. Tables are compiled once
+ * per locale on a worker thread and shared by everything that needs them.
+ *
+ * Keymaps are sent by the compositor as text every time the keyboard is
+ * grabbed, i.e. after every focus change, but rarely differ. The last few
+ * compiled keymaps are kept, keyed by the SHA-1 of that text.
+ *
+ * Compose tables must only be requested from the main thread; the worker
+ * threads only compile. keymap() may be called from any thread.
+ */
+class XkbCache
+{
+public:
+    /**
+     * The locale compose tables should currently be compiled for (LC_CTYPE).
+     */
+    static QByteArray composeLocale();
+
+    /**
+     * Start compiling the compose table for @p locale in the background, so
+     * that it is ready by the time the first key is pressed.
+     */
+    static void precompileComposeTable(const QByteArray &locale);
+
+    /**
+     * The compose table for @p locale.
+     *
+     * The future is already finished if the table was compiled before;
+     * otherwise it finishes once the worker thread is done. It yields a null
+     * table if there is no compose file for the locale.
+     */
+    static QFuture<ComposeTablePtr> composeTable(const QByteArray &locale);
+
+    /**
+     * The compiled keymap for the keymap text @p text, compiling it if it is
+     * not cached yet.
+     *
+     * @p text must be NUL-terminated, as the wl_keyboard keymap is; the
+     * terminator may or may not be included in the view.
+     *
+     * @return The keymap, or null if it does not compile.
+     */
+    static KeymapPtr keymap(QByteArrayView text);
+};